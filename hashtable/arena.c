@@ -0,0 +1,306 @@
+/*
+ * Alokátor prvků tabulky s rozptýlenými položkami
+ *
+ * Prvky a klíče tabulky se přidělují z velkých bloků paměti posunem
+ * ukazatele. Uvolněné bloky se řadí do seznamů podle velikostní třídy a
+ * přednostně se použijí pro další alokace stejné velikosti. Uvolnění celé
+ * arény vrací systému jen bloky, nikoli jednotlivé prvky.
+ */
+
+#include "arena.h"
+#include "parallel.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Zaokrouhlení velikosti nahoru na násobek HT_ARENA_ALIGN
+#define HT_ARENA_ROUND(size)                                                   \
+  (((size) + HT_ARENA_ALIGN - 1) & ~(size_t)(HT_ARENA_ALIGN - 1))
+
+// Velikost hlavičky bloku zaokrouhlená tak, aby data zůstala zarovnaná
+#define HT_ARENA_HEADER HT_ARENA_ROUND(sizeof(ht_arena_chunk_t))
+
+/*
+ * Inicializace prázdné arény.
+ */
+void ht_arena_init(ht_arena_t *arena) {
+  arena->chunks = NULL;
+  arena->large = NULL;
+  arena->cursor = NULL;
+  arena->end = NULL;
+  arena->next_chunk = HT_ARENA_MIN_CHUNK;
+  for (int i = 0; i < HT_ARENA_CLASSES; i++) {
+    arena->free_lists[i] = NULL;
+  }
+  arena->reserved = 0;
+  arena->live = 0;
+  arena->free = 0;
+}
+
+/*
+ * Vloží blok do seznamu volných bloků jeho třídy.
+ */
+static void ht_arena_push_free(ht_arena_t *arena, void *block, size_t size) {
+  void **list = &arena->free_lists[size / HT_ARENA_ALIGN - 1];
+  *(void **)block = *list;
+  *list = block;
+  arena->free += size;
+}
+
+/*
+ * Alokace samostatného velkého bloku. Velké bloky jsou obousměrně
+ * zřetězené, aby je šlo uvolnit jednotlivě.
+ */
+static void *ht_arena_alloc_large(ht_arena_t *arena, size_t size) {
+  ht_arena_chunk_t *chunk = malloc(HT_ARENA_HEADER + size);
+  if (chunk == NULL) {
+    return NULL;
+  }
+  chunk->size = HT_ARENA_HEADER + size;
+  chunk->prev = NULL;
+  chunk->next = arena->large;
+  if (arena->large != NULL) {
+    arena->large->prev = chunk;
+  }
+  arena->large = chunk;
+  arena->reserved += chunk->size;
+  arena->live += size;
+  return (char *)chunk + HT_ARENA_HEADER;
+}
+
+/*
+ * Přidá nový blok pro malé alokace. Nevyužitý konec předchozího bloku se
+ * nezahodí, ale vloží se do seznamu volných bloků.
+ */
+static bool ht_arena_grow(ht_arena_t *arena) {
+  ht_arena_chunk_t *chunk = malloc(arena->next_chunk);
+  if (chunk == NULL) {
+    return false;
+  }
+
+  size_t tail = (size_t)(arena->end - arena->cursor);
+  if (tail >= HT_ARENA_ALIGN) {
+    ht_arena_push_free(arena, arena->cursor, tail);
+  }
+
+  chunk->size = arena->next_chunk;
+  chunk->prev = NULL;
+  chunk->next = arena->chunks;
+  arena->chunks = chunk;
+  arena->cursor = (char *)chunk + HT_ARENA_HEADER;
+  arena->end = (char *)chunk + chunk->size;
+  arena->reserved += chunk->size;
+  if (arena->next_chunk < HT_ARENA_MAX_CHUNK) {
+    arena->next_chunk *= 2;
+  }
+  return true;
+}
+
+/*
+ * Alokace bloku o velikosti alespoň size bajtů zarovnaného na
+ * HT_ARENA_ALIGN. Při chybě alokace vrací NULL.
+ */
+void *ht_arena_alloc(ht_arena_t *arena, size_t size) {
+  size = HT_ARENA_ROUND(size == 0 ? 1 : size);
+  if (size > HT_ARENA_MAX_SMALL) {
+    return ht_arena_alloc_large(arena, size);
+  }
+
+  // Přednostně recyklujeme uvolněný blok stejné třídy
+  void **list = &arena->free_lists[size / HT_ARENA_ALIGN - 1];
+  if (*list != NULL) {
+    void *block = *list;
+    *list = *(void **)block;
+    arena->free -= size;
+    arena->live += size;
+    return block;
+  }
+
+  if ((size_t)(arena->end - arena->cursor) < size && !ht_arena_grow(arena)) {
+    return NULL;
+  }
+  void *block = arena->cursor;
+  arena->cursor += size;
+  arena->live += size;
+  return block;
+}
+
+/*
+ * Uvolnění bloku. Parametr size musí odpovídat velikosti zadané při
+ * alokaci; malé bloky se vrátí do seznamu volných bloků své třídy, velké
+ * se rovnou vrátí systému.
+ */
+void ht_arena_free(ht_arena_t *arena, void *block, size_t size) {
+  size = HT_ARENA_ROUND(size == 0 ? 1 : size);
+  arena->live -= size;
+  if (size <= HT_ARENA_MAX_SMALL) {
+    ht_arena_push_free(arena, block, size);
+    return;
+  }
+
+  ht_arena_chunk_t *chunk =
+      (ht_arena_chunk_t *)((char *)block - HT_ARENA_HEADER);
+  if (chunk->prev != NULL) {
+    chunk->prev->next = chunk->next;
+  } else {
+    arena->large = chunk->next;
+  }
+  if (chunk->next != NULL) {
+    chunk->next->prev = chunk->prev;
+  }
+  arena->reserved -= chunk->size;
+  free(chunk);
+}
+
+/*
+ * Uvolnění celé arény najednou. Projde jen seznam bloků paměti (jejich
+ * počet roste logaritmicky, po dosažení velikosti HT_ARENA_MAX_CHUNK
+ * lineárně) a velkých alokací, nikoli jednotlivé prvky.
+ * Aréna je poté ve stavu po inicializaci.
+ */
+void ht_arena_release(ht_arena_t *arena) {
+  ht_arena_chunk_t *lists[2] = {arena->chunks, arena->large};
+  for (int i = 0; i < 2; i++) {
+    ht_arena_chunk_t *chunk = lists[i];
+    while (chunk != NULL) {
+      ht_arena_chunk_t *next = chunk->next;
+      free(chunk);
+      chunk = next;
+    }
+  }
+  ht_arena_init(arena);
+}
+
+// Bloky uvolňované několika vlákny najednou
+typedef struct {
+  ht_arena_chunk_t **chunks;
+  size_t count;
+  int threads;
+} ht_arena_release_t;
+
+static void ht_arena_release_slice(void *context, int index) {
+  ht_arena_release_t *release = context;
+  for (size_t i = (size_t)index; i < release->count;
+       i += (size_t)release->threads) {
+    free(release->chunks[i]);
+  }
+}
+
+/*
+ * Uvolnění celé arény jako ht_arena_release, bloky paměti však vrací
+ * systému threads vláken najednou. Vyplatí se u velkých arén, jejichž
+ * uvolnění zabere hlavně vracení stránek systému. Pokud se nepodaří
+ * alokovat seznam bloků, uvolní arénu jedno vlákno.
+ */
+void ht_arena_release_parallel(ht_arena_t *arena, int threads) {
+  size_t count = 0;
+  ht_arena_chunk_t *lists[2] = {arena->chunks, arena->large};
+  for (int i = 0; i < 2; i++) {
+    for (ht_arena_chunk_t *chunk = lists[i]; chunk != NULL;
+         chunk = chunk->next) {
+      count++;
+    }
+  }
+  ht_arena_chunk_t **chunks =
+      threads > 1 && count > 1 ? malloc(count * sizeof(*chunks)) : NULL;
+  if (chunks == NULL) {
+    ht_arena_release(arena);
+    return;
+  }
+
+  count = 0;
+  for (int i = 0; i < 2; i++) {
+    for (ht_arena_chunk_t *chunk = lists[i]; chunk != NULL;
+         chunk = chunk->next) {
+      chunks[count++] = chunk;
+    }
+  }
+  ht_arena_release_t release = {chunks, count,
+                                (size_t)threads < count ? threads
+                                                        : (int)count};
+  ht_parallel_run(release.threads, ht_arena_release_slice, &release);
+  free(chunks);
+  ht_arena_init(arena);
+}
+
+/*
+ * Vloží nepřidělený úsek paměti do seznamů volných bloků po kusech
+ * velikosti nejvýše HT_ARENA_MAX_SMALL.
+ */
+static void ht_arena_push_range(ht_arena_t *arena, char *start, char *end) {
+  while ((size_t)(end - start) >= HT_ARENA_ALIGN) {
+    size_t size = (size_t)(end - start) < HT_ARENA_MAX_SMALL
+                      ? (size_t)(end - start) & ~(size_t)(HT_ARENA_ALIGN - 1)
+                      : HT_ARENA_MAX_SMALL;
+    ht_arena_push_free(arena, start, size);
+    start += size;
+  }
+}
+
+/*
+ * Připojení všech bloků arény other k aréně arena (například arén, ze
+ * kterých přidělovala jednotlivá vlákna). Bloky přidělené z other se pak
+ * uvolňují do arena a uvolní se spolu s ní; other je poté ve stavu po
+ * inicializaci. Z nepřidělených konců posledních bloků obou arén se dál
+ * přiděluje z delšího, kratší se rozdělí mezi volné bloky.
+ */
+void ht_arena_merge(ht_arena_t *arena, ht_arena_t *other) {
+  if (other->end - other->cursor > arena->end - arena->cursor) {
+    char *cursor = arena->cursor;
+    char *end = arena->end;
+    arena->cursor = other->cursor;
+    arena->end = other->end;
+    other->cursor = cursor;
+    other->end = end;
+  }
+  ht_arena_push_range(other, other->cursor, other->end);
+
+  // Seznamy volných bloků připojíme za konec seznamů v other
+  for (int i = 0; i < HT_ARENA_CLASSES; i++) {
+    if (other->free_lists[i] != NULL) {
+      void **last = other->free_lists[i];
+      while (*last != NULL) {
+        last = *last;
+      }
+      *last = arena->free_lists[i];
+      arena->free_lists[i] = other->free_lists[i];
+    }
+  }
+
+  if (other->chunks != NULL) {
+    ht_arena_chunk_t *last = other->chunks;
+    while (last->next != NULL) {
+      last = last->next;
+    }
+    last->next = arena->chunks;
+    arena->chunks = other->chunks;
+  }
+  if (other->large != NULL) {
+    ht_arena_chunk_t *last = other->large;
+    while (last->next != NULL) {
+      last = last->next;
+    }
+    last->next = arena->large;
+    if (arena->large != NULL) {
+      arena->large->prev = last;
+    }
+    arena->large = other->large;
+  }
+
+  arena->reserved += other->reserved;
+  arena->live += other->live;
+  arena->free += other->free;
+  ht_arena_init(other);
+}
+
+/*
+ * Statistiky využití paměti arény. Fragmentace je podíl uvolněných bloků
+ * čekajících na recyklaci v paměti, která už byla z bloků přidělena;
+ * dosud nepřidělený konec posledního bloku se do ní nepočítá.
+ */
+void ht_arena_stats(const ht_arena_t *arena, ht_arena_stats_t *stats) {
+  stats->reserved = arena->reserved;
+  stats->live = arena->live;
+  stats->free = arena->free;
+  size_t used = arena->live + arena->free;
+  stats->fragmentation = used == 0 ? 0 : (double)arena->free / used;
+}
@@ -0,0 +1,66 @@
+/*
+ * Hlavičkový soubor pro alokátor prvků tabulky s rozptýlenými položkami.
+ */
+
+#ifndef IAL_HASHTABLE_ARENA_H
+#define IAL_HASHTABLE_ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Zarovnání a granularita přidělovaných bloků. Malé bloky (do
+ * HT_ARENA_MAX_SMALL bajtů) se dělí do tříd po HT_ARENA_ALIGN bajtech
+ * a uvolněné bloky každé třídy se recyklují přes vlastní seznam volných
+ * bloků. Větší bloky se alokují samostatně.
+ */
+#define HT_ARENA_ALIGN 16
+#define HT_ARENA_MAX_SMALL 1024
+#define HT_ARENA_CLASSES (HT_ARENA_MAX_SMALL / HT_ARENA_ALIGN)
+
+/*
+ * Velikost prvního a největšího bloku paměti, ze kterého se malé bloky
+ * přidělují posunem ukazatele. Každý další blok je dvakrát větší než
+ * předchozí, dokud nedosáhne HT_ARENA_MAX_CHUNK. Do té velikosti roste
+ * počet bloků logaritmicky s objemem dat, potom už lineárně (jeden blok
+ * na každých HT_ARENA_MAX_CHUNK bajtů).
+ */
+#define HT_ARENA_MIN_CHUNK (64 * 1024)
+#define HT_ARENA_MAX_CHUNK (16 * 1024 * 1024)
+
+// Hlavička bloku paměti získaného od systému
+typedef struct ht_arena_chunk {
+  struct ht_arena_chunk *prev; // předchozí blok (jen u velkých bloků)
+  struct ht_arena_chunk *next; // další blok v seznamu
+  size_t size;                 // velikost bloku včetně hlavičky
+} ht_arena_chunk_t;
+
+// Alokátor s přidělováním posunem ukazatele a seznamy volných bloků
+typedef struct ht_arena {
+  ht_arena_chunk_t *chunks;              // bloky pro malé alokace
+  ht_arena_chunk_t *large;               // samostatně alokované velké bloky
+  char *cursor;                          // začátek volné části bloku
+  char *end;                             // konec posledního bloku
+  size_t next_chunk;                     // velikost příštího bloku
+  void *free_lists[HT_ARENA_CLASSES];    // uvolněné malé bloky podle tříd
+  size_t reserved;                       // bajty získané od systému
+  size_t live;                           // bajty v živých alokacích
+  size_t free;                           // bajty na seznamech volných bloků
+} ht_arena_t;
+
+// Statistiky alokátoru
+typedef struct ht_arena_stats {
+  size_t reserved;      // bajty získané od systému
+  size_t live;          // bajty v živých alokacích
+  size_t free;          // bajty připravené k recyklaci
+  double fragmentation; // podíl volných bloků v přidělené paměti
+} ht_arena_stats_t;
+
+void ht_arena_init(ht_arena_t *arena);
+void *ht_arena_alloc(ht_arena_t *arena, size_t size);
+void ht_arena_free(ht_arena_t *arena, void *block, size_t size);
+void ht_arena_release(ht_arena_t *arena);
+void ht_arena_release_parallel(ht_arena_t *arena, int threads);
+void ht_arena_merge(ht_arena_t *arena, ht_arena_t *other);
+void ht_arena_stats(const ht_arena_t *arena, ht_arena_stats_t *stats);
+
+#endif
@@ -0,0 +1,858 @@
+/*
+ * Uspořádaný index řetězců — adaptivní radixový strom
+ *
+ * Strom podle Leis et al., "The Adaptive Radix Tree" (viz art.h). Vnitřní
+ * uzel rozhoduje podle jednoho bajtu klíče a velikost mu roste s počtem
+ * potomků: uzel se 4 a se 16 potomky drží seřazené bajty a hledá v nich
+ * (uzel se 16 potomky jedním porovnáním SSE2), uzel se 48 potomky má
+ * tabulku 256 indexů a uzel s 256 potomky pole ukazatelů přímo podle bajtu.
+ * Uzel se zvětší, když se do něj nový potomek nevejde, a zmenší, když mu
+ * po mazání zbude výrazně méně potomků, než pojme menší uzel (aby se při
+ * střídání vkládání a mazání neměnil pořád dokola).
+ *
+ * Úseky cest, na kterých se strom nevětví, se ukládají jako prefix uzlu.
+ * Vyhledání porovná jen uložené bajty prefixu a zbytek ověří v listu;
+ * vkládání, mazání a procházení, které potřebují celý prefix, si jeho
+ * chybějící bajty přečtou z klíče libovolného listu pod uzlem.
+ */
+
+#include "art.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Druh uzlu podle prvního bajtu (vnitřní uzel i list jím začínají)
+static inline uint8_t ht_art_type(const ht_art_node_t *node) {
+  return *(const uint8_t *)node;
+}
+
+// Velikost vnitřního uzlu daného druhu
+static size_t ht_art_node_size(uint8_t type) {
+  switch (type) {
+  case HT_ART_NODE4:
+    return sizeof(ht_art_node4_t);
+  case HT_ART_NODE16:
+    return sizeof(ht_art_node16_t);
+  case HT_ART_NODE48:
+    return sizeof(ht_art_node48_t);
+  default:
+    return sizeof(ht_art_node256_t);
+  }
+}
+
+/*
+ * Alokace prázdného vnitřního uzlu, při chybě NULL.
+ */
+static ht_art_node_t *ht_art_alloc_node(ht_art_t *tree, uint8_t type) {
+  size_t size = ht_art_node_size(type);
+  ht_art_node_t *node = calloc(1, size);
+  if (node == NULL) {
+    return NULL;
+  }
+  node->type = type;
+  tree->bytes += size;
+  return node;
+}
+
+/*
+ * Alokace listu s kopií klíče délky length, při chybě NULL.
+ */
+static ht_art_leaf_t *ht_art_alloc_leaf(ht_art_t *tree, const char *key,
+                                        size_t length, float value) {
+  size_t size = sizeof(ht_art_leaf_t) + length + 1;
+  ht_art_leaf_t *leaf = malloc(size);
+  if (leaf == NULL) {
+    return NULL;
+  }
+  leaf->type = HT_ART_LEAF;
+  leaf->value = value;
+  leaf->length = (uint32_t)length;
+  memcpy(leaf->key, key, length + 1);
+  tree->bytes += size;
+  return leaf;
+}
+
+/*
+ * Uvolnění jednoho uzlu nebo listu (bez potomků).
+ */
+static void ht_art_free_node(ht_art_t *tree, ht_art_node_t *node) {
+  if (ht_art_type(node) == HT_ART_LEAF) {
+    tree->bytes -= sizeof(ht_art_leaf_t) + ((ht_art_leaf_t *)node)->length + 1;
+  } else {
+    tree->bytes -= ht_art_node_size(node->type);
+  }
+  free(node);
+}
+
+static inline bool ht_art_leaf_matches(const ht_art_leaf_t *leaf,
+                                       const char *key, size_t length) {
+  return leaf->length == length && memcmp(leaf->key, key, length) == 0;
+}
+
+/*
+ * Odkaz na potomka uzlu pro bajt byte, nebo NULL.
+ */
+static ht_art_node_t **ht_art_find_child(ht_art_node_t *node, uint8_t byte) {
+  switch (node->type) {
+  case HT_ART_NODE4: {
+    ht_art_node4_t *small = (ht_art_node4_t *)node;
+    for (int i = 0; i < node->count; i++) {
+      if (small->keys[i] == byte) {
+        return &small->children[i];
+      }
+    }
+    return NULL;
+  }
+  case HT_ART_NODE16: {
+    ht_art_node16_t *medium = (ht_art_node16_t *)node;
+#if defined(__SSE2__)
+    // Porovná bajt se všemi 16 klíči najednou a vezme první shodu
+    __m128i keys = _mm_loadu_si128((const __m128i *)medium->keys);
+    __m128i equal = _mm_cmpeq_epi8(keys, _mm_set1_epi8((char)byte));
+    unsigned mask = (unsigned)_mm_movemask_epi8(equal) &
+                    ((1u << node->count) - 1);
+    return mask != 0 ? &medium->children[__builtin_ctz(mask)] : NULL;
+#else
+    for (int i = 0; i < node->count; i++) {
+      if (medium->keys[i] == byte) {
+        return &medium->children[i];
+      }
+    }
+    return NULL;
+#endif
+  }
+  case HT_ART_NODE48: {
+    ht_art_node48_t *large = (ht_art_node48_t *)node;
+    uint8_t index = large->index[byte];
+    return index != 0 ? &large->children[index - 1] : NULL;
+  }
+  default: {
+    ht_art_node256_t *full = (ht_art_node256_t *)node;
+    return full->children[byte] != NULL ? &full->children[byte] : NULL;
+  }
+  }
+}
+
+// První potomek ze seřazených bajtů keys s bajtem alespoň *byte
+static ht_art_node_t *ht_art_next_sorted(const uint8_t *keys,
+                                         ht_art_node_t *const *children,
+                                         int count, unsigned *byte) {
+  for (int i = 0; i < count; i++) {
+    if (keys[i] >= *byte) {
+      *byte = keys[i];
+      return children[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Potomek uzlu s nejmenším bajtem, který není menší než *byte; bajt
+ * potomka uloží do *byte. Vrací NULL, pokud takový potomek není.
+ * Postupným voláním s *byte + 1 se projdou potomci vzestupně.
+ */
+static ht_art_node_t *ht_art_next_child(ht_art_node_t *node, unsigned *byte) {
+  switch (node->type) {
+  case HT_ART_NODE4: {
+    ht_art_node4_t *small = (ht_art_node4_t *)node;
+    return ht_art_next_sorted(small->keys, small->children, node->count, byte);
+  }
+  case HT_ART_NODE16: {
+    ht_art_node16_t *medium = (ht_art_node16_t *)node;
+    return ht_art_next_sorted(medium->keys, medium->children, node->count,
+                              byte);
+  }
+  case HT_ART_NODE48: {
+    ht_art_node48_t *large = (ht_art_node48_t *)node;
+    for (unsigned i = *byte; i < 256; i++) {
+      if (large->index[i] != 0) {
+        *byte = i;
+        return large->children[large->index[i] - 1];
+      }
+    }
+    return NULL;
+  }
+  default: {
+    ht_art_node256_t *full = (ht_art_node256_t *)node;
+    for (unsigned i = *byte; i < 256; i++) {
+      if (full->children[i] != NULL) {
+        *byte = i;
+        return full->children[i];
+      }
+    }
+    return NULL;
+  }
+  }
+}
+
+/*
+ * List s nejmenším klíčem pod uzlem.
+ */
+static ht_art_leaf_t *ht_art_minimum(ht_art_node_t *node) {
+  while (ht_art_type(node) != HT_ART_LEAF) {
+    unsigned byte = 0;
+    node = ht_art_next_child(node, &byte);
+  }
+  return (ht_art_leaf_t *)node;
+}
+
+/*
+ * Celý prefix uzlu na hloubce depth. Prefix delší než HT_ART_PREFIX se
+ * přečte z klíče nejmenšího listu pod uzlem (všechny listy ho sdílejí).
+ */
+static const uint8_t *ht_art_prefix(ht_art_node_t *node, size_t depth) {
+  if (node->prefix_length <= HT_ART_PREFIX) {
+    return node->prefix;
+  }
+  return (const uint8_t *)ht_art_minimum(node)->key + depth;
+}
+
+/*
+ * Počet bajtů prefixu uzlu, které se shodují s klíčem délky length od
+ * hloubky depth (porovnává se i ukončovací znak klíče).
+ */
+static size_t ht_art_prefix_match(ht_art_node_t *node, const uint8_t *key,
+                                  size_t length, size_t depth) {
+  size_t max = length + 1 - depth;
+  max = node->prefix_length < max ? node->prefix_length : max;
+  const uint8_t *prefix = ht_art_prefix(node, depth);
+  size_t match = 0;
+  while (match < max && prefix[match] == key[depth + match]) {
+    match++;
+  }
+  return match;
+}
+
+// Zkopíruje počet potomků a prefix uzlu do uzlu jiné velikosti
+static void ht_art_copy_header(ht_art_node_t *to, const ht_art_node_t *from) {
+  to->count = from->count;
+  to->prefix_length = from->prefix_length;
+  memcpy(to->prefix, from->prefix, HT_ART_PREFIX);
+}
+
+// Vloží bajt a potomka na správné místo seřazeného pole s count prvky
+static void ht_art_insert_sorted(uint8_t *keys, ht_art_node_t **children,
+                                 int count, uint8_t byte,
+                                 ht_art_node_t *child) {
+  int i = 0;
+  while (i < count && keys[i] < byte) {
+    i++;
+  }
+  memmove(keys + i + 1, keys + i, count - i);
+  memmove(children + i + 1, children + i, (count - i) * sizeof(*children));
+  keys[i] = byte;
+  children[i] = child;
+}
+
+/*
+ * Přidá uzlu *ref potomka pro bajt byte (bajt v uzlu ještě není). Plný
+ * uzel se nejprve nahradí větším. Při chybě alokace vrací false a uzel
+ * zůstane beze změny.
+ */
+static bool ht_art_add_child(ht_art_t *tree, ht_art_node_t **ref,
+                             uint8_t byte, ht_art_node_t *child) {
+  ht_art_node_t *node = *ref;
+  switch (node->type) {
+  case HT_ART_NODE4: {
+    ht_art_node4_t *small = (ht_art_node4_t *)node;
+    if (node->count < 4) {
+      ht_art_insert_sorted(small->keys, small->children, node->count, byte,
+                           child);
+      node->count++;
+      return true;
+    }
+    ht_art_node16_t *medium =
+        (ht_art_node16_t *)ht_art_alloc_node(tree, HT_ART_NODE16);
+    if (medium == NULL) {
+      return false;
+    }
+    ht_art_copy_header(&medium->header, node);
+    memcpy(medium->keys, small->keys, sizeof(small->keys));
+    memcpy(medium->children, small->children, sizeof(small->children));
+    ht_art_free_node(tree, node);
+    *ref = &medium->header;
+    return ht_art_add_child(tree, ref, byte, child);
+  }
+  case HT_ART_NODE16: {
+    ht_art_node16_t *medium = (ht_art_node16_t *)node;
+    if (node->count < 16) {
+      ht_art_insert_sorted(medium->keys, medium->children, node->count, byte,
+                           child);
+      node->count++;
+      return true;
+    }
+    ht_art_node48_t *large =
+        (ht_art_node48_t *)ht_art_alloc_node(tree, HT_ART_NODE48);
+    if (large == NULL) {
+      return false;
+    }
+    ht_art_copy_header(&large->header, node);
+    for (int i = 0; i < 16; i++) {
+      large->index[medium->keys[i]] = (uint8_t)(i + 1);
+      large->children[i] = medium->children[i];
+    }
+    ht_art_free_node(tree, node);
+    *ref = &large->header;
+    return ht_art_add_child(tree, ref, byte, child);
+  }
+  case HT_ART_NODE48: {
+    ht_art_node48_t *large = (ht_art_node48_t *)node;
+    if (node->count < 48) {
+      int slot = 0;
+      while (large->children[slot] != NULL) {
+        slot++;
+      }
+      large->children[slot] = child;
+      large->index[byte] = (uint8_t)(slot + 1);
+      node->count++;
+      return true;
+    }
+    ht_art_node256_t *full =
+        (ht_art_node256_t *)ht_art_alloc_node(tree, HT_ART_NODE256);
+    if (full == NULL) {
+      return false;
+    }
+    ht_art_copy_header(&full->header, node);
+    for (int i = 0; i < 256; i++) {
+      if (large->index[i] != 0) {
+        full->children[i] = large->children[large->index[i] - 1];
+      }
+    }
+    ht_art_free_node(tree, node);
+    *ref = &full->header;
+    return ht_art_add_child(tree, ref, byte, child);
+  }
+  default: {
+    ht_art_node256_t *full = (ht_art_node256_t *)node;
+    full->children[byte] = child;
+    node->count++;
+    return true;
+  }
+  }
+}
+
+/*
+ * Spojí uzel se 4 potomky, kterému zbyl jediný potomek, s tímto potomkem:
+ * vnitřní potomek dostane před svůj prefix prefix uzlu a bajt, pod kterým
+ * v uzlu visel; list klíč nese celý, ten jen nahradí uzel.
+ */
+static void ht_art_collapse(ht_art_t *tree, ht_art_node_t **ref) {
+  ht_art_node4_t *small = (ht_art_node4_t *)*ref;
+  ht_art_node_t *node = &small->header;
+  ht_art_node_t *child = small->children[0];
+  if (ht_art_type(child) != HT_ART_LEAF) {
+    size_t stored = node->prefix_length;
+    if (stored < HT_ART_PREFIX) {
+      node->prefix[stored++] = small->keys[0];
+    }
+    if (stored < HT_ART_PREFIX) {
+      size_t rest = HT_ART_PREFIX - stored;
+      rest = child->prefix_length < rest ? child->prefix_length : rest;
+      memcpy(node->prefix + stored, child->prefix, rest);
+      stored += rest;
+    }
+    memcpy(child->prefix, node->prefix,
+           stored < HT_ART_PREFIX ? stored : HT_ART_PREFIX);
+    child->prefix_length += node->prefix_length + 1;
+  }
+  *ref = child;
+  ht_art_free_node(tree, node);
+}
+
+// Odebere bajt a potomka na pozici i seřazeného pole s count prvky
+static void ht_art_remove_sorted(uint8_t *keys, ht_art_node_t **children,
+                                 int count, int i) {
+  memmove(keys + i, keys + i + 1, count - i - 1);
+  memmove(children + i, children + i + 1,
+          (count - i - 1) * sizeof(*children));
+}
+
+/*
+ * Odebere uzlu *ref potomka pro bajt byte. Uzlu, kterému zbude výrazně
+ * méně potomků, než pojme menší uzel, se nahradí menším (při chybě
+ * alokace zůstane větší, což nevadí); uzel se 4 potomky, kterému zbyl
+ * jediný, se s ním spojí.
+ */
+static void ht_art_remove_child(ht_art_t *tree, ht_art_node_t **ref,
+                                uint8_t byte) {
+  ht_art_node_t *node = *ref;
+  switch (node->type) {
+  case HT_ART_NODE4: {
+    ht_art_node4_t *small = (ht_art_node4_t *)node;
+    int i = (int)(ht_art_find_child(node, byte) - small->children);
+    ht_art_remove_sorted(small->keys, small->children, node->count, i);
+    if (--node->count == 1) {
+      ht_art_collapse(tree, ref);
+    }
+    return;
+  }
+  case HT_ART_NODE16: {
+    ht_art_node16_t *medium = (ht_art_node16_t *)node;
+    int i = (int)(ht_art_find_child(node, byte) - medium->children);
+    ht_art_remove_sorted(medium->keys, medium->children, node->count, i);
+    if (--node->count != 3) {
+      return;
+    }
+    ht_art_node4_t *small =
+        (ht_art_node4_t *)ht_art_alloc_node(tree, HT_ART_NODE4);
+    if (small != NULL) {
+      ht_art_copy_header(&small->header, node);
+      memcpy(small->keys, medium->keys, 3);
+      memcpy(small->children, medium->children, 3 * sizeof(ht_art_node_t *));
+      ht_art_free_node(tree, node);
+      *ref = &small->header;
+    }
+    return;
+  }
+  case HT_ART_NODE48: {
+    ht_art_node48_t *large = (ht_art_node48_t *)node;
+    large->children[large->index[byte] - 1] = NULL;
+    large->index[byte] = 0;
+    if (--node->count != 12) {
+      return;
+    }
+    ht_art_node16_t *medium =
+        (ht_art_node16_t *)ht_art_alloc_node(tree, HT_ART_NODE16);
+    if (medium != NULL) {
+      ht_art_copy_header(&medium->header, node);
+      int count = 0;
+      for (int i = 0; i < 256; i++) {
+        if (large->index[i] != 0) {
+          medium->keys[count] = (uint8_t)i;
+          medium->children[count++] = large->children[large->index[i] - 1];
+        }
+      }
+      ht_art_free_node(tree, node);
+      *ref = &medium->header;
+    }
+    return;
+  }
+  default: {
+    ht_art_node256_t *full = (ht_art_node256_t *)node;
+    full->children[byte] = NULL;
+    if (--node->count != 37) {
+      return;
+    }
+    ht_art_node48_t *large =
+        (ht_art_node48_t *)ht_art_alloc_node(tree, HT_ART_NODE48);
+    if (large != NULL) {
+      ht_art_copy_header(&large->header, node);
+      int count = 0;
+      for (int i = 0; i < 256; i++) {
+        if (full->children[i] != NULL) {
+          large->children[count++] = full->children[i];
+          large->index[i] = (uint8_t)count;
+        }
+      }
+      ht_art_free_node(tree, node);
+      *ref = &large->header;
+    }
+    return;
+  }
+  }
+}
+
+/*
+ * Inicializace prázdného stromu.
+ */
+void ht_art_init(ht_art_t *tree) {
+  tree->root = NULL;
+  tree->count = 0;
+  tree->bytes = 0;
+}
+
+/*
+ * Získání hodnoty ze stromu.
+ *
+ * Vrací ukazatel na hodnotu v listu, nebo NULL, pokud klíč ve stromu není.
+ * Ukazatel platí do smazání klíče.
+ */
+float *ht_art_get(ht_art_t *tree, const char *key) {
+  size_t length = strlen(key);
+  const uint8_t *bytes = (const uint8_t *)key;
+  ht_art_node_t *node = tree->root;
+  size_t depth = 0;
+
+  while (node != NULL) {
+    if (ht_art_type(node) == HT_ART_LEAF) {
+      ht_art_leaf_t *leaf = (ht_art_leaf_t *)node;
+      return ht_art_leaf_matches(leaf, key, length) ? &leaf->value : NULL;
+    }
+    // Porovnají se jen uložené bajty prefixu, zbytek ověří list
+    if (node->prefix_length > 0) {
+      size_t stored = node->prefix_length < HT_ART_PREFIX ? node->prefix_length
+                                                          : HT_ART_PREFIX;
+      if (depth + node->prefix_length > length ||
+          memcmp(node->prefix, bytes + depth, stored) != 0) {
+        return NULL;
+      }
+      depth += node->prefix_length;
+    }
+    ht_art_node_t **child = ht_art_find_child(node, bytes[depth]);
+    node = child != NULL ? *child : NULL;
+    depth++;
+  }
+  return NULL;
+}
+
+/*
+ * Nahradí list *ref uzlem se 4 potomky, který má za prefix společnou část
+ * klíčů od hloubky depth a pod sebou původní list a nový list s klíčem
+ * key. Vrací ukazatel na hodnotu nového listu, při chybě alokace NULL.
+ */
+static float *ht_art_split_leaf(ht_art_t *tree, ht_art_node_t **ref,
+                                const char *key, size_t length, size_t depth,
+                                float value) {
+  ht_art_leaf_t *leaf = ht_art_alloc_leaf(tree, key, length, value);
+  ht_art_node_t *split = ht_art_alloc_node(tree, HT_ART_NODE4);
+  if (leaf == NULL || split == NULL) {
+    if (leaf != NULL) {
+      ht_art_free_node(tree, (ht_art_node_t *)leaf);
+    }
+    if (split != NULL) {
+      ht_art_free_node(tree, split);
+    }
+    return NULL;
+  }
+
+  // Klíče se liší nejpozději v ukončovacím znaku kratšího z nich
+  const uint8_t *bytes = (const uint8_t *)key;
+  const uint8_t *other = (const uint8_t *)((ht_art_leaf_t *)*ref)->key;
+  size_t common = 0;
+  while (bytes[depth + common] == other[depth + common]) {
+    common++;
+  }
+  split->prefix_length = (uint32_t)common;
+  memcpy(split->prefix, bytes + depth,
+         common < HT_ART_PREFIX ? common : HT_ART_PREFIX);
+  ht_art_add_child(tree, &split, other[depth + common], *ref);
+  ht_art_add_child(tree, &split, bytes[depth + common],
+                   (ht_art_node_t *)leaf);
+  *ref = split;
+  return &leaf->value;
+}
+
+/*
+ * Rozdělí prefix uzlu *ref, jehož prvních match bajtů se shoduje s klíčem:
+ * nový uzel se 4 potomky dostane shodnou část a pod sebou původní uzel se
+ * zbytkem prefixu za rozdílným bajtem a nový list s klíčem key. Vrací
+ * ukazatel na hodnotu nového listu, při chybě alokace NULL.
+ */
+static float *ht_art_split_prefix(ht_art_t *tree, ht_art_node_t **ref,
+                                  const char *key, size_t length,
+                                  size_t depth, size_t match, float value) {
+  ht_art_leaf_t *leaf = ht_art_alloc_leaf(tree, key, length, value);
+  ht_art_node_t *split = ht_art_alloc_node(tree, HT_ART_NODE4);
+  if (leaf == NULL || split == NULL) {
+    if (leaf != NULL) {
+      ht_art_free_node(tree, (ht_art_node_t *)leaf);
+    }
+    if (split != NULL) {
+      ht_art_free_node(tree, split);
+    }
+    return NULL;
+  }
+
+  const uint8_t *bytes = (const uint8_t *)key;
+  ht_art_node_t *node = *ref;
+  split->prefix_length = (uint32_t)match;
+  memcpy(split->prefix, bytes + depth,
+         match < HT_ART_PREFIX ? match : HT_ART_PREFIX);
+
+  // Celý prefix se musí přečíst dřív, než se zkrátí
+  const uint8_t *prefix = ht_art_prefix(node, depth);
+  uint8_t byte = prefix[match];
+  node->prefix_length -= (uint32_t)(match + 1);
+  memmove(node->prefix, prefix + match + 1,
+          node->prefix_length < HT_ART_PREFIX ? node->prefix_length
+                                              : HT_ART_PREFIX);
+
+  ht_art_add_child(tree, &split, byte, node);
+  ht_art_add_child(tree, &split, bytes[depth + match], (ht_art_node_t *)leaf);
+  *ref = split;
+  return &leaf->value;
+}
+
+/*
+ * Vložení prvku do stromu.
+ *
+ * Pokud klíč ve stromu už je, přepíše jeho hodnotu. Vrací ukazatel na
+ * hodnotu v listu (platný do smazání klíče), při chybě alokace NULL
+ * a strom zůstane beze změny.
+ */
+float *ht_art_insert(ht_art_t *tree, const char *key, float value) {
+  size_t length = strlen(key);
+  if (length >= UINT32_MAX) {
+    return NULL;
+  }
+  const uint8_t *bytes = (const uint8_t *)key;
+  ht_art_node_t **ref = &tree->root;
+  size_t depth = 0;
+  float *result;
+
+  while (*ref != NULL && ht_art_type(*ref) != HT_ART_LEAF) {
+    ht_art_node_t *node = *ref;
+    if (node->prefix_length > 0) {
+      size_t match = ht_art_prefix_match(node, bytes, length, depth);
+      if (match < node->prefix_length) {
+        result = ht_art_split_prefix(tree, ref, key, length, depth, match,
+                                     value);
+        tree->count += result != NULL;
+        return result;
+      }
+      depth += node->prefix_length;
+    }
+
+    ht_art_node_t **child = ht_art_find_child(node, bytes[depth]);
+    if (child == NULL) {
+      ht_art_leaf_t *leaf = ht_art_alloc_leaf(tree, key, length, value);
+      if (leaf == NULL) {
+        return NULL;
+      }
+      if (!ht_art_add_child(tree, ref, bytes[depth], (ht_art_node_t *)leaf)) {
+        ht_art_free_node(tree, (ht_art_node_t *)leaf);
+        return NULL;
+      }
+      tree->count++;
+      return &leaf->value;
+    }
+    ref = child;
+    depth++;
+  }
+
+  if (*ref == NULL) {
+    ht_art_leaf_t *leaf = ht_art_alloc_leaf(tree, key, length, value);
+    if (leaf == NULL) {
+      return NULL;
+    }
+    *ref = (ht_art_node_t *)leaf;
+    tree->count++;
+    return &leaf->value;
+  }
+
+  ht_art_leaf_t *leaf = (ht_art_leaf_t *)*ref;
+  if (ht_art_leaf_matches(leaf, key, length)) {
+    leaf->value = value;
+    return &leaf->value;
+  }
+  result = ht_art_split_leaf(tree, ref, key, length, depth, value);
+  tree->count += result != NULL;
+  return result;
+}
+
+/*
+ * Smazání prvku ze stromu.
+ *
+ * List se odebere z rodiče, který se případně zmenší nebo spojí se svým
+ * jediným zbylým potomkem. Vrací false, pokud klíč ve stromu není.
+ */
+bool ht_art_delete(ht_art_t *tree, const char *key) {
+  size_t length = strlen(key);
+  const uint8_t *bytes = (const uint8_t *)key;
+  ht_art_node_t **parent = NULL;
+  ht_art_node_t **ref = &tree->root;
+  uint8_t byte = 0;
+  size_t depth = 0;
+
+  while (*ref != NULL && ht_art_type(*ref) != HT_ART_LEAF) {
+    ht_art_node_t *node = *ref;
+    if (node->prefix_length > 0) {
+      size_t stored = node->prefix_length < HT_ART_PREFIX ? node->prefix_length
+                                                          : HT_ART_PREFIX;
+      if (depth + node->prefix_length > length ||
+          memcmp(node->prefix, bytes + depth, stored) != 0) {
+        return false;
+      }
+      depth += node->prefix_length;
+    }
+    byte = bytes[depth];
+    ht_art_node_t **child = ht_art_find_child(node, byte);
+    if (child == NULL) {
+      return false;
+    }
+    parent = ref;
+    ref = child;
+    depth++;
+  }
+
+  ht_art_leaf_t *leaf = (ht_art_leaf_t *)*ref;
+  if (leaf == NULL || !ht_art_leaf_matches(leaf, key, length)) {
+    return false;
+  }
+  if (parent == NULL) {
+    tree->root = NULL;
+  } else {
+    ht_art_remove_child(tree, parent, byte);
+  }
+  ht_art_free_node(tree, (ht_art_node_t *)leaf);
+  tree->count--;
+  return true;
+}
+
+// Uvolnění uzlu se všemi potomky
+static void ht_art_free_tree(ht_art_node_t *node) {
+  if (ht_art_type(node) != HT_ART_LEAF) {
+    ht_art_node_t *child;
+    for (unsigned byte = 0; (child = ht_art_next_child(node, &byte)) != NULL;
+         byte++) {
+      ht_art_free_tree(child);
+    }
+  }
+  free(node);
+}
+
+/*
+ * Smazání všech prvků; strom zůstane prázdný.
+ */
+void ht_art_delete_all(ht_art_t *tree) {
+  if (tree->root != NULL) {
+    ht_art_free_tree(tree->root);
+  }
+  ht_art_init(tree);
+}
+
+// Stav procházení stromu
+typedef struct ht_art_walk {
+  const char *from;      // nejmenší klíč (NULL = od začátku)
+  size_t from_length;    // délka from
+  const char *to;        // první klíč, který se už neprojde (NULL = do konce)
+  ht_art_visit_fn visit; // funkce volaná pro prvky
+  void *context;         // kontext funkce visit
+  size_t visited;        // počet prošlých prvků
+  bool stopped;          // procházení skončilo
+} ht_art_walk_t;
+
+static void ht_art_visit_leaf(ht_art_walk_t *walk, const ht_art_leaf_t *leaf) {
+  if (walk->to != NULL && strcmp(leaf->key, walk->to) >= 0) {
+    walk->stopped = true;  // Další klíče jsou ještě větší
+    return;
+  }
+  walk->visited++;
+  if (!walk->visit(leaf->key, leaf->length, leaf->value, walk->context)) {
+    walk->stopped = true;
+  }
+}
+
+/*
+ * Projde všechny prvky pod uzlem vzestupně.
+ */
+static void ht_art_walk_all(ht_art_walk_t *walk, ht_art_node_t *node) {
+  if (ht_art_type(node) == HT_ART_LEAF) {
+    ht_art_visit_leaf(walk, (const ht_art_leaf_t *)node);
+    return;
+  }
+  ht_art_node_t *child;
+  for (unsigned byte = 0;
+       !walk->stopped && (child = ht_art_next_child(node, &byte)) != NULL;
+       byte++) {
+    ht_art_walk_all(walk, child);
+  }
+}
+
+/*
+ * Projde vzestupně prvky pod uzlem na hloubce depth, které nejsou menší
+ * než walk->from; klíče pod uzlem se s from shodují v prvních depth
+ * bajtech. Podstromy, jejichž prefix je menší než odpovídající část from,
+ * se přeskočí celé a podstromy s větším prefixem se projdou celé.
+ */
+static void ht_art_walk_from(ht_art_walk_t *walk, ht_art_node_t *node,
+                             size_t depth) {
+  if (ht_art_type(node) == HT_ART_LEAF) {
+    const ht_art_leaf_t *leaf = (const ht_art_leaf_t *)node;
+    if (strcmp(leaf->key, walk->from) >= 0) {
+      ht_art_visit_leaf(walk, leaf);
+    }
+    return;
+  }
+  if (node->prefix_length > 0 && depth < walk->from_length) {
+    size_t rest = walk->from_length - depth;
+    int order = memcmp(ht_art_prefix(node, depth), walk->from + depth,
+                       node->prefix_length < rest ? node->prefix_length : rest);
+    if (order < 0) {
+      return;
+    }
+    if (order > 0) {
+      ht_art_walk_all(walk, node);
+      return;
+    }
+    depth += node->prefix_length;
+  }
+  if (depth >= walk->from_length) {
+    ht_art_walk_all(walk, node);  // Všechny klíče začínají celým from
+    return;
+  }
+
+  uint8_t bound = (uint8_t)walk->from[depth];
+  ht_art_node_t *child;
+  for (unsigned byte = bound;
+       !walk->stopped && (child = ht_art_next_child(node, &byte)) != NULL;
+       byte++) {
+    if (byte == bound) {
+      ht_art_walk_from(walk, child, depth + 1);
+    } else {
+      ht_art_walk_all(walk, child);
+    }
+  }
+}
+
+/*
+ * Projde vzestupně všechny prvky, jejichž klíč začíná prefixem prefix,
+ * a pro každý zavolá visit. Vrací počet prošlých prvků.
+ */
+size_t ht_art_scan_prefix(ht_art_t *tree, const char *prefix,
+                          ht_art_visit_fn visit, void *context) {
+  ht_art_walk_t walk = {NULL, 0, NULL, visit, context, 0, false};
+  size_t length = strlen(prefix);
+  const uint8_t *bytes = (const uint8_t *)prefix;
+  ht_art_node_t *node = tree->root;
+  size_t depth = 0;
+
+  // Sestup k uzlu, pod kterým leží právě klíče s prefixem
+  while (node != NULL) {
+    if (ht_art_type(node) == HT_ART_LEAF) {
+      const ht_art_leaf_t *leaf = (const ht_art_leaf_t *)node;
+      if (leaf->length >= length && memcmp(leaf->key, prefix, length) == 0) {
+        ht_art_visit_leaf(&walk, leaf);
+      }
+      break;
+    }
+    if (depth < length && node->prefix_length > 0) {
+      size_t rest = length - depth;
+      if (memcmp(ht_art_prefix(node, depth), bytes + depth,
+                 node->prefix_length < rest ? node->prefix_length : rest)) {
+        break;
+      }
+      depth += node->prefix_length;
+    }
+    if (depth >= length) {
+      ht_art_walk_all(&walk, node);
+      break;
+    }
+    ht_art_node_t **child = ht_art_find_child(node, bytes[depth]);
+    node = child != NULL ? *child : NULL;
+    depth++;
+  }
+  return walk.visited;
+}
+
+/*
+ * Projde vzestupně všechny prvky s klíčem z intervalu <from, to) (NULL
+ * znamená bez dolní, resp. horní meze) a pro každý zavolá visit. Klíče se
+ * porovnávají jako strcmp. Vrací počet prošlých prvků.
+ */
+size_t ht_art_scan_range(ht_art_t *tree, const char *from, const char *to,
+                         ht_art_visit_fn visit, void *context) {
+  ht_art_walk_t walk = {from, from != NULL ? strlen(from) : 0, to, visit,
+                        context, 0, false};
+  if (tree->root != NULL) {
+    if (from != NULL) {
+      ht_art_walk_from(&walk, tree->root, 0);
+    } else {
+      ht_art_walk_all(&walk, tree->root);
+    }
+  }
+  return walk.visited;
+}
@@ -0,0 +1,106 @@
+/*
+ * Hlavičkový soubor pro uspořádaný index řetězců (adaptivní radixový strom).
+ */
+
+#ifndef IAL_HASHTABLE_ART_H
+#define IAL_HASHTABLE_ART_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Adaptivní radixový strom (ART) se stejnými klíči (řetězce ukončené
+ * nulovým znakem) a hodnotami (float) jako tabulka. Na rozdíl od tabulky
+ * drží klíče seřazené podle bajtů (jako strcmp), takže umí projít klíče
+ * se společným prefixem a klíče z intervalu v pořadí.
+ *
+ * Každá úroveň stromu rozhoduje podle jednoho bajtu klíče. Vnitřní uzel
+ * má podle počtu potomků jednu ze čtyř velikostí (4, 16, 48 a 256) a při
+ * vkládání a mazání se mění na větší nebo menší. Cesta, na které se strom
+ * nevětví, se do uzlu uloží jako prefix (prvních HT_ART_PREFIX bajtů;
+ * delší prefix se při hledání přeskočí a ověří se až v listu). Klíč se
+ * ukládá i s nulovým znakem, žádný klíč proto není prefixem jiného
+ * a každý klíč končí v listu.
+ */
+#define HT_ART_PREFIX 8
+
+// Druh uzlu
+enum {
+  HT_ART_LEAF,
+  HT_ART_NODE4,
+  HT_ART_NODE16,
+  HT_ART_NODE48,
+  HT_ART_NODE256
+};
+
+// Hlavička vnitřního uzlu
+typedef struct ht_art_node {
+  uint8_t type;                  // HT_ART_NODE4 až HT_ART_NODE256
+  uint16_t count;                // počet potomků
+  uint32_t prefix_length;        // délka prefixu uzlu
+  uint8_t prefix[HT_ART_PREFIX]; // první bajty prefixu
+} ht_art_node_t;
+
+// Uzel až se 4 a až se 16 potomky, bajty klíčů jsou seřazené
+typedef struct ht_art_node4 {
+  ht_art_node_t header;
+  uint8_t keys[4];
+  ht_art_node_t *children[4];
+} ht_art_node4_t;
+
+typedef struct ht_art_node16 {
+  ht_art_node_t header;
+  uint8_t keys[16];
+  ht_art_node_t *children[16];
+} ht_art_node16_t;
+
+// Uzel až se 48 potomky: index[bajt] je pozice potomka + 1 (0 = žádný)
+typedef struct ht_art_node48 {
+  ht_art_node_t header;
+  uint8_t index[256];
+  ht_art_node_t *children[48];
+} ht_art_node48_t;
+
+// Uzel s potomkem pro každý bajt
+typedef struct ht_art_node256 {
+  ht_art_node_t header;
+  ht_art_node_t *children[256];
+} ht_art_node256_t;
+
+/*
+ * List s prvkem. Ukazatele na listy se ve stromu předávají jako
+ * ht_art_node_t *, druh uzlu se proto pozná podle prvního bajtu.
+ */
+typedef struct ht_art_leaf {
+  uint8_t type;    // HT_ART_LEAF
+  float value;     // hodnota prvku
+  uint32_t length; // délka klíče bez ukončovacího znaku
+  char key[];      // klíč s ukončovacím znakem
+} ht_art_leaf_t;
+
+// Strom
+typedef struct ht_art {
+  ht_art_node_t *root; // kořen (NULL = prázdný strom)
+  size_t count;        // počet prvků
+  size_t bytes;        // paměť uzlů a listů
+} ht_art_t;
+
+/*
+ * Funkce volaná pro každý prvek při procházení stromu (klíče vzestupně).
+ * Vrácením false procházení ukončí.
+ */
+typedef bool (*ht_art_visit_fn)(const char *key, size_t length, float value,
+                                void *context);
+
+void ht_art_init(ht_art_t *tree);
+float *ht_art_get(ht_art_t *tree, const char *key);
+float *ht_art_insert(ht_art_t *tree, const char *key, float value);
+bool ht_art_delete(ht_art_t *tree, const char *key);
+void ht_art_delete_all(ht_art_t *tree);
+size_t ht_art_scan_prefix(ht_art_t *tree, const char *prefix,
+                          ht_art_visit_fn visit, void *context);
+size_t ht_art_scan_range(ht_art_t *tree, const char *from, const char *to,
+                         ht_art_visit_fn visit, void *context);
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Měření dávkových operací (make batch_bench)
+ *
+ * Porovná ht_insert a ht_get volané po jednom klíči s ht_insert_many
+ * a ht_get_many na tabulce, která se nevejde do cache (výchozí počet
+ * klíčů je BENCH_KEYS, lze ho změnit prvním argumentem). Klíče se čtou
+ * v náhodném pořadí; měří se úspěšná vyhledání i vyhledání chybějících
+ * klíčů.
+ *
+ * Výstup je CSV: op,keys,mode,seconds,ns_per_op,speedup
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hashtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_KEYS (4 * 1024 * 1024)
+#define BENCH_KEY_LENGTH 40
+
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static uint64_t bench_next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+static void bench_report(const char *op, size_t keys, double single,
+                         double batched) {
+  printf("%s,%zu,single,%.3f,%.1f,1.00\n", op, keys, single,
+         single * 1e9 / keys);
+  printf("%s,%zu,batched,%.3f,%.1f,%.2f\n", op, keys, batched,
+         batched * 1e9 / keys, single / batched);
+}
+
+// Součet nalezených hodnot, aby překladač vyhledávání nevynechal
+static double bench_sum(float *values[], size_t count) {
+  double sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (values[i] != NULL) {
+      sum += *values[i];
+    }
+  }
+  return sum;
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = argc > 1 ? (size_t)atol(argv[1]) : BENCH_KEYS;
+  if (count == 0) {
+    count = BENCH_KEYS;
+  }
+
+  // Klíče ke vložení a stejný počet klíčů, které v tabulce nejsou
+  char (*keys)[BENCH_KEY_LENGTH] = malloc(2 * count * sizeof(*keys));
+  ht_item_t *items = malloc(count * sizeof(ht_item_t));
+  char **lookups = malloc(count * sizeof(char *));
+  float **values = malloc(count * sizeof(float *));
+  if (keys == NULL || items == NULL || lookups == NULL || values == NULL) {
+    fprintf(stderr, "batch_bench: out of memory\n");
+    return 1;
+  }
+  for (size_t i = 0; i < 2 * count; i++) {
+    snprintf(keys[i], BENCH_KEY_LENGTH, "key:%zu:%x", i,
+             (unsigned)(i * 2654435761u));
+  }
+  for (size_t i = 0; i < count; i++) {
+    items[i].key = keys[i];
+    items[i].value = (float)i;
+  }
+
+  ht_table_t single;
+  ht_table_t batched;
+  ht_init(&single);
+  ht_init(&batched);
+
+  double start = bench_now();
+  for (size_t i = 0; i < count; i++) {
+    ht_insert(&single, items[i].key, items[i].value);
+  }
+  double single_time = bench_now() - start;
+  start = bench_now();
+  ht_insert_many(&batched, items, count);
+  double batched_time = bench_now() - start;
+
+  printf("op,keys,mode,seconds,ns_per_op,speedup\n");
+  bench_report("insert", count, single_time, batched_time);
+
+  // Vyhledání v náhodném pořadí: nejprve existující, pak chybějící klíče
+  uint64_t rng = 0x9e3779b97f4a7c15u;
+  for (int miss = 0; miss <= 1; miss++) {
+    for (size_t i = 0; i < count; i++) {
+      lookups[i] = keys[miss * count + bench_next(&rng) % count];
+    }
+
+    double sum = 0;
+    start = bench_now();
+    for (size_t i = 0; i < count; i++) {
+      values[i] = ht_get(&batched, lookups[i]);
+    }
+    single_time = bench_now() - start;
+    sum += bench_sum(values, count);
+
+    start = bench_now();
+    ht_get_many(&batched, lookups, count, values);
+    batched_time = bench_now() - start;
+    sum += bench_sum(values, count);
+
+    bench_report(miss ? "get_miss" : "get_hit", count, single_time,
+                 batched_time);
+    fprintf(stderr, "checksum %.0f\n", sum);
+  }
+
+  ht_delete_all(&single);
+  ht_delete_all(&batched);
+  free(keys);
+  free(items);
+  free(lookups);
+  free(values);
+  return 0;
+}
@@ -0,0 +1,583 @@
+/*
+ * Sada mikrobenchmarků tabulky (make bench, make bench_oa, make bench_conc)
+ *
+ * Pro každou velikost tabulky a délku klíče změří:
+ *   insert  vložení všech klíčů do prázdné tabulky
+ *   hit     ht_get, z BENCH_HEAVY_PERCENT % klíče, které v tabulce jsou
+ *   miss    ht_get, z BENCH_HEAVY_PERCENT % klíče, které v tabulce nejsou
+ *   churn   ht_delete klíče z tabulky a ht_insert nového (velikost se
+ *           nemění), jedna operace je dvojice smazání a vložení
+ * Klíče pro hit, miss a churn se vybírají rovnoměrně (uniform) nebo podle
+ * Zipfova rozdělení s exponentem BENCH_ZIPF_THETA (zipf), kde malá část
+ * klíčů dostává většinu operací. Výchozí velikosti sahají od tabulky,
+ * která se vejde do L1, po tabulku o stovkách MB, větší než LLC.
+ *
+ * Každé měření běží dvakrát: první průchod měří průměrnou dobu operace
+ * a počet alokací (volání malloc a spol. z kódu tabulky), druhý měří
+ * dobu každé operace zvlášť pro percentily. Od doby operace se odečte
+ * režie čtení hodin.
+ *
+ * Použití: ./bench [-s velikosti] [-k délky klíčů] [-w měření]
+ *                  [-d rozdělení] [-n operací] [-f csv|json]
+ *   např.  ./bench -s 1000,1000000 -k 16 -w hit,miss -d zipf -f json
+ *
+ * Výstup je CSV (backend,workload,dist,key_length,keys,ops,ns_per_op,
+ * p50_ns,p90_ns,p99_ns,p999_ns,allocs_per_op,bytes_per_key), nebo pole
+ * JSON se stejnými položkami, jeden objekt na řádek.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hashtable.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(HT_BACKEND_CONC)
+#define BENCH_BACKEND "conc"
+#elif defined(HT_BACKEND_OA)
+#define BENCH_BACKEND "oa"
+#elif defined(HT_BACKEND_CUCKOO)
+#define BENCH_BACKEND "cuckoo"
+#elif defined(HT_BACKEND_COMPACT)
+#define BENCH_BACKEND "compact"
+#else
+#define BENCH_BACKEND "chained"
+#endif
+
+#define BENCH_SIZES "512,16384,262144,4194304"
+#define BENCH_KEY_LENGTHS "8,64"
+#define BENCH_OPS 1000000
+#define BENCH_MAX_LIST 16
+#define BENCH_MIN_KEY_LENGTH 8
+#define BENCH_HEAVY_PERCENT 90
+#define BENCH_ZIPF_THETA 0.99
+
+enum { BENCH_INSERT = 1, BENCH_HIT = 2, BENCH_MISS = 4, BENCH_CHURN = 8 };
+enum { BENCH_UNIFORM = 1, BENCH_ZIPF = 2 };
+
+/*
+ * Počítání alokací: Makefile sestaví bench s -Wl,--wrap=malloc atd.,
+ * takže volání z tabulky projdou těmito funkcemi.
+ */
+static size_t bench_allocs;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *block, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  bench_allocs++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  bench_allocs++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *block, size_t size) {
+  bench_allocs++;
+  return __real_realloc(block, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size) {
+  bench_allocs++;
+  return __real_aligned_alloc(alignment, size);
+}
+
+static uint64_t bench_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t bench_next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// Náhodné číslo z intervalu <0,1)
+static double bench_uniform(uint64_t *state) {
+  return (bench_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void *bench_alloc(size_t bytes) {
+  void *block = malloc(bytes > 0 ? bytes : 1);
+  if (block == NULL) {
+    fprintf(stderr, "bench: out of memory\n");
+    exit(1);
+  }
+  return block;
+}
+
+/*
+ * Zipfovo rozdělení nad pořadími 0 .. n-1 (Gray a kol., "Quickly
+ * Generating Billion-Record Synthetic Databases"). Pořadí se převádí na
+ * klíče náhodnou permutací, aby nejčastější klíče neležely v paměti
+ * vedle sebe.
+ */
+typedef struct {
+  size_t n;
+  double alpha;
+  double zetan;
+  double eta;
+  double half_pow;
+  size_t *ranks;  // klíč pro každé pořadí
+} bench_zipf_t;
+
+static void bench_zipf_init(bench_zipf_t *zipf, size_t n, uint64_t *rng) {
+  double zeta2 = 1 + pow(0.5, BENCH_ZIPF_THETA);
+  zipf->n = n;
+  zipf->zetan = 0;
+  for (size_t i = 1; i <= n; i++) {
+    zipf->zetan += 1 / pow((double)i, BENCH_ZIPF_THETA);
+  }
+  zipf->alpha = 1 / (1 - BENCH_ZIPF_THETA);
+  zipf->eta = (1 - pow(2.0 / n, 1 - BENCH_ZIPF_THETA)) /
+              (1 - zeta2 / zipf->zetan);
+  zipf->half_pow = pow(0.5, BENCH_ZIPF_THETA);
+  zipf->ranks = bench_alloc(n * sizeof(size_t));
+  for (size_t i = 0; i < n; i++) {
+    zipf->ranks[i] = i;
+  }
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = bench_next(rng) % (i + 1);
+    size_t swap = zipf->ranks[i];
+    zipf->ranks[i] = zipf->ranks[j];
+    zipf->ranks[j] = swap;
+  }
+}
+
+static size_t bench_zipf_next(const bench_zipf_t *zipf, uint64_t *rng) {
+  double u = bench_uniform(rng);
+  double uz = u * zipf->zetan;
+  size_t rank;
+  if (uz < 1) {
+    rank = 0;
+  } else if (uz < 1 + zipf->half_pow) {
+    rank = 1;
+  } else {
+    rank = (size_t)(zipf->n * pow(zipf->eta * u - zipf->eta + 1, zipf->alpha));
+  }
+  return zipf->ranks[rank < zipf->n ? rank : zipf->n - 1];
+}
+
+// Klíč z n klíčů podle rozdělení dist
+static size_t bench_pick(int dist, const bench_zipf_t *zipf, size_t n,
+                         uint64_t *rng) {
+  return dist == BENCH_ZIPF ? bench_zipf_next(zipf, rng)
+                            : bench_next(rng) % n;
+}
+
+/*
+ * Klíč číslo index o délce length: osm šestnáctkových číslic (prostá
+ * permutace indexu, takže jsou klíče různé) doplněných společnou výplní.
+ */
+static void bench_key(char *buffer, size_t index, size_t length) {
+  char digits[9];
+  snprintf(digits, sizeof(digits), "%08x",
+           (unsigned)((uint32_t)index * 2654435761u));
+  memcpy(buffer, digits, 8);
+  for (size_t i = 8; i < length; i++) {
+    buffer[i] = (char)('a' + i % 26);
+  }
+  buffer[length] = '\0';
+}
+
+// Výsledek jednoho měření
+typedef struct {
+  const char *workload;
+  const char *dist;
+  size_t key_length;
+  size_t keys;
+  size_t ops;
+  double ns_per_op;
+  double percentiles[4];  // p50, p90, p99, p99.9
+  double allocs_per_op;
+  double bytes_per_key;
+} bench_result_t;
+
+static const double bench_quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+
+// Nastavení běhu
+typedef struct {
+  bool json;
+  bool printed;          // už byl vypsán alespoň jeden výsledek
+  uint64_t overhead;     // režie dvojice čtení hodin v ns
+  uint32_t *samples;     // doby jednotlivých operací
+} bench_t;
+
+static int bench_compare(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Medián režie dvou po sobě jdoucích čtení hodin
+static uint64_t bench_timer_overhead(uint32_t *samples) {
+  for (int i = 0; i < 10001; i++) {
+    uint64_t start = bench_ns();
+    samples[i] = (uint32_t)(bench_ns() - start);
+  }
+  qsort(samples, 10001, sizeof(uint32_t), bench_compare);
+  return samples[5000];
+}
+
+// Uloží dobu operace do samples[i] po odečtení režie hodin
+static inline void bench_sample(bench_t *bench, size_t i, uint64_t start) {
+  uint64_t elapsed = bench_ns() - start;
+  elapsed = elapsed > bench->overhead ? elapsed - bench->overhead : 0;
+  bench->samples[i] = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+}
+
+static void bench_percentiles(bench_t *bench, bench_result_t *result) {
+  qsort(bench->samples, result->ops, sizeof(uint32_t), bench_compare);
+  for (int i = 0; i < 4; i++) {
+    size_t index = (size_t)(bench_quantiles[i] * (result->ops - 1));
+    result->percentiles[i] = bench->samples[index];
+  }
+}
+
+static double bench_bytes_per_key(ht_table_t *table) {
+  ht_stats_t stats;
+  ht_stats(table, &stats);
+  return stats.count > 0 ? (double)stats.bytes / stats.count : 0;
+}
+
+static void bench_print(bench_t *bench, const bench_result_t *result) {
+  const double *p = result->percentiles;
+  if (bench->json) {
+    printf("%s{\"backend\":\"%s\",\"workload\":\"%s\",\"dist\":\"%s\","
+           "\"key_length\":%zu,\"keys\":%zu,\"ops\":%zu,\"ns_per_op\":%.1f,"
+           "\"p50_ns\":%.0f,\"p90_ns\":%.0f,\"p99_ns\":%.0f,"
+           "\"p999_ns\":%.0f,\"allocs_per_op\":%.4f,"
+           "\"bytes_per_key\":%.1f}",
+           bench->printed ? ",\n" : "[\n", BENCH_BACKEND, result->workload,
+           result->dist, result->key_length, result->keys, result->ops,
+           result->ns_per_op, p[0], p[1], p[2], p[3], result->allocs_per_op,
+           result->bytes_per_key);
+  } else {
+    printf("%s,%s,%s,%zu,%zu,%zu,%.1f,%.0f,%.0f,%.0f,%.0f,%.4f,%.1f\n",
+           BENCH_BACKEND, result->workload, result->dist, result->key_length,
+           result->keys, result->ops, result->ns_per_op, p[0], p[1], p[2],
+           p[3], result->allocs_per_op, result->bytes_per_key);
+  }
+  bench->printed = true;
+  fflush(stdout);
+}
+
+/*
+ * Vložení keys klíčů do prázdné tabulky. Malé tabulky se plní opakovaně,
+ * aby měření mělo alespoň ops operací; ht_delete_all mezi opakováními se
+ * do doby nezapočítává. Tabulka zůstane naplněná.
+ */
+static void bench_insert(bench_t *bench, ht_table_t *table, char *keys,
+                         size_t count, size_t length, size_t ops) {
+  size_t rounds = ops / count > 0 ? ops / count : 1;
+  bench_result_t result = {"insert", "none", length, count, rounds * count,
+                           0, {0}, 0, 0};
+  uint64_t elapsed = 0;
+  size_t allocs = 0;
+  for (size_t round = 0; round < rounds; round++) {
+    ht_delete_all(table);
+    size_t before = bench_allocs;
+    uint64_t start = bench_ns();
+    for (size_t i = 0; i < count; i++) {
+      ht_insert(table, keys + i * (length + 1), (float)i);
+    }
+    elapsed += bench_ns() - start;
+    allocs += bench_allocs - before;
+  }
+  result.ns_per_op = (double)elapsed / result.ops;
+  result.allocs_per_op = (double)allocs / result.ops;
+  result.bytes_per_key = bench_bytes_per_key(table);
+
+  for (size_t round = 0; round < rounds; round++) {
+    ht_delete_all(table);
+    for (size_t i = 0; i < count; i++) {
+      uint64_t start = bench_ns();
+      ht_insert(table, keys + i * (length + 1), (float)i);
+      bench_sample(bench, round * count + i, start);
+    }
+  }
+  bench_percentiles(bench, &result);
+  bench_print(bench, &result);
+}
+
+/*
+ * ops vyhledání klíčů z lookups (každý klíč má length + 1 bajtů).
+ */
+static void bench_lookup(bench_t *bench, ht_table_t *table, char *lookups,
+                         bench_result_t *result) {
+  size_t stride = result->key_length + 1;
+  double sum = 0;
+  size_t before = bench_allocs;
+  uint64_t start = bench_ns();
+  for (size_t i = 0; i < result->ops; i++) {
+    float *value = ht_get(table, lookups + i * stride);
+    if (value != NULL) {
+      sum += *value;
+    }
+  }
+  result->ns_per_op = (double)(bench_ns() - start) / result->ops;
+  result->allocs_per_op = (double)(bench_allocs - before) / result->ops;
+  result->bytes_per_key = bench_bytes_per_key(table);
+
+  for (size_t i = 0; i < result->ops; i++) {
+    uint64_t op_start = bench_ns();
+    float *value = ht_get(table, lookups + i * stride);
+    bench_sample(bench, i, op_start);
+    if (value != NULL) {
+      sum += *value;
+    }
+  }
+  fprintf(stderr, "checksum %.0f\n", sum);
+  bench_percentiles(bench, result);
+  bench_print(bench, result);
+}
+
+/*
+ * Střídání mazání a vkládání: operace i smaže klíč na místě slots[i]
+ * pole live a nahradí ho novým klíčem fresh[i]. Počet prvků tabulky se
+ * nemění.
+ */
+static void bench_churn(bench_t *bench, ht_table_t *table, char **live,
+                        const size_t *slots, char *fresh,
+                        bench_result_t *result) {
+  size_t stride = result->key_length + 1;
+  size_t before = bench_allocs;
+  uint64_t start = bench_ns();
+  for (size_t i = 0; i < result->ops; i++) {
+    char *key = fresh + i * stride;
+    ht_delete(table, live[slots[i]]);
+    ht_insert(table, key, (float)i);
+    live[slots[i]] = key;
+  }
+  result->ns_per_op = (double)(bench_ns() - start) / result->ops;
+  result->allocs_per_op = (double)(bench_allocs - before) / result->ops;
+  result->bytes_per_key = bench_bytes_per_key(table);
+
+  fresh += result->ops * stride;
+  for (size_t i = 0; i < result->ops; i++) {
+    char *key = fresh + i * stride;
+    uint64_t op_start = bench_ns();
+    ht_delete(table, live[slots[i]]);
+    ht_insert(table, key, (float)i);
+    bench_sample(bench, i, op_start);
+    live[slots[i]] = key;
+  }
+  bench_percentiles(bench, result);
+  bench_print(bench, result);
+}
+
+// Naplní prázdnou tabulku klíči keys (bez měření)
+static void bench_fill(ht_table_t *table, char *keys, size_t count,
+                       size_t length) {
+  ht_delete_all(table);
+  for (size_t i = 0; i < count; i++) {
+    ht_insert(table, keys + i * (length + 1), (float)i);
+  }
+}
+
+/*
+ * Všechna měření pro tabulku s count klíči délky length.
+ */
+static void bench_run(bench_t *bench, size_t count, size_t length, size_t ops,
+                      int workloads, int dists) {
+  size_t stride = length + 1;
+  uint64_t rng = 0x9e3779b97f4a7c15u ^ count ^ (length << 40);
+  char *keys = bench_alloc(count * stride);
+  for (size_t i = 0; i < count; i++) {
+    bench_key(keys + i * stride, i, length);
+  }
+  char *lookups = bench_alloc(2 * ops * stride);
+  char **live = bench_alloc(count * sizeof(char *));
+  size_t *slots = bench_alloc(ops * sizeof(size_t));
+  bench_zipf_t zipf = {0};
+  if (dists & BENCH_ZIPF) {
+    bench_zipf_init(&zipf, count, &rng);
+  }
+
+  ht_table_t table;
+  ht_init(&table);
+  if (workloads & BENCH_INSERT) {
+    bench_insert(bench, &table, keys, count, length, ops);
+  } else {
+    bench_fill(&table, keys, count, length);
+  }
+
+  for (int dist = BENCH_UNIFORM; dist <= BENCH_ZIPF; dist <<= 1) {
+    if (!(dists & dist)) {
+      continue;
+    }
+    const char *dist_name = dist == BENCH_ZIPF ? "zipf" : "uniform";
+    for (int workload = BENCH_HIT; workload <= BENCH_MISS; workload <<= 1) {
+      if (!(workloads & workload)) {
+        continue;
+      }
+      // Chybějící klíče mají indexy od count, vybírají se stejně
+      unsigned hits = workload == BENCH_HIT ? BENCH_HEAVY_PERCENT
+                                            : 100 - BENCH_HEAVY_PERCENT;
+      for (size_t i = 0; i < ops; i++) {
+        size_t pick = bench_pick(dist, &zipf, count, &rng);
+        bool hit = bench_next(&rng) % 100 < hits;
+        bench_key(lookups + i * stride, hit ? pick : count + pick, length);
+      }
+      bench_result_t result = {workload == BENCH_HIT ? "hit" : "miss",
+                               dist_name, length, count, ops, 0, {0}, 0, 0};
+      bench_lookup(bench, &table, lookups, &result);
+    }
+
+    if (workloads & BENCH_CHURN) {
+      // Nové klíče mají indexy od 2 * count, každý se vloží jen jednou
+      for (size_t i = 0; i < count; i++) {
+        live[i] = keys + i * stride;
+      }
+      for (size_t i = 0; i < ops; i++) {
+        slots[i] = bench_pick(dist, &zipf, count, &rng);
+      }
+      for (size_t i = 0; i < 2 * ops; i++) {
+        bench_key(lookups + i * stride, 2 * count + i, length);
+      }
+      bench_result_t result = {"churn", dist_name, length, count, ops,
+                               0, {0}, 0, 0};
+      bench_churn(bench, &table, live, slots, lookups, &result);
+      bench_fill(&table, keys, count, length);
+    }
+  }
+
+  ht_delete_all(&table);
+  free(zipf.ranks);
+  free(keys);
+  free(lookups);
+  free(live);
+  free(slots);
+}
+
+// Seznam čísel oddělených čárkami, vrací jejich počet (0 při chybě)
+static size_t bench_parse_sizes(const char *text, size_t *values) {
+  size_t count = 0;
+  char *end;
+  while (count < BENCH_MAX_LIST) {
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text || value == 0) {
+      return 0;
+    }
+    values[count++] = (size_t)value;
+    if (*end != ',') {
+      return *end == '\0' ? count : 0;
+    }
+    text = end + 1;
+  }
+  return 0;
+}
+
+// Seznam jmen oddělených čárkami jako bitová maska podle names (0 při chybě)
+static int bench_parse_names(const char *text, const char *const names[],
+                             int count) {
+  int mask = 0;
+  while (*text != '\0') {
+    size_t length = strcspn(text, ",");
+    int i = 0;
+    while (i < count && (strlen(names[i]) != length ||
+                         strncmp(names[i], text, length) != 0)) {
+      i++;
+    }
+    if (i == count) {
+      return 0;
+    }
+    mask |= 1 << i;
+    text += length + (text[length] == ',');
+  }
+  return mask;
+}
+
+static void bench_usage(void) {
+  fprintf(stderr,
+          "usage: bench [-s sizes] [-k key_lengths] [-w insert,hit,miss,churn]"
+          " [-d uniform,zipf] [-n ops] [-f csv|json]\n");
+  exit(2);
+}
+
+int main(int argc, char *argv[]) {
+  static const char *const workload_names[] = {"insert", "hit", "miss",
+                                               "churn"};
+  static const char *const dist_names[] = {"uniform", "zipf"};
+  size_t sizes[BENCH_MAX_LIST];
+  size_t lengths[BENCH_MAX_LIST];
+  size_t size_count = bench_parse_sizes(BENCH_SIZES, sizes);
+  size_t length_count = bench_parse_sizes(BENCH_KEY_LENGTHS, lengths);
+  int workloads = BENCH_INSERT | BENCH_HIT | BENCH_MISS | BENCH_CHURN;
+  int dists = BENCH_UNIFORM | BENCH_ZIPF;
+  size_t ops = BENCH_OPS;
+  bench_t bench = {false, false, 0, NULL};
+
+  int option;
+  while ((option = getopt(argc, argv, "s:k:w:d:n:f:")) != -1) {
+    switch (option) {
+    case 's':
+      size_count = bench_parse_sizes(optarg, sizes);
+      break;
+    case 'k':
+      length_count = bench_parse_sizes(optarg, lengths);
+      break;
+    case 'w':
+      workloads = bench_parse_names(optarg, workload_names, 4);
+      break;
+    case 'd':
+      dists = bench_parse_names(optarg, dist_names, 2);
+      break;
+    case 'n':
+      ops = (size_t)strtoull(optarg, NULL, 10);
+      break;
+    case 'f':
+      bench.json = strcmp(optarg, "json") == 0;
+      if (!bench.json && strcmp(optarg, "csv") != 0) {
+        bench_usage();
+      }
+      break;
+    default:
+      bench_usage();
+    }
+  }
+  if (size_count == 0 || length_count == 0 || workloads == 0 || dists == 0 ||
+      ops == 0) {
+    bench_usage();
+  }
+  for (size_t i = 0; i < length_count; i++) {
+    if (lengths[i] < BENCH_MIN_KEY_LENGTH) {
+      lengths[i] = BENCH_MIN_KEY_LENGTH;
+    }
+  }
+
+  // Vkládání malé tabulky se opakuje, vzorků může být víc než ops
+  size_t samples = ops > 10001 ? ops : 10001;
+  for (size_t i = 0; i < size_count; i++) {
+    size_t rounds = ops / sizes[i] > 0 ? ops / sizes[i] : 1;
+    samples = rounds * sizes[i] > samples ? rounds * sizes[i] : samples;
+  }
+  bench.samples = bench_alloc(samples * sizeof(uint32_t));
+  bench.overhead = bench_timer_overhead(bench.samples);
+
+  if (!bench.json) {
+    printf("backend,workload,dist,key_length,keys,ops,ns_per_op,p50_ns,"
+           "p90_ns,p99_ns,p999_ns,allocs_per_op,bytes_per_key\n");
+  }
+  for (size_t i = 0; i < size_count; i++) {
+    for (size_t j = 0; j < length_count; j++) {
+      bench_run(&bench, sizes[i], lengths[j], ops, workloads, dists);
+    }
+  }
+  if (bench.json) {
+    printf(bench.printed ? "\n]\n" : "[]\n");
+  }
+  free(bench.samples);
+  return 0;
+}
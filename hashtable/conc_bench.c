@@ -0,0 +1,135 @@
+/*
+ * Měření propustnosti souběžné tabulky (make conc_bench)
+ *
+ * Tabulka se naplní polovinou z BENCH_KEYS klíčů a poté ji 1..N vláken
+ * současně čte a mění. Každé vlákno provede BENCH_OPS operací s náhodnými
+ * klíči; čtení tak zhruba z poloviny končí neúspěchem. Měří se dvě směsi:
+ * read-mostly (95 % ht_get, 5 % ht_insert/ht_delete) a mixed (50/50).
+ *
+ * Použití: ./conc_bench [max_threads]   (výchozí je počet procesorů)
+ * Výstup je CSV: mix,threads,ops,seconds,mops,speedup
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hashtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_KEYS (1 << 18)
+#define BENCH_OPS 2000000
+#define BENCH_KEY_LENGTH 24
+
+typedef struct {
+  ht_table_t *table;
+  char (*keys)[BENCH_KEY_LENGTH];
+  unsigned read_percent;
+  uint64_t rng;
+  float sink;
+} bench_thread_t;
+
+static uint64_t bench_next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void *bench_worker(void *arg) {
+  bench_thread_t *thread = arg;
+  float sink = 0;
+  for (int i = 0; i < BENCH_OPS; i++) {
+    uint64_t r = bench_next(&thread->rng);
+    char *key = thread->keys[(r >> 16) % BENCH_KEYS];
+    unsigned op = (unsigned)(r % 100);
+    if (op < thread->read_percent) {
+      // Hodnotu čteme uvnitř ht_read_lock, jinak by ji mohl writer uvolnit
+      ht_read_lock();
+      float *value = ht_get(thread->table, key);
+      if (value != NULL) {
+        sink += *value;
+      }
+      ht_read_unlock();
+    } else if (op % 2 == 0) {
+      ht_insert(thread->table, key, (float)i);
+    } else {
+      ht_delete(thread->table, key);
+    }
+  }
+  thread->sink = sink;
+  return NULL;
+}
+
+/*
+ * Jedno měření: vrací dobu v sekundách, za kterou threads vláken
+ * provede BENCH_OPS operací každé.
+ */
+static double bench_run(char (*keys)[BENCH_KEY_LENGTH], unsigned read_percent,
+                        int threads) {
+  ht_table_t table;
+  ht_init(&table);
+  for (int i = 0; i < BENCH_KEYS; i += 2) {
+    ht_insert(&table, keys[i], (float)i);
+  }
+
+  pthread_t *ids = malloc(threads * sizeof(pthread_t));
+  bench_thread_t *args = malloc(threads * sizeof(bench_thread_t));
+  double start = bench_now();
+  for (int t = 0; t < threads; t++) {
+    args[t] = (bench_thread_t){&table, keys, read_percent,
+                               0x9e3779b97f4a7c15u * (t + 1), 0};
+    pthread_create(&ids[t], NULL, bench_worker, &args[t]);
+  }
+  for (int t = 0; t < threads; t++) {
+    pthread_join(ids[t], NULL);
+  }
+  double seconds = bench_now() - start;
+
+  free(ids);
+  free(args);
+  ht_delete_all(&table);
+  return seconds;
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (max_threads < 1) {
+    max_threads = 1;
+  }
+
+  char (*keys)[BENCH_KEY_LENGTH] = malloc(BENCH_KEYS * sizeof(*keys));
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    snprintf(keys[i], BENCH_KEY_LENGTH, "user:%08x:%i", i * 2654435761u, i);
+  }
+
+  const struct {
+    const char *name;
+    unsigned read_percent;
+  } mixes[] = {{"read-mostly", 95}, {"mixed", 50}};
+
+  printf("mix,threads,ops,seconds,mops,speedup\n");
+  for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++) {
+    double base = 0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+      double seconds = bench_run(keys, mixes[m].read_percent, threads);
+      double mops = (double)threads * BENCH_OPS / seconds / 1e6;
+      if (threads == 1) {
+        base = mops;
+      }
+      printf("%s,%i,%i,%.3f,%.2f,%.2f\n", mixes[m].name, threads,
+             threads * BENCH_OPS, seconds, mops, mops / base);
+      fflush(stdout);
+    }
+  }
+
+  free(keys);
+  return 0;
+}
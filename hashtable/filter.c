@@ -0,0 +1,192 @@
+/*
+ * Filtr příslušnosti před tabulkou s rozptýlenými položkami
+ *
+ * Blokový počítací Bloomův filtr (viz filter.h). Tabulka do něj vkládá
+ * hash každého nového klíče a při smazání ho odebírá; vyhledání klíče,
+ * který filtr odmítne, skončí bez přístupu do pole tabulky. Velikost pole
+ * čítačů se odvozuje od požadované pravděpodobnosti falešné shody
+ * a počtu klíčů a lze ji shora omezit; nad limitem filtr dál funguje,
+ * jen s vyšší pravděpodobností falešné shody.
+ */
+
+#include "filter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Rozdělení klíčů do bloků není rovnoměrné, proto má blokový filtr při
+ * stejné paměti vyšší pravděpodobnost falešné shody než klasický. Počet
+ * čítačů na klíč se o tento poměr zvětší.
+ */
+#define HT_FILTER_BLOCK_OVERHEAD 1.2
+
+// ln(2), M_LN2 není součástí standardu C11
+#define HT_FILTER_LN2 0.69314718055994530942
+
+/*
+ * Inicializace vypnutého filtru.
+ */
+void ht_filter_init(ht_filter_t *filter) {
+  filter->words = NULL;
+  filter->blocks = 0;
+  filter->capacity = 0;
+  filter->max_bytes = 0;
+  filter->fp_rate = 0;
+  filter->counters = 0;
+  filter->hashes = 0;
+}
+
+/*
+ * Počet bloků pro capacity klíčů, omezený na max_bytes (alespoň jeden).
+ */
+static size_t ht_filter_blocks_for(const ht_filter_t *filter,
+                                   size_t capacity) {
+  if (capacity < HT_FILTER_MIN_CAPACITY) {
+    capacity = HT_FILTER_MIN_CAPACITY;
+  }
+  size_t blocks =
+      (size_t)ceil(capacity * filter->counters / HT_FILTER_COUNTERS);
+  if (filter->max_bytes > 0 && blocks > filter->max_bytes / HT_FILTER_BLOCK) {
+    blocks = filter->max_bytes / HT_FILTER_BLOCK;
+  }
+  return blocks > 0 ? blocks : 1;
+}
+
+/*
+ * Alokace vynulovaného pole čítačů o zadaném počtu bloků.
+ */
+static uint64_t *ht_filter_alloc(size_t blocks) {
+  uint64_t *words = aligned_alloc(HT_FILTER_BLOCK, blocks * HT_FILTER_BLOCK);
+  if (words != NULL) {
+    memset(words, 0, blocks * HT_FILTER_BLOCK);
+  }
+  return words;
+}
+
+/*
+ * Nastavení filtru s pravděpodobností falešné shody fp_rate a pamětí
+ * nejvýše max_bytes (0 = bez omezení) pro capacity klíčů. Filtr je po
+ * nastavení prázdný, klíče do něj vloží volající. Pro fp_rate mimo
+ * interval (0,1) se filtr vypne.
+ *
+ * Klasický Bloomův filtr potřebuje -ln(p) / ln(2)^2 čítačů na klíč
+ * a ln(2) násobek tohoto počtu čítačů na jeden klíč. Při chybě alokace
+ * vrací false a filtr zůstane beze změny.
+ */
+bool ht_filter_setup(ht_filter_t *filter, double fp_rate, size_t max_bytes,
+                     size_t capacity) {
+  if (!(fp_rate > 0 && fp_rate < 1)) {
+    ht_filter_free(filter);
+    return true;
+  }
+
+  ht_filter_t setup = *filter;
+  setup.fp_rate = fp_rate;
+  setup.max_bytes = max_bytes;
+  double counters = -log(fp_rate) / (HT_FILTER_LN2 * HT_FILTER_LN2);
+  setup.counters = counters * HT_FILTER_BLOCK_OVERHEAD;
+  setup.hashes = (int)lround(counters * HT_FILTER_LN2);
+  if (setup.hashes < 1) {
+    setup.hashes = 1;
+  } else if (setup.hashes > HT_FILTER_MAX_HASHES) {
+    setup.hashes = HT_FILTER_MAX_HASHES;
+  }
+  setup.capacity = capacity;
+  setup.blocks = ht_filter_blocks_for(&setup, capacity);
+  setup.words = ht_filter_alloc(setup.blocks);
+  if (setup.words == NULL) {
+    return false;
+  }
+  free(filter->words);
+  *filter = setup;
+  return true;
+}
+
+/*
+ * Přizpůsobení velikosti filtru pro capacity klíčů. Vrací true, pokud
+ * se pole čítačů vyměnilo za nové, prázdné; volající pak musí do filtru
+ * znovu vložit všechny klíče. Pokud se počet bloků nemění (například na
+ * limitu paměti) nebo se nové pole nepodaří alokovat, filtr si ponechá
+ * dosavadní čítače a vrací false.
+ */
+bool ht_filter_reserve(ht_filter_t *filter, size_t capacity) {
+  if (filter->words == NULL) {
+    return false;
+  }
+  filter->capacity = capacity;
+  size_t blocks = ht_filter_blocks_for(filter, capacity);
+  if (blocks == filter->blocks) {
+    return false;
+  }
+  uint64_t *words = ht_filter_alloc(blocks);
+  if (words == NULL) {
+    return false;
+  }
+  free(filter->words);
+  filter->words = words;
+  filter->blocks = blocks;
+  return true;
+}
+
+/*
+ * Odebrání všech klíčů z filtru (velikost a nastavení zůstanou).
+ */
+void ht_filter_clear(ht_filter_t *filter) {
+  if (filter->words != NULL) {
+    memset(filter->words, 0, filter->blocks * HT_FILTER_BLOCK);
+  }
+}
+
+/*
+ * Uvolnění pole čítačů; filtr zůstane vypnutý.
+ */
+void ht_filter_free(ht_filter_t *filter) {
+  free(filter->words);
+  ht_filter_init(filter);
+}
+
+/*
+ * Vložení klíče s daným hashem (zvýší jeho čítače, nejvýše do nasycení).
+ */
+void ht_filter_add(ht_filter_t *filter, uint64_t hash) {
+  if (filter->words == NULL) {
+    return;
+  }
+  uint64_t *block = ht_filter_block(filter, hash);
+  uint64_t bits = ht_filter_mix(hash);
+  for (int i = 0; i < filter->hashes; i++, bits >>= 7) {
+    unsigned counter = (unsigned)(bits % HT_FILTER_COUNTERS);
+    unsigned shift = counter % 16 * 4;
+    if (((block[counter / 16] >> shift) & 0xf) != HT_FILTER_SATURATED) {
+      block[counter / 16] += (uint64_t)1 << shift;
+    }
+  }
+}
+
+/*
+ * Odebrání klíče s daným hashem, který byl do filtru vložen. Nasycené
+ * čítače se nesnižují — nevíme, kolik klíčů je skutečně sdílí.
+ */
+void ht_filter_remove(ht_filter_t *filter, uint64_t hash) {
+  if (filter->words == NULL) {
+    return;
+  }
+  uint64_t *block = ht_filter_block(filter, hash);
+  uint64_t bits = ht_filter_mix(hash);
+  for (int i = 0; i < filter->hashes; i++, bits >>= 7) {
+    unsigned counter = (unsigned)(bits % HT_FILTER_COUNTERS);
+    unsigned shift = counter % 16 * 4;
+    uint64_t value = (block[counter / 16] >> shift) & 0xf;
+    if (value != 0 && value != HT_FILTER_SATURATED) {
+      block[counter / 16] -= (uint64_t)1 << shift;
+    }
+  }
+}
+
+/*
+ * Paměť pole čítačů v bajtech.
+ */
+size_t ht_filter_bytes(const ht_filter_t *filter) {
+  return filter->words != NULL ? filter->blocks * HT_FILTER_BLOCK : 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Hlavičkový soubor pro filtr příslušnosti před tabulkou s rozptýlenými
+ * položkami.
+ */
+
+#ifndef IAL_HASHTABLE_FILTER_H
+#define IAL_HASHTABLE_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Blokový počítací Bloomův filtr. Pole čítačů je rozdělené do bloků
+ * velikosti jednoho řádku cache (HT_FILTER_BLOCK bajtů) po
+ * HT_FILTER_COUNTERS čtyřbitových čítačích. Horní bity hashe klíče vyberou
+ * blok a všech hashes čítačů klíče leží v něm, takže odmítnutí klíče
+ * načte jediný řádek cache.
+ *
+ * Čítače (místo bitů) umožňují klíče z filtru i odebírat. Čítač, který
+ * dosáhl HT_FILTER_SATURATED, se už nemění, filtr proto nikdy neodmítne
+ * klíč, který do něj byl vložen.
+ */
+#define HT_FILTER_BLOCK 64
+#define HT_FILTER_WORDS (HT_FILTER_BLOCK / sizeof(uint64_t))
+#define HT_FILTER_COUNTERS (HT_FILTER_BLOCK * 2)
+#define HT_FILTER_SATURATED 15
+
+/*
+ * Nejvyšší počet čítačů na klíč (7 bitů promíchaného hashe na čítač)
+ * a nejmenší počet klíčů, pro který se filtr dimenzuje.
+ */
+#define HT_FILTER_MAX_HASHES 8
+#define HT_FILTER_MIN_CAPACITY 64
+
+// Filtr příslušnosti (words == NULL, pokud je vypnutý)
+typedef struct ht_filter {
+  uint64_t *words;       // čítače, bloky zarovnané na HT_FILTER_BLOCK
+  size_t blocks;         // počet bloků
+  size_t capacity;       // počet klíčů, pro který je filtr dimenzován
+  size_t max_bytes;      // nejvyšší velikost pole čítačů (0 = bez omezení)
+  double fp_rate;        // požadovaná pravděpodobnost falešné shody
+  double counters;       // čítačů na klíč pro fp_rate
+  int hashes;            // počet čítačů jednoho klíče
+} ht_filter_t;
+
+void ht_filter_init(ht_filter_t *filter);
+bool ht_filter_setup(ht_filter_t *filter, double fp_rate, size_t max_bytes,
+                     size_t capacity);
+bool ht_filter_reserve(ht_filter_t *filter, size_t capacity);
+void ht_filter_clear(ht_filter_t *filter);
+void ht_filter_free(ht_filter_t *filter);
+void ht_filter_add(ht_filter_t *filter, uint64_t hash);
+void ht_filter_remove(ht_filter_t *filter, uint64_t hash);
+size_t ht_filter_bytes(const ht_filter_t *filter);
+
+/*
+ * Blok klíče: horních 32 bitů hashe vynásobených počtem bloků (bez dělení,
+ * stejně jako index pole zřetězené tabulky).
+ */
+static inline uint64_t *ht_filter_block(const ht_filter_t *filter,
+                                        uint64_t hash) {
+  size_t block = (size_t)(((hash >> 32) * (uint64_t)filter->blocks) >> 32);
+  return filter->words + block * HT_FILTER_WORDS;
+}
+
+/*
+ * Promíchání hashe, ze kterého se po 7 bitech berou čítače v bloku. Bity
+ * výběru bloku tak neurčují čítače a dolní bity (u otevřeného adresování
+ * řídicí bajt) se rozprostřou do všech.
+ */
+static inline uint64_t ht_filter_mix(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdu;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/*
+ * Vrátí false, pokud klíč s daným hashem ve filtru určitě není; true,
+ * pokud v něm může být (a vždy, když je filtr vypnutý).
+ */
+static inline bool ht_filter_may_contain(const ht_filter_t *filter,
+                                         uint64_t hash) {
+  if (filter->words == NULL) {
+    return true;
+  }
+  const uint64_t *block = ht_filter_block(filter, hash);
+  uint64_t bits = ht_filter_mix(hash);
+  for (int i = 0; i < filter->hashes; i++, bits >>= 7) {
+    unsigned counter = (unsigned)(bits % HT_FILTER_COUNTERS);
+    if (((block[counter / 16] >> (counter % 16 * 4)) & 0xf) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Měření zmrazené tabulky (make freeze_bench)
+ *
+ * Naplní zřetězenou tabulku klíči, změří paměť na klíč a rychlost ht_get
+ * v náhodném pořadí, tabulku zmrazí funkcí ht_freeze a totéž změří znovu.
+ * Počty klíčů lze zadat argumenty (výchozí 1000000 a 10000000).
+ *
+ * Výstup je CSV: layout,keys,seconds,bytes_per_key,get_ns
+ * (seconds je doba plnění, u zmrazené tabulky doba ht_freeze)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hashtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_KEY_LENGTH 24
+#define BENCH_LOOKUPS 2000000
+
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static uint64_t bench_next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// Průměrná doba ht_get v nanosekundách pro klíče v náhodném pořadí
+static double bench_get(ht_table_t *table, char (*keys)[BENCH_KEY_LENGTH],
+                        size_t count) {
+  uint64_t rng = 0x9e3779b97f4a7c15u;
+  double sum = 0;
+  double start = bench_now();
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    float *value = ht_get(table, keys[bench_next(&rng) % count]);
+    if (value != NULL) {
+      sum += *value;
+    }
+  }
+  double seconds = bench_now() - start;
+  fprintf(stderr, "checksum %.0f\n", sum);
+  return seconds * 1e9 / BENCH_LOOKUPS;
+}
+
+static void bench_run(size_t count) {
+  char (*keys)[BENCH_KEY_LENGTH] = malloc(count * sizeof(*keys));
+  if (keys == NULL) {
+    fprintf(stderr, "freeze_bench: out of memory\n");
+    exit(1);
+  }
+  for (size_t i = 0; i < count; i++) {
+    snprintf(keys[i], BENCH_KEY_LENGTH, "user:%zu", i);
+  }
+
+  ht_table_t table;
+  ht_init(&table);
+  double start = bench_now();
+  for (size_t i = 0; i < count; i++) {
+    ht_insert(&table, keys[i], (float)i);
+  }
+  double seconds = bench_now() - start;
+  printf("chained,%zu,%.3f,%.1f,%.1f\n", count, seconds,
+         (double)ht_memory_usage(&table) / count,
+         bench_get(&table, keys, count));
+
+  start = bench_now();
+  if (!ht_freeze(&table)) {
+    fprintf(stderr, "freeze_bench: ht_freeze failed\n");
+    exit(1);
+  }
+  seconds = bench_now() - start;
+  printf("frozen,%zu,%.3f,%.1f,%.1f\n", count, seconds,
+         (double)ht_memory_usage(&table) / count,
+         bench_get(&table, keys, count));
+  fflush(stdout);
+
+  ht_delete_all(&table);
+  free(keys);
+}
+
+int main(int argc, char *argv[]) {
+  printf("layout,keys,seconds,bytes_per_key,get_ns\n");
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      bench_run((size_t)atol(argv[i]));
+    }
+  } else {
+    bench_run(1000000);
+    bench_run(10000000);
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Rozptylovací funkce společná pro všechny varianty tabulky
+ * s rozptýlenými položkami.
+ */
+
+#include "hashtable.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/random.h>
+#endif
+
+int HT_SIZE = HT_DEFAULT_SIZE;
+bool HT_RANDOM_SEED = true;
+
+// Stav náhradního generátoru semínek (0 = dosud nenačtený)
+static _Atomic uint64_t ht_seed_state;
+
+// Konstanty rozptylovací funkce (lichá čísla s dobře rozloženými bity)
+#define HT_HASH_P0 0xa0761d6478bd642full
+#define HT_HASH_P1 0xe7037ed1a0b428dbull
+#define HT_HASH_P2 0x8ebc6af09c88c6e3ull
+
+/*
+ * Vynásobí dvě 64bitová čísla a vrátí XOR horní a dolní poloviny
+ * 128bitového součinu. Každý bit výsledku tak závisí na všech bitech
+ * obou vstupů.
+ */
+static inline uint64_t ht_mum(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 ht_u128_t;
+  ht_u128_t r = (ht_u128_t)a * b;
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+  uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+  return lo ^ hi;
+#endif
+}
+
+// Načtení 8 resp. 4 bajtů z libovolně zarovnané adresy
+static inline uint64_t ht_read64(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t ht_read32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/*
+ * Rozptylovací funkce, která bajtům data přidělí 64bitové číslo. Dlouhé
+ * klíče zpracovává po 16 bajtech, krátké (do 16 bajtů) načte nejvýše čtyřmi
+ * překrývajícími se čteními bez cyklu. Různá semínka dávají nezávislé
+ * rozptylovací funkce.
+ */
+uint64_t ht_hash_bytes(const void *data, size_t length, uint64_t seed) {
+  const unsigned char *p = data;
+  uint64_t a, b;
+
+  seed ^= ht_mum(seed ^ HT_HASH_P0, HT_HASH_P1);
+  if (length <= 16) {
+    if (length >= 4) {
+      size_t shift = (length >> 3) << 2;
+      a = (ht_read32(p) << 32) | ht_read32(p + shift);
+      b = (ht_read32(p + length - 4) << 32) | ht_read32(p + length - 4 - shift);
+    } else if (length > 0) {
+      a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) |
+          p[length - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = length;
+    while (i > 16) {
+      seed = ht_mum(ht_read64(p) ^ HT_HASH_P1, ht_read64(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = ht_read64(p + i - 16);
+    b = ht_read64(p + i - 8);
+  }
+  return ht_mum(HT_HASH_P1 ^ length,
+                ht_mum(a ^ HT_HASH_P1, b ^ seed) ^ HT_HASH_P2);
+}
+
+/*
+ * Rozptylovací funkce pro řetězcový klíč s nulovým semínkem. Ideální
+ * rozptylovací funkce by měla rozprostírat klíče rovnoměrně po všech
+ * indexech.
+ */
+uint64_t get_hash(char *key) {
+  return ht_hash_bytes(key, strlen(key), 0);
+}
+
+/*
+ * Připraví klíč s předem spočítaným hashem pro ht_search_key, ht_get_key
+ * a ht_insert_key. Klíč se nekopíruje.
+ */
+void ht_key_init(ht_key_t *handle, const char *data, size_t length,
+                 uint64_t seed) {
+  handle->data = data;
+  handle->length = length;
+  handle->seed = seed;
+  handle->hash = ht_hash_bytes(data, length, seed);
+}
+
+/*
+ * Náhradní semínko pro systém bez /dev/urandom: počáteční stav se smíchá
+ * z času a adresy a každé další semínko je promíchaný následující stav
+ * (splitmix64). Taková semínka se tabulkám jen liší, útočník, který zná
+ * jedno z nich, z něj další odvodí.
+ */
+static uint64_t ht_fallback_seed(void) {
+  uint64_t state = atomic_load(&ht_seed_state);
+  if (state == 0) {
+    uint64_t initial = (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32) ^
+                       (uint64_t)(uintptr_t)&state;
+    initial |= 1;  // Nulou se označuje nenačtený stav
+    atomic_compare_exchange_strong(&ht_seed_state, &state, initial);
+  }
+
+  // Krok a promíchání podle splitmix64
+  uint64_t x = atomic_fetch_add(&ht_seed_state, 0x9e3779b97f4a7c15u) +
+               0x9e3779b97f4a7c15u;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9u;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebu;
+  return x ^ (x >> 31);
+}
+
+/*
+ * Vrátí náhodné semínko pro novou tabulku. Každé semínko se bere zvlášť
+ * ze systému (v Linuxu getrandom bez souboru a alokace, jinde čtením
+ * /dev/urandom), takže ze semínka jedné tabulky nelze odvodit semínka
+ * ostatních. Selže-li obojí, vrátí ht_fallback_seed.
+ */
+uint64_t ht_random_seed(void) {
+  uint64_t seed;
+#ifdef __linux__
+  if (getrandom(&seed, sizeof(seed), 0) == (ssize_t)sizeof(seed)) {
+    return seed;
+  }
+#endif
+  FILE *random = fopen("/dev/urandom", "rb");
+  if (random != NULL) {
+    // Bez vyrovnávací paměti se přečte jen 8 bajtů
+    setbuf(random, NULL);
+    bool filled = fread(&seed, sizeof(seed), 1, random) == 1;
+    fclose(random);
+    if (filled) {
+      return seed;
+    }
+  }
+  return ht_fallback_seed();
+}
@@ -5,123 +5,1164 @@
  * funkcí implementujte tabulku s rozptýlenými položkami s explicitně
  * zretězenými synonymy.
  *
- * Při implementaci uvažujte velikost tabulky HT_SIZE.
+ * Každá tabulka si sama spravuje velikost svého pole. Při překročení faktoru
+ * naplnění se pole zvětší, po hromadném mazání se zmenší. Přesun prvků do
+ * nového pole (přehashování) probíhá postupně — každé vložení a smazání
+ * přesune jen několik indexů starého pole, takže žádná jednotlivá operace
+ * nezaplatí přehashování celé tabulky.
+ *
+ * Pole tabulky obsahuje u každého seznamu synonym kromě ukazatele na první
+ * prvek i otisk jeho hashe a příznak, zda seznam pokračuje (ht_bucket_t).
+ * Hledání chybějícího klíče v seznamu s jediným prvkem tak skončí v poli
+ * a na prvek nesáhne; prvky přitom zůstávají mimo pole, takže se při
+ * přehashování nepřesouvají.
+ *
+ * Tabulku lze uložit funkcí ht_save a později namapovat funkcí
+ * ht_open_mmap. Namapovaná tabulka vyhledává přímo v obrazu souboru;
+ * teprve první změna obraz převede na běžné seznamy synonym.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "hashtable.h"
+#include "ht_common.h"
+#include "parallel.h"
+#include <fcntl.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Velikost prvku s klíčem o délce length (včetně nulového terminátoru)
+#define HT_ITEM_SIZE(length) (sizeof(ht_item_t) + (length) + 1)
 
-int HT_SIZE = MAX_HT_SIZE;
+// Velikost záznamu prvku v obrazu tabulky (zarovnaná na HT_IMAGE_ALIGN)
+#define HT_IMAGE_RECORD_SIZE(length)                                           \
+  ((HT_ITEM_SIZE(length) + HT_IMAGE_ALIGN - 1) & ~(size_t)(HT_IMAGE_ALIGN - 1))
 
 /*
- * Rozptylovací funkce která přidělí zadanému klíči index z intervalu
- * <0,HT_SIZE-1>. Ideální rozptylovací funkce by měla rozprostírat klíče
- * rovnoměrně po všech indexech. Zamyslete sa nad kvalitou zvolené funkce.
+ * Převede hash na index z intervalu <0,size-1> bez celočíselného dělení:
+ * horních 32 bitů hashe vynásobíme velikostí pole a vezmeme horní polovinu
+ * součinu. Velikost pole proto nemusí být prvočíslem ani mocninou dvojky.
  */
-int get_hash(char *key) {
-  int result = 1;
-  int length = strlen(key);
-  for (int i = 0; i < length; i++) {
-    result += key[i];
+static inline size_t ht_index(uint64_t hash, size_t size) {
+  return (size_t)(((hash >> 32) * (uint64_t)size) >> 32);
+}
+
+// Dolních 32 bitů hashe prvního prvku seznamu leží v poli (ht_bucket_t)
+static inline uint32_t ht_hash_tag(uint64_t hash) {
+  return (uint32_t)hash;
+}
+
+/*
+ * Nastaví začátek seznamu synonym na head a obnoví otisk a příznak
+ * pokračování seznamu uložené v poli. Volá se po každé změně prvního
+ * prvku seznamu nebo jeho následníka.
+ */
+static inline void ht_set_head(ht_bucket_t *bucket, ht_item_t *head) {
+  bucket->head = head;
+  bucket->tag = head != NULL ? ht_hash_tag(head->hash) : 0;
+  bucket->overflow = head != NULL && head->next != NULL;
+}
+
+/*
+ * Vrátí ukazatel na začátek seznamu synonym, do kterého patří klíč se
+ * zadaným hashem. Během přehashování leží klíče z dosud nepřesunutých
+ * indexů stále ve starém poli.
+ */
+static ht_bucket_t *ht_bucket(ht_table_t *table, uint64_t hash) {
+  if (table->old_buckets != NULL) {
+    size_t index = ht_index(hash, table->old_size);
+    if (index >= table->rehash_index) {
+      return &table->old_buckets[index];
+    }
   }
-  return (result % HT_SIZE);
+  return &table->buckets[ht_index(hash, table->size)];
+}
+
+/*
+ * Přesune nejvýše steps neprázdných indexů starého pole do aktuálního pole.
+ * Aby krok zůstal levný i nad řídkým polem, projde nejvýše 10 * steps
+ * prázdných indexů. Po přesunutí posledního indexu staré pole uvolní.
+ */
+static void ht_rehash_step(ht_table_t *table, int steps) {
+  int empty_visits = steps * 10;
+
+  while (table->old_buckets != NULL && steps > 0 &&
+         table->rehash_index < table->old_size) {
+    ht_item_t *item = table->old_buckets[table->rehash_index].head;
+    if (item == NULL) {
+      table->rehash_index++;
+      if (--empty_visits == 0) {
+        break;
+      }
+      continue;
+    }
+
+    // Přepojíme celý seznam synonym do nového pole
+    while (item != NULL) {
+      ht_item_t *next_item = item->next;
+      ht_bucket_t *bucket = &table->buckets[ht_index(item->hash, table->size)];
+      item->next = bucket->head;
+      ht_set_head(bucket, item);
+      item = next_item;
+    }
+    ht_set_head(&table->old_buckets[table->rehash_index++], NULL);
+    steps--;
+  }
+
+  if (table->old_buckets != NULL && table->rehash_index >= table->old_size) {
+    free(table->old_buckets);
+    table->old_buckets = NULL;
+    table->old_size = 0;
+    table->rehash_index = 0;
+  }
+}
+
+/*
+ * Zahájí postupné přehashování do nového pole o velikosti new_size.
+ * Pokud se nové pole nepodaří alokovat, tabulka pracuje dál se starým.
+ */
+static void ht_resize(ht_table_t *table, size_t new_size) {
+  ht_bucket_t *buckets = calloc(new_size, sizeof(ht_bucket_t));
+  if (buckets == NULL) {
+    return;
+  }
+  table->old_buckets = table->buckets;
+  table->old_size = table->size;
+  table->rehash_index = 0;
+  table->buckets = buckets;
+  table->size = new_size;
+}
+
+/*
+ * Najde prvek s klíčem o známé délce a hashi v namapovaném obrazu.
+ * Záznamy jednoho seznamu synonym leží v obrazu za sebou, takže se
+ * místo ukazatelů next jen posouvá na další záznam.
+ */
+static ht_item_t *ht_image_find(ht_table_t *table, const char *key,
+                                size_t length, uint64_t hash) {
+  ht_image_t *image = table->image;
+  size_t index = ht_index(hash, image->size);
+  char *record = (char *)image + image->buckets[index];
+  char *end = (char *)image + image->buckets[index + 1];
+  size_t visited = 0;
+
+  while (record < end) {
+    ht_item_t *item = (ht_item_t *)record;
+    visited++;
+    if (item->hash == hash && item->length == length &&
+        memcmp(item + 1, key, length) == 0) {
+      ht_count_probes(table, visited);
+      return item;
+    }
+    record += HT_IMAGE_RECORD_SIZE(item->length);
+  }
+  ht_count_probes(table, visited);
+  return NULL;
+}
+
+/*
+ * Zavolá visit pro každý prvek tabulky (včetně prvků dosud nepřesunutých
+ * ze starého pole). Prvky zmrazené tabulky se předávají jako dočasné kopie.
+ */
+static void ht_for_each(ht_table_t *table,
+                        void (*visit)(ht_item_t *item, void *context),
+                        void *context) {
+  ht_frozen_t *frozen = table->frozen;
+  for (size_t slot = 0; frozen != NULL && slot < frozen->count; slot++) {
+    ht_item_t item;
+    item.key = frozen->keys + frozen->key_offsets[slot];
+    item.value = frozen->values[slot];
+    item.length = frozen->key_offsets[slot + 1] - frozen->key_offsets[slot] - 1;
+    item.next = NULL;
+    item.hash = ht_hash_bytes(item.key, item.length, frozen->seed);
+    visit(&item, context);
+  }
+  for (size_t i = 0; table->buckets != NULL && i < table->size; i++) {
+    for (ht_item_t *item = table->buckets[i].head; item != NULL;
+         item = item->next) {
+      visit(item, context);
+    }
+  }
+  for (size_t i = table->rehash_index;
+       table->old_buckets != NULL && i < table->old_size; i++) {
+    for (ht_item_t *item = table->old_buckets[i].head; item != NULL;
+         item = item->next) {
+      visit(item, context);
+    }
+  }
+}
+
+/*
+ * Vloží do filtru tabulky hashe všech jejích prvků (po zapnutí filtru,
+ * změně jeho velikosti nebo semínka). Prvky namapovaného obrazu se do
+ * filtru nevkládají, obraz se prohledává bez filtru a filtr se naplní
+ * až při převodu na seznamy synonym.
+ */
+static void ht_filter_visit(ht_item_t *item, void *context) {
+  ht_filter_add(context, item->hash);
+}
+
+static void ht_filter_fill(ht_table_t *table) {
+  ht_filter_clear(&table->filter);
+  ht_for_each(table, ht_filter_visit, &table->filter);
+}
+
+/*
+ * Převede namapovaný obraz na běžné seznamy synonym (před první změnou
+ * tabulky) a obraz odmapuje. Při chybě alokace zůstane tabulka
+ * namapovaná a funkce vrátí false.
+ */
+static bool ht_promote(ht_table_t *table) {
+  ht_image_t *image = table->image;
+  size_t size = (size_t)image->size;
+  ht_bucket_t *buckets = calloc(size, sizeof(ht_bucket_t));
+  if (buckets == NULL) {
+    return false;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    char *record = (char *)image + image->buckets[i];
+    char *end = (char *)image + image->buckets[i + 1];
+    while (record < end) {
+      ht_item_t *source = (ht_item_t *)record;
+      ht_item_t *item = (ht_item_t *)ht_arena_alloc(
+          &table->arena, HT_ITEM_SIZE(source->length));
+      if (item == NULL) {
+        ht_arena_release(&table->arena);
+        free(buckets);
+        return false;
+      }
+      memcpy(item, source, HT_ITEM_SIZE(source->length));
+      item->key = (char *)(item + 1);
+      item->next = buckets[i].head;
+      ht_set_head(&buckets[i], item);
+      record += HT_IMAGE_RECORD_SIZE(source->length);
+    }
+  }
+
+  munmap(image, table->image_size);
+  table->image = NULL;
+  table->image_size = 0;
+  table->buckets = buckets;
+  table->size = size;
+  ht_filter_fill(table);
+  return true;
+}
+
+/*
+ * Místo klíče ve zmrazené tabulce: hash klíče se promíchá s pilotem jeho
+ * skupiny a výsledek se převede na index z intervalu <0,count-1>.
+ */
+static inline size_t ht_frozen_slot(uint64_t hash, uint32_t pilot,
+                                    size_t count) {
+  uint64_t x = hash ^ ((uint64_t)pilot * 0x9e3779b97f4a7c15u);
+  x ^= x >> 31;
+  x *= 0xbf58476d1ce4e5b9u;
+  x ^= x >> 29;
+  return ht_index(x, count);
+}
+
+/*
+ * Najde místo klíče ve zmrazené tabulce (jeden pokus a jedno porovnání
+ * klíče). Pokud klíč v tabulce není, vrací SIZE_MAX.
+ */
+static size_t ht_frozen_find(ht_frozen_t *frozen, const char *key,
+                             size_t length, uint64_t hash) {
+  uint32_t pilot = frozen->pilots[ht_index(hash, frozen->groups)];
+  size_t slot = ht_frozen_slot(hash, pilot, frozen->count);
+  uint32_t start = frozen->key_offsets[slot];
+  if (frozen->key_offsets[slot + 1] - start == length + 1 &&
+      memcmp(frozen->keys + start, key, length) == 0) {
+    return slot;
+  }
+  return SIZE_MAX;
+}
+
+static void ht_frozen_free(ht_frozen_t *frozen) {
+  free(frozen->pilots);
+  free(frozen->key_offsets);
+  free(frozen->keys);
+  free(frozen->values);
+  free(frozen);
+}
+
+/*
+ * Převede zmrazenou tabulku zpět na seznamy synonym (před první změnou
+ * tabulky). Při chybě alokace zůstane tabulka zmrazená a funkce vrátí
+ * false.
+ */
+static bool ht_thaw(ht_table_t *table) {
+  ht_frozen_t *frozen = table->frozen;
+  size_t size = frozen->count > table->min_size ? frozen->count
+                                                : table->min_size;
+  ht_bucket_t *buckets = calloc(size, sizeof(ht_bucket_t));
+  if (buckets == NULL) {
+    return false;
+  }
+
+  for (size_t slot = 0; slot < frozen->count; slot++) {
+    char *key = frozen->keys + frozen->key_offsets[slot];
+    size_t length = frozen->key_offsets[slot + 1] -
+                    frozen->key_offsets[slot] - 1;
+    ht_item_t *item = (ht_item_t *)ht_arena_alloc(&table->arena,
+                                                  HT_ITEM_SIZE(length));
+    if (item == NULL) {
+      ht_arena_release(&table->arena);
+      free(buckets);
+      return false;
+    }
+    item->key = (char *)(item + 1);
+    memcpy(item->key, key, length + 1);
+    item->value = frozen->values[slot];
+    item->length = (uint32_t)length;
+    item->referenced = 0;
+    item->hash = ht_hash_bytes(key, length, frozen->seed);
+    ht_bucket_t *bucket = &buckets[ht_index(item->hash, size)];
+    item->next = bucket->head;
+    ht_set_head(bucket, item);
+  }
+
+  ht_frozen_free(frozen);
+  table->frozen = NULL;
+  table->buckets = buckets;
+  table->size = size;
+  ht_filter_fill(table);
+  return true;
 }
 
 /*
  * Inicializace tabulky — zavolá sa před prvním použitím tabulky.
+ *
+ * Pole tabulky o velikosti HT_SIZE se alokuje až při prvním vložení.
+ * Tabulka začíná s náhodným semínkem (při vypnutém HT_RANDOM_SEED
+ * s nulovým), jiné lze nastavit funkcí ht_set_seed.
  */
 void ht_init(ht_table_t *table) {
-  for(int i = 0; i < HT_SIZE; i++){
-    (*table)[i]= NULL;
+  table->buckets = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->min_size = HT_SIZE > 0 ? (size_t)HT_SIZE : 1;
+  table->capacity = 0;
+  table->clock_hand = 0;
+  table->old_buckets = NULL;
+  table->old_size = 0;
+  table->rehash_index = 0;
+  table->seed = HT_RANDOM_SEED ? ht_random_seed() : 0;
+  ht_arena_init(&table->arena);
+  table->image = NULL;
+  table->image_size = 0;
+  table->frozen = NULL;
+  ht_filter_init(&table->filter);
+  table->threads = 1;
+#if HT_STATS
+  memset(&table->stats, 0, sizeof(table->stats));
+#endif
+}
+
+/*
+ * Statistiky alokátoru prvků tabulky: rezervovaná paměť, paměť živých
+ * prvků, paměť připravená k recyklaci a podíl nevyužité paměti.
+ */
+void ht_alloc_stats(ht_table_t *table, ht_arena_stats_t *stats) {
+  ht_arena_stats(&table->arena, stats);
+}
+
+/*
+ * Nastavení semínka rozptylovací funkce tabulky.
+ *
+ * Pokud tabulka již obsahuje prvky, dokončí rozpracované přehashování
+ * a všechny prvky ihned rozmístí podle nového semínka.
+ */
+void ht_set_seed(ht_table_t *table, uint64_t seed) {
+  if (table->image != NULL && !ht_promote(table)) {
+    return;  // Hashe v obrazu platí jen pro jeho semínko
+  }
+  if (table->frozen != NULL && !ht_thaw(table)) {
+    return;  // Piloty zmrazené tabulky platí jen pro její semínko
+  }
+  table->seed = seed;
+  if (table->buckets == NULL) {
+    return;
   }
+
+  while (table->old_buckets != NULL) {
+    ht_rehash_step(table, HT_REHASH_STEP);
+  }
+
+  // Odpojíme všechny prvky do jednoho seznamu a znovu je rozmístíme
+  ht_item_t *list = NULL;
+  for (size_t i = 0; i < table->size; i++) {
+    ht_item_t *item = table->buckets[i].head;
+    while (item != NULL) {
+      ht_item_t *next_item = item->next;
+      item->next = list;
+      list = item;
+      item = next_item;
+    }
+    ht_set_head(&table->buckets[i], NULL);
+  }
+  while (list != NULL) {
+    ht_item_t *next_item = list->next;
+    list->hash = ht_hash_bytes(list->key, list->length, seed);
+    ht_bucket_t *bucket = &table->buckets[ht_index(list->hash, table->size)];
+    list->next = bucket->head;
+    ht_set_head(bucket, list);
+    list = next_item;
+  }
+  ht_filter_fill(table);
 }
 
 /*
- * Vyhledání prvku v tabulce.
+ * Zapnutí filtru příslušnosti (viz filter.h) s pravděpodobností falešné
+ * shody fp_rate, jehož pole čítačů zabere nejvýše max_bytes bajtů
+ * (0 = bez omezení). Filtr se dimenzuje podle počtu prvků a s tabulkou
+ * roste; na limitu paměti zůstane, jen roste pravděpodobnost falešné
+ * shody. Pro fp_rate mimo interval (0,1) se filtr vypne, ht_delete_all
+ * ho vypne také.
  *
- * V případě úspěchu vrací ukazatel na nalezený prvek; v opačném případě vrací
- * hodnotu NULL.
+ * Vyhledání klíče, který filtr odmítne, vrátí NULL bez procházení
+ * seznamu synonym. Vkládání filtr nepoužívá: seznam synonym prochází
+ * tak jako tak kvůli ochraně před zahlcením kolizemi (HT_FLOOD_CHAIN).
+ * Při chybě alokace vrací false a nastavení filtru se nezmění.
  */
-ht_item_t *ht_search(ht_table_t *table, char *key) {
-  // Získáme index pomocí hashovací funkce
-  int index = get_hash(key);
-  ht_item_t *item = (*table)[index];
+bool ht_set_filter(ht_table_t *table, double fp_rate, size_t max_bytes) {
+  size_t capacity = table->count * 2;
+  if (!ht_filter_setup(&table->filter, fp_rate, max_bytes, capacity)) {
+    return false;
+  }
+  ht_filter_fill(table);
+  return true;
+}
 
-  // Procházíme prvky na daném indexu (spojený seznam v případě kolizí)
-  while (item != NULL) {
-    if (strcmp(item->key, key) == 0) {
-      // Pokud najdeme odpovídající klíč, vrátíme ukazatel na tento prvek
-      return item;
+/*
+ * Vyhodí jeden prvek algoritmem CLOCK (viz ht_set_capacity). Ručička
+ * prochází po seznamech synonym aktuální pole a za ním i dosud
+ * nepřesunutou část starého pole (přesunuté indexy jsou prázdné), takže
+ * se rozpracované přehashování kvůli vyhazování nedokončuje. Prvkům
+ * s nastaveným referenčním bitem ho vynuluje a první prvek bez něj
+ * vyhodí. Nejpozději po dvou obězích obou polí tak prvek najde vždy.
+ * Vrací false, pokud je tabulka prázdná.
+ */
+static bool ht_evict(ht_table_t *table) {
+  if (table->count == 0) {
+    return false;
+  }
+
+  for (;;) {
+    size_t hands = table->size + table->old_size;
+    if (table->clock_hand >= hands) {
+      table->clock_hand = 0;
+    }
+    ht_bucket_t *bucket =
+        table->clock_hand < table->size
+            ? &table->buckets[table->clock_hand]
+            : &table->old_buckets[table->clock_hand - table->size];
+    ht_item_t **link = &bucket->head;
+    for (ht_item_t *item = *link; item != NULL; item = *link) {
+      if (!item->referenced) {
+        *link = item->next;
+        ht_set_head(bucket, bucket->head);
+        ht_filter_remove(&table->filter, item->hash);
+        ht_arena_free(&table->arena, item, HT_ITEM_SIZE(item->length));
+        table->count--;
+        HT_COUNT(table, evictions);
+        return true;
+      }
+      item->referenced = 0;
+      link = &item->next;
     }
-    item = item->next;  // Pokračujeme na další prvek seznamu
+    table->clock_hand++;
   }
-  return NULL;
 }
 
 /*
- * Vložení nového prvku do tabulky.
+ * Omezení počtu prvků tabulky na capacity (0 = bez omezení). Tabulka se
+ * pak chová jako cache: když je plná, ht_insert a ostatní vkládající
+ * funkce před vložením nového klíče vyhodí jiný prvek přibližným LRU
+ * (algoritmus CLOCK). Každé nalezení prvku nastaví jeho referenční bit
+ * (uložený v nejvyšším bitu délky klíče, prvek se tedy nezvětší)
+ * a ručička procházející pole vyhodí první prvek, který od jejího
+ * posledního průchodu použit nebyl. Nově vložený prvek referenční bit
+ * nemá, klíče použité jen jednou se proto vyhazují dříve než opakovaně
+ * hledané. Vyhozený prvek se vrátí do arény, ze které se hned přidělí
+ * nový.
  *
- * Pokud prvek s daným klíčem už v tabulce existuje, nahraďte jeho hodnotu.
+ * Pokud má tabulka víc prvků, vyhodí se nadbytečné hned. Počty vyhozených
+ * prvků a úspěšnost hledání vrací ht_stats. Při chybě alokace (převodu
+ * namapovaného obrazu nebo zmrazené tabulky) vrací false a kapacita se
+ * nezmění.
+ */
+bool ht_set_capacity(ht_table_t *table, size_t capacity) {
+  if (capacity > 0 && table->count > capacity) {
+    if (table->image != NULL && !ht_promote(table)) {
+      return false;  // Ošetření chyby při alokaci paměti
+    }
+    if (table->frozen != NULL && !ht_thaw(table)) {
+      return false;  // Ošetření chyby při alokaci paměti
+    }
+  }
+  table->capacity = capacity;
+  while (capacity > 0 && table->count > capacity) {
+    ht_evict(table);
+  }
+  return true;
+}
+
+/*
+ * Označí nalezený prvek jako použitý pro ht_evict. Bit se zapisuje jen
+ * u tabulky s omezenou kapacitou a jen při změně, aby čtení zbytečně
+ * nešpinilo řádky cache; do namapovaného obrazu se nezapisuje.
+ */
+static inline void ht_touch(ht_table_t *table, ht_item_t *item) {
+  if (table->capacity > 0 && !item->referenced && table->image == NULL) {
+    item->referenced = 1;
+  }
+}
+
+/*
+ * Vrátí true, pokud filtr tabulky vylučuje klíč s daným hashem. Prvky
+ * namapovaného obrazu ve filtru nejsou, v obrazu se proto hledá vždy.
+ */
+static inline bool ht_filtered(ht_table_t *table, uint64_t hash) {
+  if (table->image != NULL || ht_filter_may_contain(&table->filter, hash)) {
+    return false;
+  }
+  HT_COUNT(table, filtered);
+  return true;
+}
+
+/*
+ * Porovná prvek s hledaným klíčem. Bajty klíče se porovnávají jen tehdy,
+ * když se shoduje celý hash i délka klíče.
+ */
+static inline bool ht_item_matches(ht_item_t *item, const char *key,
+                                   size_t length, uint64_t hash) {
+  return item->hash == hash && item->length == length &&
+         memcmp(item->key, key, length) == 0;
+}
+
+/*
+ * Najde prvek s klíčem o známé délce a hashi. Pokud visited není NULL,
+ * uloží do něj počet prošlých prvků seznamu synonym.
+ */
+static ht_item_t *ht_find(ht_table_t *table, const char *key, size_t length,
+                          uint64_t hash, size_t *visited) {
+  size_t walked = 0;
+  ht_item_t *item = NULL;
+  if (table->image != NULL) {
+    item = ht_image_find(table, key, length, hash);
+  } else if (table->buckets != NULL) {
+    // Získáme seznam synonym pomocí hashovací funkce
+    ht_bucket_t *bucket = ht_bucket(table, hash);
+
+    // Jediný prvek seznamu vyloučí otisk v poli bez načtení prvku, jinak
+    // procházíme prvky na daném indexu (spojený seznam v případě kolizí)
+    if (bucket->head != NULL && !bucket->overflow &&
+        bucket->tag != ht_hash_tag(hash)) {
+      walked = 1;
+    } else {
+      item = bucket->head;
+    }
+    while (item != NULL) {
+      walked++;
+      if (ht_item_matches(item, key, length, hash)) {
+        // Pokud najdeme odpovídající klíč, vrátíme ukazatel na tento prvek
+        break;
+      }
+      item = item->next;  // Pokračujeme na další prvek seznamu
+    }
+    ht_count_probes(table, walked);
+  } else {
+    ht_count_probes(table, 0);
+  }
+  if (visited != NULL) {
+    *visited = walked;
+  }
+  return item;
+}
+
+/*
+ * Vyhledání prvku podle klíče o délce length, který nemusí končit nulovým
+ * znakem (např. úsek vstupního bufferu). Jinak stejné jako ht_search.
  *
- * Při implementaci využijte funkci ht_search. Pri vkládání prvku do seznamu
- * synonym zvolte nejefektivnější možnost a vložte prvek na začátek seznamu.
+ * U zmrazené tabulky a namapovaného obrazu je prvek jen kopií pro čtení,
+ * která platí do dalšího volání ht_search.
  */
-void ht_insert(ht_table_t *table, char *key, float value) {
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length) {
+  ht_key_t handle;
+  ht_key_init(&handle, key, length, table->seed);
+  return ht_search_key(table, &handle);
+}
+
+/*
+ * Vyhledání prvku podle klíče s předem spočítaným hashem (viz ht_key_t).
+ * Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_key(ht_table_t *table, const ht_key_t *handle) {
+  const char *key = handle->data;
+  size_t length = handle->length;
+  uint64_t hash = ht_handle_hash(handle, table->seed);
+  if (table->frozen != NULL) {
+    // Zmrazená tabulka prvky nemá, vrátíme pohled na nalezené místo
+    ht_frozen_t *frozen = table->frozen;
+    size_t slot = ht_frozen_find(frozen, key, length, hash);
+    ht_count_probes(table, 1);
+    ht_count_search(table, slot != SIZE_MAX);
+    if (slot == SIZE_MAX) {
+      return NULL;
+    }
+    frozen->view.key = frozen->keys + frozen->key_offsets[slot];
+    frozen->view.value = frozen->values[slot];
+    frozen->view.length = (uint32_t)length;
+    frozen->view.next = NULL;
+    frozen->view.hash = hash;
+    return &frozen->view;
+  }
+  if (ht_filtered(table, hash)) {
+    ht_count_probes(table, 0);
+    ht_count_search(table, false);
+    return NULL;
+  }
+
+  ht_item_t *item = ht_find(table, key, length, hash, NULL);
+  ht_count_search(table, item != NULL);
+  if (item != NULL && table->image != NULL) {
+    // Obraz je jen pro čtení a záznam nemá ukazatel na klíč, vrátíme
+    // kopii s klíčem odvozeným z umístění záznamu
+    table->image_view = *item;
+    table->image_view.key = (char *)(item + 1);
+    return &table->image_view;
+  }
+  if (item != NULL) {
+    ht_touch(table, item);
+  }
+  return item;
+}
+
+/*
+ * Vložení prvku s klíčem o známé délce a hashi (viz ht_insert). Seznam
+ * synonym se projde jen jednou. Pokud prvek s klíčem už existuje, jeho
+ * hodnota se přepíše jen při replace. Vrací existující nebo nový prvek,
+ * při chybě NULL.
+ */
+static ht_item_t *ht_insert_hashed(ht_table_t *table, const char *key,
+                                   size_t length, uint64_t hash, float value,
+                                   bool replace) {
+  if (length > HT_MAX_KEY_LENGTH) {
+    return NULL;  // Délka klíče se do prvku nevejde
+  }
+  if (table->image != NULL && !ht_promote(table)) {
+    return NULL;  // Ošetření chyby při alokaci paměti
+  }
+  if (table->frozen != NULL && !ht_thaw(table)) {
+    return NULL;  // Ošetření chyby při alokaci paměti
+  }
+
   // Nejprve zjistíme, zda prvek s tímto klíčem již existuje
-  ht_item_t *item = ht_search(table, key);
+  size_t chain;
+  ht_item_t *item = ht_find(table, key, length, hash, &chain);
 
   if (item != NULL) {
     // Pokud prvek s daným klíčem existuje, aktualizujeme jeho hodnotu
-    item->value = value;
-  } else {
-    // Pokud prvek neexistuje, vytvoříme nový a vložíme jej do tabulky
+    if (replace) {
+      item->value = value;
+    }
+    ht_touch(table, item);
+    HT_COUNT(table, updates);
+    return item;
+  }
 
-    // Získáme index podle hashovací funkce
-    int index = get_hash(key);
+  // Plná tabulka s omezenou kapacitou uvolní místo pro nový prvek
+  if (table->capacity > 0 && table->count >= table->capacity) {
+    ht_evict(table);
+  }
 
-    // Vytvoříme nový prvek
-    ht_item_t *new_item = (ht_item_t *)malloc(sizeof(ht_item_t));
-    if (new_item == NULL) {
-      return;  // Ošetření chyby při alokaci paměti
+  // První vložení alokuje pole o počáteční velikosti
+  if (table->buckets == NULL) {
+    table->buckets = calloc(table->min_size, sizeof(ht_bucket_t));
+    if (table->buckets == NULL) {
+      return NULL;  // Ošetření chyby při alokaci paměti
     }
+    table->size = table->min_size;
+  }
 
-    // Alokujeme paměť pro klíč a zkopírujeme řetězec ručně
-    new_item->key = (char *)malloc(strlen(key) + 1);  // +1 pro nulový terminátor
-    if (new_item->key == NULL) {
-      free(new_item);  // Ošetření chyby při alokaci
-      return;
-    }
-    strcpy(new_item->key, key);  // Zkopírujeme klíč do nově alokované paměti
+  // Posuneme rozpracované přehashování, případně zahájíme nové
+  ht_rehash_step(table, HT_REHASH_STEP);
+  if (table->old_buckets == NULL &&
+      table->count >= table->size * HT_MAX_LOAD) {
+    ht_resize(table, table->size * 2);
+  }
+
+  // Prvek vložíme do seznamu, ve kterém ho bude hledat ht_search
+  ht_bucket_t *bucket = ht_bucket(table, hash);
+
+  // Vytvoříme nový prvek jedinou alokací, klíč leží hned za hlavičkou
+  ht_item_t *new_item = (ht_item_t *)ht_arena_alloc(
+      &table->arena, HT_ITEM_SIZE(length));
+  if (new_item == NULL) {
+    return NULL;  // Ošetření chyby při alokaci paměti
+  }
+  new_item->key = (char *)(new_item + 1);
+  memcpy(new_item->key, key, length);  // Zkopírujeme klíč a ukončíme ho
+  new_item->key[length] = '\0';
+
+  // Nastavíme hodnotu, délku a hash klíče
+  new_item->value = value;
+  new_item->length = (uint32_t)length;
+  new_item->referenced = 0;
+  new_item->hash = hash;
 
-    // Nastavíme hodnotu
-    new_item->value = value;
-    
-    // Vložíme nový prvek na začátek seznamu synonym
-    new_item->next = (*table)[index];  // Nastavíme nový prvek jako první v seznamu
-    (*table)[index] = new_item;        // Tabulka nyní ukazuje na nový prvek
+  // Vložíme nový prvek na začátek seznamu synonym
+  new_item->next = bucket->head;  // Nový prvek bude první v seznamu
+  ht_set_head(bucket, new_item);  // Tabulka nyní ukazuje na nový prvek
+  table->count++;
+  HT_COUNT(table, inserts);
+
+  // Filtr se zvětšuje s rezervou na dvojnásobek prvků
+  ht_filter_add(&table->filter, hash);
+  if (table->filter.words != NULL && table->count > table->filter.capacity &&
+      ht_filter_reserve(&table->filter, table->count * 2)) {
+    ht_filter_fill(table);
   }
+
+  // Příliš dlouhý seznam synonym značí cíleně kolidující klíče
+  size_t load = table->count / table->size;
+  if (chain + 1 > HT_FLOOD_CHAIN * (load > 1 ? load : 1)) {
+    HT_COUNT(table, reseeds);
+    ht_set_seed(table, ht_random_seed());
+  }
+  return new_item;
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahraďte jeho hodnotu.
+ *
+ * Délka a hash klíče se spočítají jen jednou a uloží se do nového prvku.
+ * Pri vkládání prvku do seznamu synonym zvolte nejefektivnější možnost
+ * a vložte prvek na začátek seznamu.
+ */
+void ht_insert(ht_table_t *table, char *key, float value) {
+  ht_upsert(table, key, value);
 }
 
 /*
- * Získání hodnoty z tabulky.
+ * Vložení prvku s klíčem o délce length, který nemusí končit nulovým
+ * znakem. Klíč se zkopíruje jen při vytvoření nového prvku.
+ */
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value) {
+  ht_insert_hashed(table, key, length, ht_hash_bytes(key, length, table->seed),
+                   value, true);
+}
+
+/*
+ * Vložení prvku s klíčem s předem spočítaným hashem (viz ht_key_t).
+ */
+void ht_insert_key(ht_table_t *table, const ht_key_t *key, float value) {
+  ht_insert_hashed(table, key->data, key->length,
+                   ht_handle_hash(key, table->seed), value, true);
+}
+
+/*
+ * Vložení nebo přepsání hodnoty jako ht_insert.
  *
- * V případě úspěchu vrací funkce ukazatel na hodnotu prvku, v opačném
- * případě hodnotu NULL.
+ * Vrací ukazatel na hodnotu prvku, který zůstává platný až do smazání
+ * prvku (přehashování prvky nepřesouvá), při chybě NULL.
+ */
+float *ht_upsert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  ht_item_t *item = ht_insert_hashed(
+      table, key, length, ht_hash_bytes(key, length, table->seed), value, true);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty, a pokud klíč v tabulce není, vložení prvku s hodnotou
+ * value. Klíč se hashuje jen jednou a seznam synonym se projde jen jednou.
  *
- * Při implementaci využijte funkci ht_search.
+ * Vrací ukazatel na hodnotu prvku (platný jako u ht_upsert), při chybě
+ * NULL.
+ */
+float *ht_get_or_insert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  ht_item_t *item = ht_insert_hashed(
+      table, key, length, ht_hash_bytes(key, length, table->seed), value, false);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty podle klíče o délce length, který nemusí končit nulovým
+ * znakem. Jinak stejné jako ht_get.
  */
-float *ht_get(ht_table_t *table, char *key) {
-  // Vyhledáme prvek pomocí funkce ht_search
-  ht_item_t *item = ht_search(table, key);
+float *ht_get_n(ht_table_t *table, const char *key, size_t length) {
+  ht_key_t handle;
+  ht_key_init(&handle, key, length, table->seed);
+  return ht_get_key(table, &handle);
+}
+
+/*
+ * Získání hodnoty podle klíče s předem spočítaným hashem (viz ht_key_t).
+ */
+float *ht_get_key(ht_table_t *table, const ht_key_t *handle) {
+  // Vyhledáme prvek stejně jako ht_search
+  const char *key = handle->data;
+  size_t length = handle->length;
+  uint64_t hash = ht_handle_hash(handle, table->seed);
+  if (table->frozen != NULL) {
+    size_t slot = ht_frozen_find(table->frozen, key, length, hash);
+    ht_count_probes(table, 1);
+    ht_count_search(table, slot != SIZE_MAX);
+    return slot != SIZE_MAX ? &table->frozen->values[slot] : NULL;
+  }
+  if (ht_filtered(table, hash)) {
+    ht_count_probes(table, 0);
+    ht_count_search(table, false);
+    return NULL;
+  }
+  ht_item_t *item = ht_find(table, key, length, hash, NULL);
+  ht_count_search(table, item != NULL);
 
   // Pokud je prvek nalezen, vrátíme ukazatel na jeho hodnotu
   if (item != NULL) {
+    ht_touch(table, item);
     return &(item->value);  // Vrátime ukazatel na hodnotu prvku
   }
   return NULL;
 }
 
+/*
+ * Dávkové získání hodnot: values[i] dostane výsledek ht_get(table, keys[i]).
+ *
+ * Klíče se zpracovávají po HT_BATCH_SIZE. Pro celou dávku se nejprve
+ * spočítají hashe a přednačtou se začátky seznamů, potom se seznamy všech
+ * klíčů procházejí střídavě po jednom prvku a další prvek se vždy jen
+ * přednačte. Než se ke klíči vrátíme, jeho prvek už je v cache, takže se
+ * čekání na paměť pro různé klíče překrývá.
+ */
+void ht_get_many(ht_table_t *table, char *keys[], size_t count,
+                 float *values[]) {
+  // Obraz a zmrazená tabulka seznamy synonym nemají
+  if (table->image != NULL || table->frozen != NULL) {
+    for (size_t i = 0; i < count; i++) {
+      values[i] = ht_get(table, keys[i]);
+    }
+    return;
+  }
+
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    char **batch_keys = keys + start;
+    float **batch_values = values + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+    ht_bucket_t *heads[HT_BATCH_SIZE];
+    ht_item_t *cursors[HT_BATCH_SIZE];
+    size_t visited[HT_BATCH_SIZE];
+
+    for (size_t i = 0; i < batch; i++) {
+      batch_values[i] = NULL;
+      visited[i] = 0;
+    }
+    if (table->buckets == NULL) {
+      for (size_t i = 0; i < batch; i++) {
+        ht_count_probes(table, 0);
+        ht_count_search(table, false);
+      }
+      continue;
+    }
+
+    // Hashe klíčů a přednačtení indexů pole (kromě klíčů odmítnutých
+    // filtrem)
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_keys[i]);
+      hashes[i] = ht_hash_bytes(batch_keys[i], lengths[i], table->seed);
+      heads[i] = NULL;
+      if (!ht_filtered(table, hashes[i])) {
+        heads[i] = ht_bucket(table, hashes[i]);
+        HT_PREFETCH(heads[i]);
+      }
+    }
+
+    // Přednačtení prvních prvků seznamů, které nevyloučí otisk v poli
+    for (size_t i = 0; i < batch; i++) {
+      cursors[i] = heads[i] != NULL ? heads[i]->head : NULL;
+      if (cursors[i] != NULL && !heads[i]->overflow &&
+          heads[i]->tag != ht_hash_tag(hashes[i])) {
+        cursors[i] = NULL;
+        visited[i] = 1;
+      }
+      HT_PREFETCH(cursors[i]);
+    }
+
+    // Seznamy procházíme střídavě, v každém kole o jeden prvek
+    size_t active = batch;
+    while (active > 0) {
+      active = 0;
+      for (size_t i = 0; i < batch; i++) {
+        ht_item_t *item = cursors[i];
+        if (item == NULL) {
+          continue;
+        }
+        visited[i]++;
+        if (ht_item_matches(item, batch_keys[i], lengths[i], hashes[i])) {
+          ht_touch(table, item);
+          batch_values[i] = &item->value;
+          cursors[i] = NULL;
+          continue;
+        }
+        cursors[i] = item->next;
+        if (cursors[i] != NULL) {
+          HT_PREFETCH(cursors[i]);
+          active++;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_count_probes(table, visited[i]);
+      ht_count_search(table, batch_values[i] != NULL);
+    }
+  }
+}
+
+/*
+ * Dávkové vložení count prvků (klíč a hodnota z items[i]).
+ *
+ * Vkládání mění tabulku, proto se prvky vkládají postupně; pro každou
+ * dávku se ale předem spočítají hashe a přednačtou seznamy, do kterých
+ * klíče patří.
+ */
+void ht_insert_many(ht_table_t *table, const ht_item_t items[], size_t count) {
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    const ht_item_t *batch_items = items + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_items[i].key);
+      hashes[i] = ht_hash_bytes(batch_items[i].key, lengths[i], table->seed);
+      if (table->buckets != NULL) {
+        HT_PREFETCH(ht_bucket(table, hashes[i]));
+      }
+    }
+    if (table->buckets != NULL) {
+      for (size_t i = 0; i < batch; i++) {
+        HT_PREFETCH(ht_bucket(table, hashes[i])->head);
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_insert_hashed(table, batch_items[i].key, lengths[i], hashes[i],
+                       batch_items[i].value, true);
+    }
+  }
+}
+
+// Vlákno paralelního vkládání a jeho výsledky
+typedef struct {
+  ht_arena_t arena;      // aréna vlákna, po skončení se připojí k tabulce
+  size_t inserts;        // vložené nové prvky
+  size_t updates;        // přepsané hodnoty
+  size_t longest;        // nejdelší prošlý seznam synonym
+  bool failed;           // chyba alokace
+#if HT_STATS
+  uint64_t probes[HT_STATS_PROBES];
+#endif
+} ht_builder_t;
+
+// Rozpracované paralelní vkládání
+typedef struct {
+  ht_table_t *table;
+  char **keys;
+  const float *values;
+  ht_partition_t partition;
+  ht_builder_t *builders;  // jeden pro každý úsek
+} ht_build_t;
+
+/*
+ * Úsek pole, do kterého patří klíč: úseky jsou souvislé části pole
+ * o přibližně stejném počtu seznamů synonym, vybrané stejně jako index
+ * horními bity hashe. Každý seznam tak patří celý jednomu úseku.
+ */
+static size_t ht_build_shard(uint64_t hash, const void *context) {
+  const ht_build_t *build = context;
+  size_t size = build->table->size;
+  return ht_index(hash, size) * build->partition.shards / size;
+}
+
+/*
+ * Vložení klíčů jednoho úseku. Vlákno mění jen seznamy svého úseku
+ * a prvky přiděluje z vlastní arény, takže nic nezamyká.
+ */
+static void ht_build_shard_items(void *context, int index) {
+  ht_build_t *build = context;
+  ht_table_t *table = build->table;
+  ht_partition_t *partition = &build->partition;
+  ht_builder_t *builder = &build->builders[index];
+
+  for (size_t i = partition->starts[index];
+       i < partition->starts[index + 1] && !builder->failed; i++) {
+    size_t key_index = partition->order[i];
+    const char *key = build->keys[key_index];
+    size_t length = strlen(key);
+    uint64_t hash = partition->hashes[key_index];
+    ht_bucket_t *bucket = &table->buckets[ht_index(hash, table->size)];
+    ht_item_t *item = bucket->head;
+    size_t chain = 0;
+    while (item != NULL && !ht_item_matches(item, key, length, hash)) {
+      chain++;
+      item = item->next;
+    }
+#if HT_STATS
+    size_t visited = chain + (item != NULL);
+    builder->probes[visited < HT_STATS_PROBES ? visited
+                                              : HT_STATS_PROBES - 1]++;
+#endif
+    if (item != NULL) {
+      item->value = build->values[key_index];
+      builder->updates++;
+      continue;
+    }
+
+    ht_item_t *new_item = length <= HT_MAX_KEY_LENGTH
+                              ? ht_arena_alloc(&builder->arena,
+                                               HT_ITEM_SIZE(length))
+                              : NULL;
+    if (new_item == NULL) {
+      builder->failed = true;  // Ošetření chyby při alokaci paměti
+      break;
+    }
+    new_item->key = (char *)(new_item + 1);
+    memcpy(new_item->key, key, length + 1);
+    new_item->value = build->values[key_index];
+    new_item->length = (uint32_t)length;
+    new_item->referenced = 0;
+    new_item->hash = hash;
+    new_item->next = bucket->head;
+    ht_set_head(bucket, new_item);
+    builder->inserts++;
+    builder->longest = chain + 1 > builder->longest ? chain + 1
+                                                    : builder->longest;
+  }
+}
+
+/*
+ * Paralelní vložení count prvků (klíč keys[i] s hodnotou values[i])
+ * pomocí threads vláken; výsledek je stejný jako po postupném ht_insert.
+ *
+ * Pole se nejprve zvětší pro všechny nové klíče (a dokončí se
+ * rozpracované přehashování), potom se pole rozdělí na threads úseků
+ * podle horních bitů hashe. Každé vlákno vkládá klíče jednoho úseku bez
+ * zamykání a přiděluje prvky z vlastní arény, kterou tabulka po skončení
+ * převezme. Čtení a ostatní funkce pak pracují s tabulkou jako obvykle;
+ * ht_delete_all ji uvolní stejným počtem vláken.
+ *
+ * U tabulky s omezenou kapacitou (ht_set_capacity) se klíče nad kapacitu
+ * vyhodí až po vložení všech, algoritmem CLOCK stejně jako při ht_insert.
+ *
+ * Tabulku nesmí během volání používat jiné vlákno. Při chybě alokace
+ * vrací false; klíče vložené do té doby v tabulce zůstanou.
+ */
+bool ht_build_parallel(ht_table_t *table, char *keys[], const float values[],
+                       size_t count, int threads) {
+  if (table->image != NULL && !ht_promote(table)) {
+    return false;  // Ošetření chyby při alokaci paměti
+  }
+  if (table->frozen != NULL && !ht_thaw(table)) {
+    return false;  // Ošetření chyby při alokaci paměti
+  }
+  if (threads < 1) {
+    threads = 1;
+  } else if (threads > HT_MAX_WORKERS) {
+    threads = HT_MAX_WORKERS;
+  }
+
+  // Pole zvětšíme předem, aby ho během vkládání nebylo třeba přehashovat
+  if (table->buckets == NULL) {
+    table->buckets = calloc(table->min_size, sizeof(ht_bucket_t));
+    if (table->buckets == NULL) {
+      return false;
+    }
+    table->size = table->min_size;
+  }
+  while (table->old_buckets != NULL) {
+    ht_rehash_step(table, HT_REHASH_STEP);
+  }
+  size_t size = table->size;
+  while ((table->count + count) > size * HT_MAX_LOAD) {
+    size *= 2;
+  }
+  if (size != table->size) {
+    ht_resize(table, size);
+    while (table->old_buckets != NULL) {
+      ht_rehash_step(table, HT_REHASH_STEP);
+    }
+  }
+
+  ht_build_t build = {table, keys, values, {0}, NULL};
+  size_t shards = (size_t)threads < table->size ? (size_t)threads
+                                                : table->size;
+  build.builders = calloc(shards, sizeof(ht_builder_t));
+  if (build.builders == NULL) {
+    return false;
+  }
+  if (!ht_partition(&build.partition, keys, count, table->seed, shards,
+                    ht_build_shard, &build, threads)) {
+    free(build.builders);
+    return false;
+  }
+  for (size_t i = 0; i < shards; i++) {
+    ht_arena_init(&build.builders[i].arena);
+  }
+  ht_parallel_run((int)shards, ht_build_shard_items, &build);
+
+  // Prvky vláken převezme tabulka
+  bool failed = false;
+  size_t longest = 0;
+  for (size_t i = 0; i < shards; i++) {
+    ht_builder_t *builder = &build.builders[i];
+    ht_arena_merge(&table->arena, &builder->arena);
+    table->count += builder->inserts;
+    failed = failed || builder->failed;
+    longest = builder->longest > longest ? builder->longest : longest;
+#if HT_STATS
+    table->stats.inserts += builder->inserts;
+    table->stats.updates += builder->updates;
+    for (int j = 0; j < HT_STATS_PROBES; j++) {
+      table->stats.probes[j] += builder->probes[j];
+    }
+#endif
+  }
+  ht_partition_free(&build.partition);
+  free(build.builders);
+  table->threads = threads > table->threads ? threads : table->threads;
+
+  if (table->filter.words != NULL) {
+    ht_filter_reserve(&table->filter, table->count * 2);
+    ht_filter_fill(table);
+  }
+
+  // Příliš dlouhý seznam synonym značí cíleně kolidující klíče
+  size_t load = table->count / table->size;
+  if (longest > HT_FLOOD_CHAIN * (load > 1 ? load : 1)) {
+    HT_COUNT(table, reseeds);
+    ht_set_seed(table, ht_random_seed());
+  }
+  while (table->capacity > 0 && table->count > table->capacity) {
+    ht_evict(table);
+  }
+  return !failed;
+}
+
 /*
  * Smazání prvku z tabulky.
  *
@@ -131,56 +1172,618 @@ float *ht_get(ht_table_t *table, char *key) {
  * Při implementaci NEPOUŽÍVEJTE funkci ht_search.
  */
 void ht_delete(ht_table_t *table, char *key) {
-  // Získáme index pomocí hashovací funkce
-  int index = get_hash(key);
-  ht_item_t *item = (*table)[index];
+  if (table->image != NULL && !ht_promote(table)) {
+    return;  // Ošetření chyby při alokaci paměti
+  }
+  if (table->frozen != NULL && !ht_thaw(table)) {
+    return;  // Ošetření chyby při alokaci paměti
+  }
+  if (table->buckets == NULL) {
+    return;
+  }
+
+  // Získáme seznam synonym pomocí hashovací funkce
+  size_t length = strlen(key);
+  uint64_t hash = ht_hash_bytes(key, length, table->seed);
+  ht_bucket_t *bucket = ht_bucket(table, hash);
+  ht_item_t *item = bucket->head;
   ht_item_t *prev = NULL;
+  size_t visited = 0;
 
   // Procházíme seznamem na daném indexu
   while (item != NULL) {
+    visited++;
     // Pokud najdeme prvek s odpovídajícím klíčem
-    if (strcmp(item->key, key) == 0) {
+    if (ht_item_matches(item, key, length, hash)) {
+      ht_count_probes(table, visited);
       // Pokud je prvek první v seznamu (prev == NULL)
       if (prev == NULL) {
         // Nastavíme začátek seznamu na další prvek
-        (*table)[index] = item->next;
-      } 
+        ht_set_head(bucket, item->next);
+      }
       else {
         // Propojíme předchozí prvek s dalším, čímž přeskočíme prvek ke smazání
         prev->next = item->next;
+        ht_set_head(bucket, bucket->head);  // Seznam mohl přestat pokračovat
       }
 
-      // Uvolníme alokovanou paměť pro klíč a samotný prvek
-      free(item->key);
-      free(item);
+      // Vrátíme prvek i s klíčem do arény k dalšímu použití
+      ht_filter_remove(&table->filter, item->hash);
+      ht_arena_free(&table->arena, item, HT_ITEM_SIZE(item->length));
+      table->count--;
+      HT_COUNT(table, deletes);
+
+      // Po hromadném mazání pole zmenšíme, nejvýše však na počáteční velikost
+      ht_rehash_step(table, HT_REHASH_STEP);
+      if (table->old_buckets == NULL && table->size > table->min_size &&
+          table->count * HT_MIN_LOAD_DIV < table->size) {
+        size_t new_size = table->count * 2;
+        ht_resize(table, new_size > table->min_size ? new_size
+                                                    : table->min_size);
+      }
       return;  // Po smazání ukončíme funkci
+    }
+    // Posuneme se na další prvek v seznamu
+    prev = item;
+    item = item->next;
   }
-  // Posuneme se na další prvek v seznamu
-  prev = item;
-  item = item->next;
-  }
+  ht_count_probes(table, visited);
 }
 
 /*
  * Smazání všech prvků z tabulky.
  *
- * Funkce korektně uvolní všechny alokované zdroje a uvede tabulku do stavu po 
- * inicializaci.
+ * Funkce korektně uvolní všechny alokované zdroje a uvede tabulku do stavu po
+ * inicializaci. Prvky neprochází — uvolní pole tabulky a celou arénu, ze
+ * které se prvky přidělovaly. Arénu tabulky naplněné funkcí
+ * ht_build_parallel uvolní stejný počet vláken. Omezení kapacity
+ * (ht_set_capacity) zůstává.
  */
 void ht_delete_all(ht_table_t *table) {
-  // Projdeme všechny indexy v tabulce
-  for (int i = 0; i < HT_SIZE; i++) {
-    ht_item_t *item = (*table)[i];
+  if (table->image != NULL) {
+    munmap(table->image, table->image_size);
+    table->image = NULL;
+    table->image_size = 0;
+  }
+  if (table->frozen != NULL) {
+    ht_frozen_free(table->frozen);
+    table->frozen = NULL;
+  }
+  free(table->buckets);
+  free(table->old_buckets);
+  ht_arena_release_parallel(&table->arena, table->threads);
+  ht_filter_free(&table->filter);
+  table->threads = 1;
 
-    // Procházíme spojený seznam na každém indexu a uvolňujeme paměť
-    while (item != NULL) {
-      ht_item_t *next_item = item->next;  // Uložíme si ukazatel na další prvek
-      free(item->key);  // Uvolníme paměť pro klíč
-      free(item);       // Uvolníme samotný prvek
-      item = next_item; // Posuneme se na další prvek v seznamu
+  table->buckets = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->old_buckets = NULL;
+  table->old_size = 0;
+  table->rehash_index = 0;
+  table->clock_hand = 0;
+}
+
+// Rozpracovaný obraz: v prvním průchodu se počítají velikosti seznamů,
+// ve druhém se do obrazu zapisují záznamy
+typedef struct {
+  ht_image_t *image;
+  uint64_t *cursors; // kam se zapíše další záznam daného seznamu
+} ht_image_builder_t;
+
+static void ht_image_measure(ht_item_t *item, void *context) {
+  ht_image_builder_t *builder = context;
+  size_t index = ht_index(item->hash, builder->image->size);
+  builder->cursors[index + 1] += HT_IMAGE_RECORD_SIZE(item->length);
+}
+
+static void ht_image_write(ht_item_t *item, void *context) {
+  ht_image_builder_t *builder = context;
+  size_t index = ht_index(item->hash, builder->image->size);
+  ht_item_t *record =
+      (ht_item_t *)((char *)builder->image + builder->cursors[index]);
+  memset(record, 0, HT_IMAGE_RECORD_SIZE(item->length));
+  record->key = NULL;
+  record->next = NULL;
+  record->value = item->value;
+  record->length = item->length;
+  record->hash = item->hash;
+  memcpy(record + 1, item->key, item->length + 1);
+  builder->cursors[index] += HT_IMAGE_RECORD_SIZE(item->length);
+}
+
+/*
+ * Zapíše data do souboru path tak, aby ho nahradila najednou: data se
+ * zapíší do dočasného souboru vedle něj, uloží se na disk a dočasný
+ * soubor se přejmenuje na path. Pád uprostřed zápisu tak nenechá
+ * poloviční obraz a obraz namapovaný z path zůstane platný i při
+ * ukládání do téhož souboru (původní soubor se nezkracuje).
+ */
+static bool ht_write_file(const char *path, const void *data, size_t size) {
+  size_t length = strlen(path);
+  char *temp = malloc(length + sizeof(".XXXXXX"));
+  if (temp == NULL) {
+    return false;
+  }
+  memcpy(temp, path, length);
+  memcpy(temp + length, ".XXXXXX", sizeof(".XXXXXX"));
+  int fd = mkstemp(temp);
+  if (fd < 0) {
+    free(temp);
+    return false;
+  }
+
+  // mkstemp vytváří soubor jen pro vlastníka, obraz mohou číst i ostatní
+  bool written = fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0;
+  for (size_t done = 0; written && done < size;) {
+    ssize_t chunk = write(fd, (const char *)data + done, size - done);
+    written = chunk > 0;
+    done += written ? (size_t)chunk : 0;
+  }
+  written = written && fsync(fd) == 0;
+  written = close(fd) == 0 && written;
+  written = written && rename(temp, path) == 0;
+  if (!written) {
+    unlink(temp);
+  }
+  free(temp);
+  return written;
+}
+
+/*
+ * Uložení tabulky do souboru jako obrazu pro ht_open_mmap.
+ *
+ * Obraz má tolik seznamů synonym, kolik tabulka obsahuje prvků (nejméně
+ * počáteční velikost), a platí jen pro stejnou architekturu a velikost
+ * ht_item_t. Soubor se nahradí najednou (viz ht_write_file), tabulku
+ * namapovanou z path lze proto uložit zpět do path. Vrací false, pokud
+ * se soubor nepodařilo zapsat.
+ */
+bool ht_save(ht_table_t *table, const char *path) {
+  // Namapovaný obraz stačí zapsat tak, jak je
+  if (table->image != NULL) {
+    return ht_write_file(path, table->image, table->image_size);
+  }
+
+  size_t size = table->count > table->min_size ? table->count
+                                               : table->min_size;
+  size_t header = sizeof(ht_image_t) + (size + 1) * sizeof(uint64_t);
+  uint64_t *cursors = calloc(size + 1, sizeof(uint64_t));
+  ht_image_t sizing = {.size = size};
+  ht_image_builder_t builder = {&sizing, cursors};
+  if (cursors == NULL) {
+    return false;
+  }
+
+  // Velikosti seznamů převedeme na posuny jejich začátků
+  ht_for_each(table, ht_image_measure, &builder);
+  cursors[0] = header;
+  for (size_t i = 1; i <= size; i++) {
+    cursors[i] += cursors[i - 1];
+  }
+
+  size_t file_size = (size_t)cursors[size];
+  ht_image_t *image = calloc(1, file_size);
+  if (image == NULL) {
+    free(cursors);
+    return false;
+  }
+  image->magic = HT_IMAGE_MAGIC;
+  image->version = HT_IMAGE_VERSION;
+  image->item_size = sizeof(ht_item_t);
+  image->seed = table->seed;
+  image->size = size;
+  image->count = table->count;
+  image->file_size = file_size;
+  memcpy(image->buckets, cursors, (size + 1) * sizeof(uint64_t));
+
+  builder.image = image;
+  ht_for_each(table, ht_image_write, &builder);
+
+  bool written = ht_write_file(path, image, file_size);
+  free(image);
+  free(cursors);
+  return written;
+}
+
+/*
+ * Ověří posuny a záznamy obrazu: posuny seznamů nesmí klesat a musí
+ * ležet mezi koncem hlavičky a koncem souboru, záznamy každého seznamu
+ * musí končit přesně na začátku dalšího a klíč musí být ukončený.
+ */
+static bool ht_image_valid(const ht_image_t *image, size_t file_size) {
+  uint64_t header = sizeof(ht_image_t) + (image->size + 1) * sizeof(uint64_t);
+  if (image->buckets[0] != header || image->buckets[image->size] != file_size) {
+    return false;
+  }
+  uint64_t count = 0;
+  for (size_t i = 0; i < image->size; i++) {
+    uint64_t offset = image->buckets[i];
+    uint64_t end = image->buckets[i + 1];
+    if (end < offset || end > file_size) {
+      return false;
+    }
+    while (offset < end) {
+      if (end - offset < sizeof(ht_item_t)) {
+        return false;
+      }
+      const ht_item_t *item =
+          (const ht_item_t *)((const char *)image + offset);
+      if (HT_IMAGE_RECORD_SIZE(item->length) > end - offset ||
+          ((const char *)(item + 1))[item->length] != '\0') {
+        return false;
+      }
+      offset += HT_IMAGE_RECORD_SIZE(item->length);
+      count++;
+    }
+  }
+  return count == image->count;
+}
+
+/*
+ * Otevření obrazu uloženého funkcí ht_save.
+ *
+ * Tabulka musí být inicializovaná; její dosavadní obsah se smaže. Soubor
+ * se jen namapuje (bez čtení a bez kopírování prvků) a ht_search, ht_get
+ * i ht_get_many vyhledávají přímo v něm. Soubor je namapovaný jen pro
+ * čtení, hodnoty vrácené z ht_get proto nelze měnit; ht_search vrací
+ * kopii prvku platnou do dalšího volání. První vložení, smazání nebo
+ * změna semínka obraz převede na běžnou tabulku.
+ *
+ * Vrací false, pokud soubor nejde otevřít nebo nemá platný obsah.
+ */
+bool ht_open_mmap(ht_table_t *table, const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < sizeof(ht_image_t) + 2 * sizeof(uint64_t)) {
+    close(fd);
+    return false;
+  }
+  size_t file_size = (size_t)st.st_size;
+  ht_image_t *image = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (image == MAP_FAILED) {
+    return false;
+  }
+
+  // Hlavička musí odpovídat tomuto programu a celý seznam posunů se
+  // musí vejít do souboru, teprve potom se ověří posuny a záznamy
+  if (image->magic != HT_IMAGE_MAGIC || image->version != HT_IMAGE_VERSION ||
+      image->item_size != sizeof(ht_item_t) ||
+      image->file_size != file_size || image->size == 0 ||
+      image->size > (file_size - sizeof(ht_image_t)) / sizeof(uint64_t) - 1 ||
+      !ht_image_valid(image, file_size)) {
+    munmap(image, file_size);
+    return false;
+  }
+
+  ht_delete_all(table);
+  table->image = image;
+  table->image_size = file_size;
+  table->seed = image->seed;
+  table->size = (size_t)image->size;
+  table->count = (size_t)image->count;
+  return true;
+}
+
+// Sběr ukazatelů na všechny prvky tabulky do pole
+typedef struct {
+  ht_item_t **items;
+  size_t count;
+} ht_collector_t;
+
+static void ht_collect(ht_item_t *item, void *context) {
+  ht_collector_t *collector = context;
+  collector->items[collector->count++] = item;
+}
+
+/*
+ * Umístí klíče jedné skupiny: hledá nejmenší pilot, při kterém všechny
+ * klíče skupiny padnou na různá volná místa. Obsazená místa značí bitová
+ * mapa taken, místa klíčů skupiny se zapíší do slots. Vrací false, pokud
+ * takový pilot neexistuje (dva klíče skupiny mají stejný hash).
+ */
+static bool ht_place_group(ht_item_t **group, size_t size, size_t count,
+                           uint64_t *taken, size_t *slots, uint32_t *pilot) {
+  for (size_t i = 0; i < size; i++) {
+    for (size_t j = 0; j < i; j++) {
+      if (group[i]->hash == group[j]->hash) {
+        return false;
+      }
+    }
+  }
+
+  for (uint64_t candidate = 0; candidate <= UINT32_MAX; candidate++) {
+    size_t placed = 0;
+    while (placed < size) {
+      size_t slot = ht_frozen_slot(group[placed]->hash, (uint32_t)candidate,
+                                   count);
+      if (taken[slot / 64] & (UINT64_C(1) << (slot % 64))) {
+        break;
+      }
+      taken[slot / 64] |= UINT64_C(1) << (slot % 64);
+      slots[placed++] = slot;
+    }
+    if (placed == size) {
+      *pilot = (uint32_t)candidate;
+      return true;
+    }
+    // Kolize: uvolníme místa, která skupina s tímto pilotem obsadila
+    while (placed > 0) {
+      placed--;
+      taken[slots[placed] / 64] &= ~(UINT64_C(1) << (slots[placed] % 64));
+    }
+  }
+  return false;
+}
+
+/*
+ * Alokace prázdné zmrazené tabulky pro count klíčů. Pole klíčů se alokuje
+ * až při balení, kdy je známa jeho velikost.
+ */
+static ht_frozen_t *ht_frozen_new(size_t count, uint64_t seed) {
+  ht_frozen_t *frozen = calloc(1, sizeof(ht_frozen_t));
+  if (frozen == NULL) {
+    return NULL;
+  }
+  frozen->count = count;
+  frozen->groups = (count + HT_FROZEN_LOAD - 1) / HT_FROZEN_LOAD;
+  frozen->seed = seed;
+  frozen->pilots = calloc(frozen->groups, sizeof(uint32_t));
+  frozen->key_offsets = malloc((count + 1) * sizeof(uint32_t));
+  frozen->values = malloc(count * sizeof(float));
+  if (frozen->pilots == NULL || frozen->key_offsets == NULL ||
+      frozen->values == NULL) {
+    ht_frozen_free(frozen);
+    return NULL;
+  }
+  return frozen;
+}
+
+/*
+ * Najde piloty všech skupin a prvky z items přerovná podle jejich míst
+ * (items[slot] je prvek na místě slot). Klíče se rozdělí do skupin podle
+ * hashe a skupiny se umísťují od největší, protože malé skupiny se snáz
+ * vejdou do zbylých mezer.
+ */
+static bool ht_frozen_place(ht_frozen_t *frozen, ht_item_t **items) {
+  size_t count = frozen->count;
+  size_t groups = frozen->groups;
+  ht_item_t **sorted = malloc(count * sizeof(ht_item_t *));
+  size_t *group_start = calloc(groups + 1, sizeof(size_t));
+  size_t *order = malloc(groups * sizeof(size_t));
+  uint64_t *taken = calloc((count + 63) / 64, sizeof(uint64_t));
+  size_t *slots = NULL;
+  size_t *by_size = NULL;
+  size_t largest = 0;
+  bool ok = sorted != NULL && group_start != NULL && order != NULL &&
+            taken != NULL;
+
+  if (ok) {
+    // Prvky seřadíme podle skupin (řazení počítáním)
+    for (size_t i = 0; i < count; i++) {
+      group_start[ht_index(items[i]->hash, groups) + 1]++;
+    }
+    for (size_t g = 0; g < groups; g++) {
+      if (group_start[g + 1] > largest) {
+        largest = group_start[g + 1];
+      }
+      group_start[g + 1] += group_start[g];
+    }
+    for (size_t i = 0; i < count; i++) {
+      size_t g = ht_index(items[i]->hash, groups);
+      sorted[group_start[g]++] = items[i];
     }
+    for (size_t g = groups; g > 0; g--) {
+      group_start[g] = group_start[g - 1];
+    }
+    group_start[0] = 0;
+
+    slots = malloc(largest * sizeof(size_t));
+    by_size = calloc(largest + 2, sizeof(size_t));
+    ok = slots != NULL && by_size != NULL;
+  }
+
+  if (ok) {
+    // Pořadí skupin od největší (řazení počítáním podle velikosti)
+    for (size_t g = 0; g < groups; g++) {
+      by_size[largest - (group_start[g + 1] - group_start[g]) + 1]++;
+    }
+    for (size_t k = 1; k <= largest + 1; k++) {
+      by_size[k] += by_size[k - 1];
+    }
+    for (size_t g = 0; g < groups; g++) {
+      order[by_size[largest - (group_start[g + 1] - group_start[g])]++] = g;
+    }
+
+    for (size_t k = 0; ok && k < groups; k++) {
+      size_t g = order[k];
+      size_t size = group_start[g + 1] - group_start[g];
+      if (size == 0) {
+        break;  // Zbývají jen prázdné skupiny
+      }
+      ok = ht_place_group(sorted + group_start[g], size, count, taken, slots,
+                          &frozen->pilots[g]);
+      for (size_t i = 0; ok && i < size; i++) {
+        items[slots[i]] = sorted[group_start[g] + i];
+      }
+    }
+  }
+
+  free(sorted);
+  free(group_start);
+  free(order);
+  free(taken);
+  free(slots);
+  free(by_size);
+  return ok;
+}
+
+/*
+ * Zbalí klíče do jednoho bloku a hodnoty do hustého pole v pořadí míst.
+ */
+static bool ht_frozen_pack(ht_frozen_t *frozen, ht_item_t **items) {
+  size_t key_bytes = 0;
+  for (size_t slot = 0; slot < frozen->count; slot++) {
+    frozen->key_offsets[slot] = (uint32_t)key_bytes;
+    key_bytes += items[slot]->length + 1;
+    if (key_bytes > UINT32_MAX) {
+      return false;  // Posuny klíčů jsou 32bitové
+    }
+  }
+  frozen->key_offsets[frozen->count] = (uint32_t)key_bytes;
+
+  frozen->keys = malloc(key_bytes);
+  if (frozen->keys == NULL) {
+    return false;
+  }
+  for (size_t slot = 0; slot < frozen->count; slot++) {
+    memcpy(frozen->keys + frozen->key_offsets[slot], items[slot]->key,
+           items[slot]->length + 1);
+    frozen->values[slot] = items[slot]->value;
+  }
+  return true;
+}
+
+/*
+ * Zmrazení tabulky do minimální perfektní rozptylovací funkce.
+ *
+ * Po zmrazení ht_search, ht_get a ht_get_many udělají jediný pokus
+ * a jedno porovnání klíče; seznamy synonym i aréna prvků se uvolní. První
+ * vložení, smazání nebo změna semínka tabulku zase rozmrazí.
+ *
+ * Vrací false, pokud je tabulka prázdná, příliš velká (více než 2^32
+ * klíčů nebo bajtů klíčů) nebo pokud selže alokace; tabulka pak zůstane
+ * beze změny.
+ */
+bool ht_freeze(ht_table_t *table) {
+  if (table->frozen != NULL) {
+    return true;
+  }
+  if (table->image != NULL && !ht_promote(table)) {
+    return false;
+  }
+  size_t count = table->count;
+  if (count == 0 || count > UINT32_MAX) {
+    return false;
+  }
+
+  ht_item_t **items = malloc(count * sizeof(ht_item_t *));
+  ht_frozen_t *frozen = ht_frozen_new(count, table->seed);
+  if (items == NULL || frozen == NULL) {
+    free(items);
+    if (frozen != NULL) {
+      ht_frozen_free(frozen);
+    }
+    return false;
+  }
+
+  ht_collector_t collector = {items, 0};
+  ht_for_each(table, ht_collect, &collector);
+  bool ok = ht_frozen_place(frozen, items) && ht_frozen_pack(frozen, items);
+  free(items);
+  if (!ok) {
+    ht_frozen_free(frozen);
+    return false;
+  }
+
+  // Seznamy synonym a prvky v aréně už nejsou potřeba
+  free(table->buckets);
+  free(table->old_buckets);
+  ht_arena_release(&table->arena);
+  table->buckets = NULL;
+  table->size = count;
+  table->old_buckets = NULL;
+  table->old_size = 0;
+  table->rehash_index = 0;
+  table->frozen = frozen;
+  return true;
+}
+
+/*
+ * Celková paměť tabulky v bajtech: pole seznamů synonym, aréna prvků,
+ * zmrazená tabulka a namapovaný obraz.
+ */
+size_t ht_memory_usage(ht_table_t *table) {
+  ht_arena_stats_t stats;
+  ht_arena_stats(&table->arena, &stats);
+  size_t bytes = stats.reserved;
+  if (table->buckets != NULL) {
+    bytes += table->size * sizeof(ht_bucket_t);
+  }
+  if (table->old_buckets != NULL) {
+    bytes += table->old_size * sizeof(ht_bucket_t);
+  }
+  if (table->frozen != NULL) {
+    ht_frozen_t *frozen = table->frozen;
+    bytes += sizeof(ht_frozen_t) + frozen->groups * sizeof(uint32_t) +
+             (frozen->count + 1) * sizeof(uint32_t) +
+             frozen->key_offsets[frozen->count] +
+             frozen->count * sizeof(float);
+  }
+  return bytes + table->image_size + ht_filter_bytes(&table->filter);
+}
+
+/*
+ * Délka nejdelšího seznamu synonym v poli buckets od indexu from do size.
+ */
+static size_t ht_longest_chain(ht_bucket_t *buckets, size_t from,
+                               size_t size) {
+  size_t longest = 0;
+  for (size_t i = from; buckets != NULL && i < size; i++) {
+    size_t length = 0;
+    for (ht_item_t *item = buckets[i].head; item != NULL; item = item->next) {
+      length++;
+    }
+    longest = length > longest ? length : longest;
+  }
+  return longest;
+}
 
-    // Po smazání všech prvků na daném indexu nastavíme tento index na NULL
-    (*table)[i] = NULL;
+/*
+ * Statistiky tabulky: počítadla operací (viz ht_stats_t) a stav pole.
+ * Nejdelší seznam synonym se hledá průchodem celého pole, takže doba
+ * volání roste s velikostí tabulky. U zmrazené tabulky je každý seznam
+ * dlouhý nejvýše 1.
+ */
+void ht_stats(ht_table_t *table, ht_stats_t *stats) {
+#if HT_STATS
+  *stats = table->stats;
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+  stats->count = table->count;
+  stats->size = table->size;
+  stats->capacity = table->capacity;
+  if (table->frozen != NULL) {
+    stats->longest_chain = table->count > 0 ? 1 : 0;
+  } else if (table->image != NULL) {
+    // Záznamy seznamu leží v obrazu za sebou, spočítáme je posouváním
+    ht_image_t *image = table->image;
+    stats->longest_chain = 0;
+    for (size_t i = 0; i < image->size; i++) {
+      char *record = (char *)image + image->buckets[i];
+      char *end = (char *)image + image->buckets[i + 1];
+      size_t length = 0;
+      for (; record < end; length++) {
+        record += HT_IMAGE_RECORD_SIZE(((ht_item_t *)record)->length);
+      }
+      stats->longest_chain =
+          length > stats->longest_chain ? length : stats->longest_chain;
+    }
+  } else {
+    size_t current = ht_longest_chain(table->buckets, 0, table->size);
+    size_t old = ht_longest_chain(table->old_buckets, table->rehash_index,
+                                  table->old_size);
+    stats->longest_chain = current > old ? current : old;
   }
+  stats->load_factor =
+      stats->size > 0 ? (double)stats->count / stats->size : 0;
+  stats->hit_ratio =
+      stats->searches > 0 ? (double)stats->hits / stats->searches : 0;
+  stats->bytes = ht_memory_usage(table);
 }
@@ -1,42 +1,572 @@
 /*
  * Hlavičkový súbor pre tabuľku s rozptýlenými položkami.
- * Tento súbor neupravujte.
  */
 
 #ifndef IAL_HASHTABLE_H
 #define IAL_HASHTABLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "filter.h"
 
 /*
- * Maximálna veľkosť poľa pre implementáciu tabuľky.
- * Funkcie pracujúce s tabuľkou uvažujú veľkosť HT_SIZE.
+ * Predvolená počiatočná veľkosť poľa tabuľky.
  */
-#define MAX_HT_SIZE 101
+#define HT_DEFAULT_SIZE 101
 
 /*
- * Veľkosť tabuľky s ktorou pracujú implementované funkcie.
+ * Počiatočná veľkosť poľa, s ktorou ht_init inicializuje novú tabuľku.
  * Pre účely testovania je vhodné mať možnosť meniť veľkosť tabuľky.
- * Pre správne fungovanie musí byť veľkosť prvočíslom.
+ * Každá tabuľka si potom svoju veľkosť spravuje sama (zväčšuje sa
+ * a zmenšuje podľa počtu prvkov), globálna hodnota ju už neovplyvňuje.
  */
 extern int HT_SIZE;
 
-// Prvok tabuľky
+/*
+ * Ak je HT_RANDOM_SEED true (predvolené), ht_init dá každej tabuľke
+ * náhodné semienko, takže útočník, ktorý volí kľúče, nevie vopred, ktoré
+ * z nich budú kolidovať. Testy ho vypínajú, aby tabuľky vypisovali vždy
+ * rovnako (semienko je potom 0).
+ */
+extern bool HT_RANDOM_SEED;
+
+/*
+ * Ochrana pred zahltením kolíziami: ak vloženie nájde zoznam synonym
+ * dlhší než HT_FLOOD_CHAIN násobok faktora naplnenia (aspoň však
+ * HT_FLOOD_CHAIN), tabuľka sa prehashuje s novým náhodným semienkom.
+ * Pri variante s otvoreným adresovaním je hranicou HT_FLOOD_GROUPS
+ * prezretých skupín. Pri náhodných kľúčoch taký zoznam prakticky
+ * nevznikne, prehashovanie preto spúšťajú len cielene kolidujúce kľúče.
+ */
+#define HT_FLOOD_CHAIN 16
+#define HT_FLOOD_GROUPS 64
+
+/*
+ * Najdlhší kľúč, ktorý tabuľka uloží. Zreťazený variant a variant
+ * s otvoreným adresovaním majú v najvyššom bite dĺžky kľúča referenčný
+ * bit prvku (ht_set_capacity), na dĺžku im teda ostáva 31 bitov.
+ */
+#define HT_MAX_KEY_LENGTH 0x7fffffffu
+
+/*
+ * Počet kľúčov, ktoré dávkové operácie (ht_get_many, ht_insert_many)
+ * spracúvajú naraz. Pre všetky kľúče dávky sa najprv spočítajú hashe
+ * a vydajú sa požiadavky na prednačítanie ich zoznamov, takže sa výpadky
+ * cache jednotlivých kľúčov prekrývajú.
+ */
+#define HT_BATCH_SIZE 16
+
+#if defined(__GNUC__)
+#define HT_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define HT_PREFETCH(address) ((void)(address))
+#endif
+
+/*
+ * Kľúč s vopred spočítaným hashom (ht_key_init). Horúce cykly ním môžu
+ * vyhľadávať a vkladať ten istý kľúč do viacerých tabuliek, pričom sa hash
+ * spočíta len raz pre všetky tabuľky s rovnakým semienkom (nastaveným
+ * funkciou ht_set_seed); pre tabuľku s iným semienkom sa hash spočíta
+ * znova.
+ * Kľúč nemusí končiť nulovým znakom a tabuľka ho skopíruje až pri vložení
+ * nového prvku, musí teda platiť len počas volania.
+ */
+typedef struct {
+  const char *data;  // začiatok kľúča (napr. úsek vstupného bufferu)
+  size_t length;     // dĺžka kľúča v bajtoch
+  uint64_t seed;     // semienko, s ktorým je spočítaný hash
+  uint64_t hash;     // ht_hash_bytes(data, length, seed)
+} ht_key_t;
+
+/*
+ * Štatistiky tabuľky (ht_stats). Počítadlá operácií sa prekladajú, ak je
+ * HT_STATS nenulové (predvolené); preklad s -DHT_STATS=0 ich vypne
+ * a ht_stats potom vracia len údaje o štruktúre tabuľky.
+ *
+ * Histogram probes delí všetky hľadania kľúča (aj tie, ktorými začína
+ * vloženie alebo zmazanie) podľa počtu prezretých prvkov zoznamu synonym,
+ * pri variante s otvoreným adresovaním podľa počtu prezretých skupín.
+ * Posledný kôš zahŕňa aj všetky dlhšie hľadania.
+ */
+#ifndef HT_STATS
+#define HT_STATS 1
+#endif
+#define HT_STATS_PROBES 8
+
+typedef struct ht_stats {
+  uint64_t searches;      // vyhľadania (ht_search, ht_get a ich varianty)
+  uint64_t hits;          // úspešné vyhľadania
+  uint64_t misses;        // neúspešné vyhľadania
+  uint64_t filtered;      // z nich odmietnuté filtrom (ht_set_filter)
+  uint64_t inserts;       // vložené nové prvky
+  uint64_t updates;       // zápisy, ktoré kľúč v tabuľke našli
+  uint64_t deletes;       // zmazané prvky
+  uint64_t evictions;     // prvky vyhodené pri plnej kapacite
+  uint64_t reseeds;       // prehashovania s novým semienkom (HT_FLOOD_CHAIN)
+  uint64_t probes[HT_STATS_PROBES]; // hľadania podľa dĺžky
+  size_t count;           // počet prvkov
+  size_t size;            // počet zoznamov synonym (miest) poľa
+  size_t capacity;        // najvyšší počet prvkov (0 = neobmedzený)
+  double load_factor;     // count / size
+  double hit_ratio;       // hits / searches
+  size_t longest_chain;   // najdlhší zoznam synonym (postupnosť skupín)
+  size_t bytes;           // pamäť tabuľky v bajtoch
+} ht_stats_t;
+
+#if defined(HT_BACKEND_CONC)
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ * Súbežný variant (preklad s -DHT_BACKEND_CONC).
+ *
+ * ht_search a ht_get nikdy neberú zámok: prvky sa do zoznamov synonym
+ * zverejňujú atomickým zápisom a odstránené prvky sa uvoľnia až vtedy,
+ * keď ich už žiadne čítajúce vlákno nemôže vidieť (epochová správa
+ * pamäte). Zapisujúce vlákna sa vylučujú zámkami, z ktorých každý chráni
+ * pevnú časť rozsahu hashov. Ukazovatele vrátené funkciami ht_search
+ * a ht_get (aj ht_upsert, ht_get_or_insert a ht_add) sú platné do
+ * ht_read_unlock, ak ich volajúci obalí dvojicou
+ * ht_read_lock/ht_read_unlock; hodnotu nemeňte cez ukazovateľ, ale
+ * funkciou ht_insert alebo atomickou ht_add.
+ */
+#define HT_LOCK_BITS 6
+#define HT_LOCK_STRIPES (1 << HT_LOCK_BITS)
+
+/*
+ * Maximálny počet vlákien, ktoré s tabuľkami pracujú naraz.
+ */
+#define HT_MAX_THREADS 256
+
+/*
+ * Hranice faktoru naplnenia (rovnaké ako pri zreťazenom variante).
+ * Veľkosť poľa je mocnina dvojky, najmenej HT_LOCK_STRIPES.
+ */
+#define HT_MAX_LOAD 1
+#define HT_MIN_LOAD_DIV 8
+
+/*
+ * Prvok tabuľky. Po zverejnení sa prvok nemení — zmena hodnoty ho nahradí
+ * novou kópiou. Kľúč leží hneď za štruktúrou.
+ */
+typedef struct ht_item {
+  char *key;                     // kľúč prvku
+  float value;                   // hodnota prvku
+  uint32_t length;               // dĺžka kľúča bez ukončovacieho znaku
+  _Atomic(struct ht_item *) next; // ukazateľ na ďalšie synonymum
+  uint64_t hash;                 // úplný hash kľúča so semienkom poľa
+} ht_item_t;
+
+// Pole zoznamov synonym; pri zmene veľkosti alebo semienka sa nahradí celé
+typedef struct ht_buckets {
+  size_t size;                   // počet zoznamov, mocnina dvojky
+  int shift;                     // index zoznamu = hash >> shift
+  uint64_t seed;                 // semienko, s ktorým sú prvky rozmiestnené
+  _Atomic(ht_item_t *) heads[];  // začiatky zoznamov synonym
+} ht_buckets_t;
+
+// Pamäť čakajúca na uvoľnenie, kým ju môžu vidieť čítajúce vlákna
+typedef struct ht_retired {
+  void *block;                   // uvoľňovaný blok
+  size_t bytes;                  // jeho veľkosť
+  uint64_t epoch;                // epocha, v ktorej bol odstránený
+} ht_retired_t;
+
+// Počítadlá zápisov jedného zámku (každé na vlastnom riadku cache)
+typedef struct ht_stripe_stats {
+  _Alignas(64) _Atomic uint64_t inserts;
+  _Atomic uint64_t updates;
+  _Atomic uint64_t deletes;
+  _Atomic uint64_t reseeds;
+} ht_stripe_stats_t;
+
+/*
+ * Počítadlá vyhľadávania jedného vlákna (každé na vlastných riadkoch
+ * cache). Zapisuje do nich iba vlákno, ktorému patrí záznam s rovnakým
+ * indexom, takže čítanie horúceho kľúča z viacerých vlákien nezdieľa
+ * žiadny riadok cache.
+ */
+typedef struct ht_thread_stats {
+  _Alignas(64) _Atomic uint64_t searches;
+  _Atomic uint64_t hits;
+  _Atomic uint64_t misses;
+  _Atomic uint64_t probes[HT_STATS_PROBES];
+} ht_thread_stats_t;
+
+// Súbežná tabuľka
+typedef struct ht_table {
+  _Atomic(ht_buckets_t *) buckets;             // aktuálne pole (NULL pred prvým vložením)
+  _Atomic size_t size;                         // veľkosť aktuálneho poľa
+  _Atomic size_t count;                        // počet prvkov v tabuľke
+  size_t min_size;                             // počiatočná veľkosť poľa
+  uint64_t seed;                               // semienko pre nové polia
+  pthread_mutex_t locks[HT_LOCK_STRIPES];      // zámky zapisujúcich vlákien
+  pthread_mutex_t retire_lock;                 // chráni zoznam retired
+  ht_retired_t *retired;                       // pamäť čakajúca na uvoľnenie
+  size_t retired_count;                        // počet záznamov v retired
+  size_t retired_capacity;                     // kapacita poľa retired
+  size_t retired_bytes;                        // bajty čakajúce na uvoľnenie
+  size_t retired_limit;                        // počet, pri ktorom sa uvoľňuje
+  _Atomic size_t live_bytes;                   // bajty živých prvkov
+#if HT_STATS
+  ht_stripe_stats_t stats[HT_LOCK_STRIPES];    // zápisy podľa zámkov
+  ht_thread_stats_t reads[HT_MAX_THREADS];     // hľadania podľa vlákien
+#endif
+} ht_table_t;
+
+void ht_read_lock(void);
+void ht_read_unlock(void);
+
+#elif defined(HT_BACKEND_OA)
+
+/*
+ * Variant s otvoreným adresovaním (preklad s -DHT_BACKEND_OA).
+ *
+ * Prvky ležia priamo v poli tabuľky. Ku každému miestu patrí riadiaci bajt:
+ * HT_CTRL_EMPTY, HT_CTRL_DELETED alebo 7 bitov hashu obsadeného miesta.
+ * Miesta sa prehľadávajú po skupinách HT_GROUP_SIZE, riadiace bajty celej
+ * skupiny sa porovnajú jednou vektorovou inštrukciou.
+ */
+#define HT_GROUP_SIZE 16
+#define HT_CTRL_EMPTY 0x80
+#define HT_CTRL_DELETED 0xfe
+
+/*
+ * Maximálny faktor naplnenia HT_MAX_LOAD_NUM / HT_MAX_LOAD_DEN, do ktorého
+ * sa započítavajú aj zmazané miesta. Pri poklese pod 1/HT_MIN_LOAD_DIV
+ * sa pole zmenší (nie však pod počiatočnú veľkosť).
+ */
+#define HT_MAX_LOAD_NUM 7
+#define HT_MAX_LOAD_DEN 8
+#define HT_MIN_LOAD_DIV 8
+
+// Prvok tabuľky, kľúč sa prideľuje z arény tabuľky
 typedef struct ht_item {
-  char *key;            // kľúč prvku
-  float value;          // hodnota prvku
-  struct ht_item *next; // ukazateľ na ďalšie synonymum
+  char *key;              // kľúč prvku
+  float value;            // hodnota prvku
+  uint32_t length : 31;   // dĺžka kľúča bez ukončovacieho znaku
+  uint32_t referenced : 1; // prvok bol od prechodu ručičky použitý
 } ht_item_t;
 
-// Tabuľka o reálnej veľkosti MAX_HT_SIZE
-typedef ht_item_t *ht_table_t[MAX_HT_SIZE];
+// Tabuľka s otvoreným adresovaním
+typedef struct ht_table {
+  uint8_t *ctrl;         // riadiace bajty miest (size bajtov)
+  ht_item_t *items;      // miesta tabuľky
+  size_t size;           // počet miest, mocnina dvojky a násobok HT_GROUP_SIZE
+  size_t count;          // počet prvkov v tabuľke
+  size_t deleted;        // počet miest označených HT_CTRL_DELETED
+  size_t min_size;       // počiatočná veľkosť poľa, pod ňu sa nezmenšuje
+  size_t capacity;       // najvyšší počet prvkov (0 = neobmedzený)
+  size_t clock_hand;     // miesto, od ktorého sa hľadá prvok na vyhodenie
+  uint64_t seed;         // semienko rozptylovacej funkcie tabuľky
+  ht_arena_t arena;      // alokátor kľúčov
+  ht_filter_t filter;    // filter príslušnosti (ht_set_filter)
+#if HT_STATS
+  ht_stats_t stats;      // počítadlá operácií
+#endif
+} ht_table_t;
+
+#elif defined(HT_BACKEND_CUCKOO)
+
+/*
+ * Variant s kukučím hashovaním (preklad s -DHT_BACKEND_CUCKOO).
+ *
+ * Pole tvoria koše po HT_BUCKET_SLOTS prvkoch, jeden kôš zaberá práve
+ * jeden riadok cache (HT_CACHE_LINE bajtov). Každý kľúč môže ležať len
+ * v jednom z dvoch košov, ktoré určí jeho hash, takže vyhľadanie prezrie
+ * vždy najviac dva riadky poľa (a kľúč nájdeného prvku). Ak sú pri
+ * vkladaní oba koše plné, nový prvok vytlačí niektorý z prvkov do jeho
+ * druhého koša; keď ani po HT_CUCKOO_MAX_KICKS vytlačeniach prvok nenájde
+ * miesto (vytláčanie sa zacyklilo), pole sa zväčší.
+ */
+#define HT_BUCKET_SLOTS 4
+#define HT_CACHE_LINE 64
+#define HT_CUCKOO_MAX_KICKS 128
+
+/*
+ * Maximálny faktor naplnenia (prvky / miesta) HT_MAX_LOAD_NUM /
+ * HT_MAX_LOAD_DEN; pri poklese pod 1/HT_MIN_LOAD_DIV sa pole zmenší (nie
+ * však pod počiatočnú veľkosť).
+ */
+#define HT_MAX_LOAD_NUM 9
+#define HT_MAX_LOAD_DEN 10
+#define HT_MIN_LOAD_DIV 8
+
+/*
+ * Prvok tabuľky, kľúč sa prideľuje z arény tabuľky (dĺžka kľúča leží
+ * v štyroch bajtoch pred ním). Odtlačok je dolných 31 bitov hashu: kľúče
+ * sa porovnávajú len pri zhode odtlačku a z odtlačku a koša prvku sa dá
+ * spočítať jeho druhý kôš bez hashovania kľúča.
+ */
+typedef struct ht_item {
+  char *key;               // kľúč prvku (NULL = voľné miesto)
+  float value;             // hodnota prvku
+  uint32_t tag : 31;       // odtlačok hashu kľúča
+  uint32_t referenced : 1; // prvok bol od prechodu ručičky použitý
+} ht_item_t;
+
+// Kôš, jeden riadok cache
+typedef struct ht_bucket {
+  ht_item_t slots[HT_BUCKET_SLOTS];
+} ht_bucket_t;
+
+// Tabuľka s kukučím hashovaním
+typedef struct ht_table {
+  ht_bucket_t *buckets;  // koše (NULL pred prvým vložením)
+  size_t size;           // počet košov, mocnina dvojky
+  size_t count;          // počet prvkov v tabuľke
+  size_t min_size;       // počiatočná veľkosť poľa, pod ňu sa nezmenšuje
+  size_t capacity;       // najvyšší počet prvkov (0 = neobmedzený)
+  size_t clock_hand;     // miesto, od ktorého sa hľadá prvok na vyhodenie
+  uint64_t seed;         // semienko rozptylovacej funkcie tabuľky
+  ht_arena_t arena;      // alokátor kľúčov
+#if HT_STATS
+  ht_stats_t stats;      // počítadlá operácií
+#endif
+} ht_table_t;
+
+#elif defined(HT_BACKEND_COMPACT)
+
+/*
+ * Kompaktný variant (preklad s -DHT_BACKEND_COMPACT).
+ *
+ * Synonymá sú zreťazené ako v predvolenom variante, ale bez ukazovateľov:
+ * uzly prvkov ležia v jednom poli tabuľky a spájajú sa 32-bitovými
+ * indexmi, kľúče ležia za sebou v jednom bufferi a uzol ich odkazuje
+ * 32-bitovým posunom. Hodnoty ležia mimo uzlov v hustom poli v poradí
+ * uzlov, takže ich hromadné operácie (ht_values_sum a ďalšie) prechádzajú
+ * vektorovými inštrukciami bez medzier. Uzol tak zaberie 12 bajtov,
+ * hodnota 4 a začiatok zoznamu synonym v poli 4 bajty. Tabuľka pojme
+ * menej ako HT_NIL prvkov a jej kľúče najviac 4 GiB.
+ */
+#define HT_NIL UINT32_MAX
+
+/*
+ * Hranice faktoru naplnenia (rovnaké ako pri zreťazenom variante).
+ */
+#define HT_MAX_LOAD 1
+#define HT_MIN_LOAD_DIV 8
+
+/*
+ * Prvok, ako ho vracia ht_search a prijíma ht_insert_many. Tabuľka
+ * prvky neukladá, ht_search vráti pohľad na nájdený uzol, ktorý platí do
+ * ďalšieho volania ht_search alebo zmeny tabuľky.
+ */
+typedef struct ht_item {
+  char *key;              // kľúč prvku
+  float value;            // hodnota prvku
+  uint32_t length;        // dĺžka kľúča bez ukončovacieho znaku
+} ht_item_t;
+
+/*
+ * Uzol prvku. Kľúč leží v bufferi kľúčov od posunu key: 4 bajty dĺžky,
+ * bajty kľúča a ukončovací znak, zarovnané na 4 bajty. V uzle je len
+ * horných 31 bitov hashu, ktoré určujú zoznam synonym; zvyšný bit je
+ * referenčný bit prvku (ht_set_capacity). Hodnota uzla i leží vo values[i].
+ */
+typedef struct ht_node {
+  uint32_t key;            // posun kľúča v bufferi
+  uint32_t next;           // index ďalšieho synonyma (HT_NIL = koniec)
+  uint32_t hash : 31;      // horných 31 bitov hashu kľúča
+  uint32_t referenced : 1; // prvok bol od prechodu ručičky použitý
+} ht_node_t;
+
+/*
+ * Kompaktná tabuľka. Obsadených je vždy prvých count uzlov a hodnôt:
+ * zmazaný prvok nahradí posledný uzol s hodnotou.
+ */
+typedef struct ht_table {
+  uint32_t *buckets;     // index prvého uzla zoznamu (HT_NIL = prázdny)
+  size_t size;           // veľkosť poľa (0 pred prvým vložením)
+  size_t count;          // počet prvkov v tabuľke
+  size_t min_size;       // počiatočná veľkosť poľa, pod ňu sa nezmenšuje
+  size_t capacity;       // najvyšší počet prvkov (0 = neobmedzený)
+  size_t clock_hand;     // uzol, od ktorého sa hľadá prvok na vyhodenie
+  ht_node_t *nodes;      // uzly prvkov
+  float *values;         // hodnoty prvkov v poradí uzlov
+  size_t node_capacity;  // veľkosť polí uzlov a hodnôt
+  char *keys;            // buffer kľúčov
+  size_t keys_used;      // obsadené bajty bufferu
+  size_t keys_capacity;  // veľkosť bufferu
+  size_t keys_dead;      // bajty kľúčov zmazaných prvkov
+  uint64_t seed;         // semienko rozptylovacej funkcie tabuľky
+  ht_item_t view;        // prvok vrátený z ht_search
+#if HT_STATS
+  ht_stats_t stats;      // počítadlá operácií
+#endif
+} ht_table_t;
+
+/*
+ * Hromadné operácie nad hodnotami všetkých prvkov (viz values.h).
+ * ht_values_map nahradí každú hodnotu x hodnotou x * scale + offset
+ * orezanou na <min, max>, ht_values_filter zmaže prvky s hodnotou mimo
+ * <min, max> (aj NaN) a vráti ich počet.
+ */
+void ht_values_map(ht_table_t *table, float scale, float offset, float min,
+                   float max);
+double ht_values_sum(ht_table_t *table);
+float ht_values_min(ht_table_t *table);
+float ht_values_max(ht_table_t *table);
+size_t ht_values_filter(ht_table_t *table, float min, float max);
+
+#else
+
+/*
+ * Hranice faktoru naplnenia (počet prvkov / veľkosť poľa). Pri prekročení
+ * HT_MAX_LOAD sa pole zväčší na dvojnásobok, pri poklese pod
+ * 1/HT_MIN_LOAD_DIV sa zmenší na polovicu (nie však pod počiatočnú veľkosť).
+ */
+#define HT_MAX_LOAD 1
+#define HT_MIN_LOAD_DIV 8
+
+/*
+ * Počet indexov starého poľa, ktoré sa pri prebiehajúcom prehashovaní
+ * presunú do nového poľa v rámci jednej operácie vkladania alebo mazania.
+ */
+#define HT_REHASH_STEP 4
+
+/*
+ * Prvok tabuľky. Prvok a jeho kľúč tvoria jednu alokáciu z arény tabuľky,
+ * bajty kľúča ležia hneď za štruktúrou a key ukazuje na ne.
+ */
+typedef struct ht_item {
+  char *key;              // kľúč prvku
+  float value;            // hodnota prvku
+  uint32_t length : 31;   // dĺžka kľúča bez ukončovacieho znaku
+  uint32_t referenced : 1; // prvok bol od prechodu ručičky použitý
+  struct ht_item *next;   // ukazateľ na ďalšie synonymum
+  uint64_t hash;          // úplný hash kľúča so semienkom tabuľky
+} ht_item_t;
+
+/*
+ * Začiatok zoznamu synonym v poli tabuľky. Spolu s ukazovateľom na prvý
+ * prvok leží v poli aj dolných 32 bitov jeho hashu a príznak, či zoznam
+ * pokračuje. Neúspešné hľadanie v zozname s jediným prvkom (pri faktore
+ * naplnenia do HT_MAX_LOAD najčastejší prípad) tak skončí po prečítaní
+ * poľa bez načítania prvku. Prvky zostávajú mimo poľa, aby ukazovatele
+ * vrátené z ht_search a ht_get prežili prehashovanie.
+ */
+typedef struct ht_bucket {
+  ht_item_t *head;       // prvý prvok zoznamu (NULL = prázdny zoznam)
+  uint32_t tag;          // dolných 32 bitov hashu prvého prvku
+  uint32_t overflow;     // zoznam má viac ako jeden prvok
+} ht_bucket_t;
+
+// Tabuľka s vlastnou, dynamicky menenou veľkosťou
+typedef struct ht_table {
+  ht_bucket_t *buckets;  // aktuálne pole zoznamov synonym
+  size_t size;           // veľkosť aktuálneho poľa (0 pred prvým vložením)
+  size_t count;          // počet prvkov v tabuľke
+  size_t min_size;       // počiatočná veľkosť poľa, pod ňu sa nezmenšuje
+  size_t capacity;       // najvyšší počet prvkov (0 = neobmedzený)
+  size_t clock_hand;     // zoznam, od ktorého sa hľadá prvok na vyhodenie
+  ht_bucket_t *old_buckets; // pole, z ktorého sa prehashuje (inak NULL)
+  size_t old_size;       // veľkosť starého poľa
+  size_t rehash_index;   // prvý index starého poľa, ktorý ešte nebol presunutý
+  uint64_t seed;         // semienko rozptylovacej funkcie tabuľky
+  ht_arena_t arena;      // alokátor prvkov
+  struct ht_image *image; // namapovaný obraz tabuľky (inak NULL)
+  size_t image_size;      // veľkosť namapovaného obrazu v bajtoch
+  ht_item_t image_view;   // prvok obrazu vrátený z ht_search
+  struct ht_frozen *frozen; // zmrazená tabuľka (inak NULL)
+  ht_filter_t filter;     // filter príslušnosti (ht_set_filter)
+  int threads;            // vlákna, ktorými ht_delete_all uvoľní arénu
+#if HT_STATS
+  ht_stats_t stats;       // počítadlá operácií
+#endif
+} ht_table_t;
+
+/*
+ * Zmrazená tabuľka (ht_freeze): minimálna perfektná rozptylovacia funkcia
+ * v štýle CHD. Kľúče sa rozdelia do skupín po priemerne HT_FROZEN_LOAD
+ * kľúčoch podľa horných bitov hashu a každá skupina dostane číslo
+ * (pilot), pri ktorom sa všetky jej kľúče zmiešaním hashu s pilotom
+ * trafia na zatiaľ voľné miesta. Miest je presne toľko ako kľúčov, kľúče
+ * ležia zbalené za sebou a hodnoty v hustom poli v poradí miest, takže
+ * vyhľadanie urobí jediný pokus a jedno porovnanie kľúča.
+ */
+#define HT_FROZEN_LOAD 4
+
+typedef struct ht_frozen {
+  size_t count;          // počet kľúčov a zároveň miest
+  size_t groups;         // počet skupín
+  uint64_t seed;         // semienko hashov
+  uint32_t *pilots;      // pilot každej skupiny
+  uint32_t *key_offsets; // začiatok kľúča na mieste i (count + 1 posunov)
+  char *keys;            // zbalené kľúče s ukončovacími znakmi
+  float *values;         // hodnoty v poradí miest
+  ht_item_t view;        // prvok vrátený z ht_search (platí do ďalšieho)
+} ht_frozen_t;
+
+/*
+ * Obraz tabuľky uložený funkciou ht_save. Obraz neobsahuje ukazovatele,
+ * iba posuny od svojho začiatku, takže ho ht_open_mmap len namapuje
+ * a vyhľadáva priamo v ňom.
+ *
+ * Za hlavičkou nasleduje size + 1 posunov buckets a za nimi záznamy
+ * prvkov. Záznam má tvar ht_item_t (key a next sú NULL), za ktorým leží
+ * kľúč s ukončovacím znakom, zarovnaný na HT_IMAGE_ALIGN bajtov. Záznamy
+ * zoznamu synonym i leží za sebou od buckets[i] po buckets[i + 1].
+ * Obraz sa mapuje iba na čítanie a ht_open_mmap pred použitím overí
+ * všetky posuny aj hranice záznamov.
+ */
+#define HT_IMAGE_MAGIC 0x31474d49454c4254u // "TBLEIMG1" v little-endian
+#define HT_IMAGE_VERSION 1
+#define HT_IMAGE_ALIGN 8
+
+typedef struct ht_image {
+  uint64_t magic;      // HT_IMAGE_MAGIC (zároveň overuje poradie bajtov)
+  uint32_t version;    // HT_IMAGE_VERSION
+  uint32_t item_size;  // sizeof(ht_item_t) programu, ktorý obraz uložil
+  uint64_t seed;       // semienko, s ktorým sú spočítané hashe
+  uint64_t size;       // počet zoznamov synonym
+  uint64_t count;      // počet prvkov
+  uint64_t file_size;  // veľkosť celého obrazu v bajtoch
+  uint64_t buckets[];  // posuny začiatkov zoznamov od začiatku obrazu
+} ht_image_t;
+
+bool ht_save(ht_table_t *table, const char *path);
+bool ht_open_mmap(ht_table_t *table, const char *path);
+bool ht_freeze(ht_table_t *table);
+size_t ht_memory_usage(ht_table_t *table);
+
+#endif
 
-int get_hash(char *key);
+uint64_t ht_hash_bytes(const void *data, size_t length, uint64_t seed);
+uint64_t get_hash(char *key);
+uint64_t ht_random_seed(void);
+void ht_key_init(ht_key_t *handle, const char *data, size_t length,
+                 uint64_t seed);
 void ht_init(ht_table_t *table);
+void ht_set_seed(ht_table_t *table, uint64_t seed);
+bool ht_set_filter(ht_table_t *table, double fp_rate, size_t max_bytes);
+bool ht_set_capacity(ht_table_t *table, size_t capacity);
+void ht_alloc_stats(ht_table_t *table, ht_arena_stats_t *stats);
+void ht_stats(ht_table_t *table, ht_stats_t *stats);
+int ht_stats_format(const ht_stats_t *stats, char *buffer, size_t size);
 ht_item_t *ht_search(ht_table_t *table, char *key);
 void ht_insert(ht_table_t *table, char *key, float data);
+float *ht_upsert(ht_table_t *table, char *key, float value);
+float *ht_get_or_insert(ht_table_t *table, char *key, float value);
+float *ht_add(ht_table_t *table, char *key, float delta);
 float *ht_get(ht_table_t *table, char *key);
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length);
+float *ht_get_n(ht_table_t *table, const char *key, size_t length);
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value);
+ht_item_t *ht_search_key(ht_table_t *table, const ht_key_t *key);
+float *ht_get_key(ht_table_t *table, const ht_key_t *key);
+void ht_insert_key(ht_table_t *table, const ht_key_t *key, float value);
 void ht_delete(ht_table_t *table, char *key);
 void ht_delete_all(ht_table_t *table);
+void ht_get_many(ht_table_t *table, char *keys[], size_t count,
+                 float *values[]);
+void ht_insert_many(ht_table_t *table, const ht_item_t items[], size_t count);
+bool ht_build_parallel(ht_table_t *table, char *keys[], const float values[],
+                       size_t count, int threads);
 
 #endif
@@ -0,0 +1,900 @@
+/*
+ * Tabulka s rozptýlenými položkami — kompaktní uzly
+ *
+ * Varianta se stejným rozhraním jako hashtable.c a explicitně zřetězenými
+ * synonymy, ve které prvky nejsou samostatné alokace s ukazateli. Uzly
+ * všech prvků leží v jednom poli tabulky a seznamy synonym je spojují
+ * 32bitovými indexy, klíče leží za sebou v jednom bufferu a uzel na ně
+ * odkazuje 32bitovým posunem (viz ht_node_t). Hodnoty leží v samostatném
+ * poli v pořadí uzlů. Uzel s hodnotou zabírá 16 bajtů místo 32 bajtů
+ * prvku zřetězené varianty (dva ukazatele, 64bitový hash a zarovnání)
+ * a začátek seznamu v poli 4 bajty místo 16.
+ *
+ * Uzly i hodnoty jsou vždy husté: na místo smazaného uzlu se přesune
+ * poslední uzel i s hodnotou, takže hromadné operace (ht_values_sum
+ * a další, viz values.c) projdou pole hodnot bez mezer a bez kontroly
+ * obsazenosti. Bajty klíče smazaného prvku zůstanou v bufferu jako mrtvé;
+ * jakmile tvoří víc než polovinu bufferu, nebo se pole po hromadném
+ * mazání zmenšuje, tabulka živé klíče zhustí do nového bufferu.
+ *
+ * Pole se při změně velikosti přestavuje najednou, bez postupného
+ * přehashování: stačí projít pole uzlů a přepojit je, uzly ani klíče se
+ * přitom nepřesouvají. Zvětšení polí (realloc) i mazání ale uzly
+ * a hodnoty přesouvají, ukazatele vrácené funkcemi ht_get a ht_upsert
+ * proto platí jen do další změny tabulky.
+ */
+
+#include "hashtable.h"
+#include "ht_common.h"
+#include "parallel.h"
+#include "values.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Velikost záznamu klíče o délce length v bufferu (délka, bajty, nula)
+#define HT_KEY_RECORD(length)                                                  \
+  ((sizeof(uint32_t) + (length) + 1 + 3) & ~(size_t)3)
+
+// Nejmenší pole uzlů a buffer klíčů
+#define HT_MIN_NODES 16
+#define HT_MIN_KEYS 256
+
+// Horních 31 bitů hashe, které se ukládají do uzlu
+static inline uint32_t ht_hash_tag(uint64_t hash) {
+  return (uint32_t)(hash >> 33);
+}
+
+/*
+ * Převede horních 31 bitů hashe na index z intervalu <0,size-1> bez
+ * dělení (jako ht_index zřetězené varianty). Index se tak spočítá
+ * i z uzlu, který celý hash nemá, a pole se přestaví bez hashování klíčů.
+ */
+static inline size_t ht_index(uint32_t tag, size_t size) {
+  return (size_t)(((uint64_t)tag * size) >> 31);
+}
+
+// Délka a bajty klíče uzlu v bufferu klíčů
+static inline uint32_t ht_key_length(const ht_table_t *table,
+                                     const ht_node_t *node) {
+  uint32_t length;
+  memcpy(&length, table->keys + node->key, sizeof(length));
+  return length;
+}
+
+static inline char *ht_key(const ht_table_t *table, const ht_node_t *node) {
+  return table->keys + node->key + sizeof(uint32_t);
+}
+
+/*
+ * Porovná uzel s hledaným klíčem. Bajty klíče se porovnávají jen tehdy,
+ * když se shoduje uložená část hashe i délka klíče.
+ */
+static inline bool ht_node_matches(const ht_table_t *table,
+                                   const ht_node_t *node, const char *key,
+                                   size_t length, uint32_t tag) {
+  return node->hash == tag && ht_key_length(table, node) == length &&
+         memcmp(ht_key(table, node), key, length) == 0;
+}
+
+/*
+ * Najde uzel s klíčem o známé délce a hashi a vrátí jeho index, nebo
+ * HT_NIL. Pokud visited není NULL, uloží do něj počet prošlých uzlů.
+ */
+static uint32_t ht_find(ht_table_t *table, const char *key, size_t length,
+                        uint64_t hash, size_t *visited) {
+  size_t walked = 0;
+  uint32_t found = HT_NIL;
+  if (table->buckets != NULL) {
+    uint32_t tag = ht_hash_tag(hash);
+    for (uint32_t i = table->buckets[ht_index(tag, table->size)]; i != HT_NIL;
+         i = table->nodes[i].next) {
+      walked++;
+      if (ht_node_matches(table, &table->nodes[i], key, length, tag)) {
+        found = i;
+        break;
+      }
+    }
+  }
+  ht_count_probes(table, walked);
+  if (visited != NULL) {
+    *visited = walked;
+  }
+  return found;
+}
+
+/*
+ * Rozmístí všechny uzly do pole buckets o size seznamech (pole se nejprve
+ * vyprázdní).
+ */
+static void ht_link(ht_table_t *table, uint32_t *buckets, size_t size) {
+  memset(buckets, 0xff, size * sizeof(uint32_t));
+  for (uint32_t i = 0; i < table->count; i++) {
+    size_t index = ht_index(table->nodes[i].hash, size);
+    table->nodes[i].next = buckets[index];
+    buckets[index] = i;
+  }
+}
+
+/*
+ * Přepojí všechny uzly do nového pole o new_size seznamech. Při rehash se
+ * hashe klíčů nejprve spočítají znovu se semínkem tabulky. Uzly ani klíče
+ * se nepřesouvají. Při chybě alokace vrací false a tabulka zůstane beze
+ * změny.
+ */
+static bool ht_relink(ht_table_t *table, size_t new_size, bool rehash) {
+  uint32_t *buckets = malloc(new_size * sizeof(uint32_t));
+  if (buckets == NULL) {
+    return false;
+  }
+
+  for (uint32_t i = 0; rehash && i < table->count; i++) {
+    ht_node_t *node = &table->nodes[i];
+    node->hash = ht_hash_tag(ht_hash_bytes(
+        ht_key(table, node), ht_key_length(table, node), table->seed));
+  }
+  ht_link(table, buckets, new_size);
+
+  free(table->buckets);
+  table->buckets = buckets;
+  table->size = new_size;
+  return true;
+}
+
+/*
+ * Změní velikost pole uzlů i pole hodnot na capacity. Pokud se při
+ * zvětšení podaří zvětšit jen pole uzlů, vrací false a node_capacity
+ * se nemění (větší pole uzlů nevadí); při zmenšení stačí zmenšit pole
+ * uzlů.
+ */
+static bool ht_resize_nodes(ht_table_t *table, size_t capacity) {
+  ht_node_t *nodes = realloc(table->nodes, capacity * sizeof(ht_node_t));
+  if (nodes == NULL) {
+    return false;
+  }
+  table->nodes = nodes;
+  float *values = realloc(table->values, capacity * sizeof(float));
+  if (values == NULL && capacity > table->node_capacity) {
+    return false;
+  }
+  if (values != NULL) {
+    table->values = values;
+  }
+  table->node_capacity = capacity;
+  return true;
+}
+
+/*
+ * Zhustí klíče živých prvků na začátek nového bufferu (mrtvé bajty
+ * zmizí), rozmístí uzly do pole o new_size seznamech a zmenší pole uzlů
+ * a hodnot na počet prvků. Pořadí uzlů se nemění, ručička CLOCK proto
+ * zůstane na místě. Při chybě alokace vrací false a tabulka zůstane beze
+ * změny.
+ */
+static bool ht_compact(ht_table_t *table, size_t new_size) {
+  size_t keys_capacity = table->keys_used - table->keys_dead;
+  keys_capacity = keys_capacity > HT_MIN_KEYS ? keys_capacity : HT_MIN_KEYS;
+  char *keys = malloc(keys_capacity);
+  uint32_t *buckets = malloc(new_size * sizeof(uint32_t));
+  if (keys == NULL || buckets == NULL) {
+    free(keys);
+    free(buckets);
+    return false;
+  }
+
+  size_t used = 0;
+  for (uint32_t i = 0; i < table->count; i++) {
+    ht_node_t *node = &table->nodes[i];
+    size_t record = HT_KEY_RECORD(ht_key_length(table, node));
+    memcpy(keys + used, table->keys + node->key, record);
+    node->key = (uint32_t)used;
+    used += record;
+  }
+  ht_link(table, buckets, new_size);
+
+  free(table->keys);
+  free(table->buckets);
+  table->keys = keys;
+  table->keys_used = used;
+  table->keys_capacity = keys_capacity;
+  table->keys_dead = 0;
+  table->buckets = buckets;
+  table->size = new_size;
+  // Zmenšení polí uzlů a hodnot je jen úspora, jeho selhání nevadí
+  ht_resize_nodes(table, table->count > HT_MIN_NODES ? table->count
+                                                     : HT_MIN_NODES);
+  return true;
+}
+
+/*
+ * Zajistí místo pro nový uzel a záznam klíče o record bajtech. Pole uzlů
+ * a hodnot i buffer klíčů rostou na jedenapůlnásobek, aby nevyužitá
+ * rezerva zůstala menší než u zdvojnásobení. Při chybě alokace vrací
+ * false.
+ */
+static bool ht_reserve(ht_table_t *table, size_t record) {
+  if (table->count == table->node_capacity) {
+    size_t capacity = table->node_capacity + table->node_capacity / 2;
+    capacity = capacity > HT_MIN_NODES ? capacity : HT_MIN_NODES;
+    capacity = capacity < HT_NIL ? capacity : HT_NIL;
+    if (capacity <= table->node_capacity) {
+      return false;  // Index uzlu by se do 32 bitů nevešel
+    }
+    if (!ht_resize_nodes(table, capacity)) {
+      return false;
+    }
+  }
+
+  if (table->keys_capacity - table->keys_used < record) {
+    if (table->keys_used + record > HT_NIL) {
+      return false;  // Posun klíče by se do 32 bitů nevešel
+    }
+    size_t capacity = table->keys_capacity + table->keys_capacity / 2;
+    capacity = capacity > table->keys_used + record ? capacity
+                                                    : table->keys_used + record;
+    capacity = capacity > HT_MIN_KEYS ? capacity : HT_MIN_KEYS;
+    capacity = capacity < HT_NIL ? capacity : HT_NIL;
+    char *keys = realloc(table->keys, capacity);
+    if (keys == NULL) {
+      return false;
+    }
+    table->keys = keys;
+    table->keys_capacity = capacity;
+  }
+  return true;
+}
+
+/*
+ * Odstraní uzel index, na který ukazuje link (začátek seznamu synonym
+ * nebo next předchůdce). Bajty jeho klíče se započtou jako mrtvé a na
+ * jeho místo se přesune poslední uzel i s hodnotou; odkaz na přesunutý
+ * uzel se najde průchodem jeho seznamu synonym.
+ */
+static void ht_remove(ht_table_t *table, uint32_t index, uint32_t *link) {
+  ht_node_t *node = &table->nodes[index];
+  table->keys_dead += HT_KEY_RECORD(ht_key_length(table, node));
+  *link = node->next;
+
+  uint32_t last = (uint32_t)table->count - 1;
+  if (index != last) {
+    uint32_t *moved =
+        &table->buckets[ht_index(table->nodes[last].hash, table->size)];
+    while (*moved != last) {
+      moved = &table->nodes[*moved].next;
+    }
+    *moved = index;
+    table->nodes[index] = table->nodes[last];
+    table->values[index] = table->values[last];
+  }
+  table->count--;
+}
+
+/*
+ * Po smazání prvku zmenší pole, klesl-li faktor naplnění pod
+ * 1/HT_MIN_LOAD_DIV (nejvýše na počáteční velikost), jinak zhustí buffer
+ * klíčů, tvoří-li mrtvé bajty víc než jeho polovinu. Klíče se zhušťují
+ * v obou případech; každé zhuštění předchází alespoň tolik smazání,
+ * kolik živých klíčů přesouvá.
+ */
+static void ht_shrink(ht_table_t *table) {
+  if (table->size > table->min_size &&
+      table->count * HT_MIN_LOAD_DIV < table->size) {
+    size_t new_size = table->count * 2;
+    ht_compact(table, new_size > table->min_size ? new_size : table->min_size);
+  } else if (table->keys_dead * 2 > table->keys_used) {
+    ht_compact(table, table->size);
+  }
+}
+
+/*
+ * Inicializace tabulky — zavolá se před prvním použitím tabulky.
+ *
+ * Pole tabulky o velikosti HT_SIZE se alokuje až při prvním vložení.
+ * Tabulka začíná s náhodným semínkem (při vypnutém HT_RANDOM_SEED
+ * s nulovým), jiné lze nastavit funkcí ht_set_seed.
+ */
+void ht_init(ht_table_t *table) {
+  table->buckets = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->min_size = HT_SIZE > 0 ? (size_t)HT_SIZE : 1;
+  table->capacity = 0;
+  table->clock_hand = 0;
+  table->nodes = NULL;
+  table->values = NULL;
+  table->node_capacity = 0;
+  table->keys = NULL;
+  table->keys_used = 0;
+  table->keys_capacity = 0;
+  table->keys_dead = 0;
+  table->seed = HT_RANDOM_SEED ? ht_random_seed() : 0;
+#if HT_STATS
+  memset(&table->stats, 0, sizeof(table->stats));
+#endif
+}
+
+/*
+ * Statistiky paměti prvků tabulky (pole uzlů a hodnot a buffer klíčů):
+ * rezervovaná paměť, paměť živých uzlů, hodnot a klíčů, paměť mrtvých
+ * klíčů a podíl nevyužité paměti.
+ */
+void ht_alloc_stats(ht_table_t *table, ht_arena_stats_t *stats) {
+  size_t node = sizeof(ht_node_t) + sizeof(float);
+  stats->reserved = table->node_capacity * node + table->keys_capacity;
+  stats->live = table->count * node + table->keys_used - table->keys_dead;
+  stats->free = table->keys_dead;
+  size_t used = stats->live + stats->free;
+  stats->fragmentation = used == 0 ? 0 : (double)stats->free / used;
+}
+
+/*
+ * Nastavení semínka rozptylovací funkce tabulky.
+ *
+ * Pokud tabulka již obsahuje prvky, spočítá hashe všech klíčů znovu
+ * a přepojí uzly podle nového semínka.
+ */
+void ht_set_seed(ht_table_t *table, uint64_t seed) {
+  uint64_t old_seed = table->seed;
+  table->seed = seed;
+  if (table->buckets != NULL && !ht_relink(table, table->size, true)) {
+    table->seed = old_seed;  // Uzly zůstaly rozmístěné podle starého
+  }
+}
+
+/*
+ * Filtr příslušnosti (viz filter.h) kompaktní varianta nepodporuje: jeho
+ * čítače by přidaly paměť na každý klíč, kterou tato varianta šetří, a
+ * uzel nemá celý hash, ze kterého by se filtr po zvětšení znovu naplnil.
+ * Pro fp_rate v intervalu (0,1) proto vrací false, jinak (vypnutí filtru)
+ * true.
+ */
+bool ht_set_filter(ht_table_t *table, double fp_rate, size_t max_bytes) {
+  (void)table;
+  (void)max_bytes;
+  return !(fp_rate > 0 && fp_rate < 1);
+}
+
+/*
+ * Vyhodí jeden prvek algoritmem CLOCK (viz ht_set_capacity). Ručička
+ * prochází pole uzlů po řadě, uzlům s referenčním bitem ho vynuluje
+ * a první uzel bez něj vyjme z jeho seznamu synonym a odstraní. Na jeho
+ * místo se přesune poslední uzel, ručička proto zůstane stát a ten uzel
+ * prohlédne příště. Vrací false, pokud je tabulka prázdná.
+ */
+static bool ht_evict(ht_table_t *table) {
+  if (table->count == 0) {
+    return false;
+  }
+  for (;;) {
+    if (table->clock_hand >= table->count) {
+      table->clock_hand = 0;
+    }
+    uint32_t index = (uint32_t)table->clock_hand;
+    ht_node_t *node = &table->nodes[index];
+    if (node->referenced) {
+      node->referenced = 0;
+      table->clock_hand++;
+      continue;
+    }
+
+    uint32_t *link = &table->buckets[ht_index(node->hash, table->size)];
+    while (*link != index) {
+      link = &table->nodes[*link].next;
+    }
+    ht_remove(table, index, link);
+    HT_COUNT(table, evictions);
+    ht_shrink(table);  // Klíče vyhozených prvků by jinak buffer jen zvětšovaly
+    return true;
+  }
+}
+
+/*
+ * Omezení počtu prvků tabulky na capacity (0 = bez omezení). Tabulka se
+ * pak chová jako cache: když je plná, vkládající funkce před vložením
+ * nového klíče vyhodí jiný prvek přibližným LRU (algoritmus CLOCK, viz
+ * zřetězená varianta). Referenční bit leží v uzlu vedle části hashe.
+ * Pokud má tabulka víc
+ * prvků, vyhodí se nadbytečné hned.
+ */
+bool ht_set_capacity(ht_table_t *table, size_t capacity) {
+  table->capacity = capacity;
+  while (capacity > 0 && table->count > capacity) {
+    ht_evict(table);
+  }
+  return true;
+}
+
+/*
+ * Vyhledání uzlu s klíčem o známé délce a hashi (ht_search, ht_get a
+ * jejich varianty). Vrací index uzlu, nebo HT_NIL.
+ */
+static uint32_t ht_search_hashed(ht_table_t *table, const char *key,
+                                 size_t length, uint64_t hash) {
+  uint32_t index = ht_find(table, key, length, hash, NULL);
+  ht_count_search(table, index != HT_NIL);
+  if (index != HT_NIL && table->capacity > 0 &&
+      !table->nodes[index].referenced) {
+    table->nodes[index].referenced = 1;
+  }
+  return index;
+}
+
+/*
+ * Vyplní pohled tabulky (ht_item_t) podle nalezeného uzlu.
+ */
+static ht_item_t *ht_view(ht_table_t *table, uint32_t index) {
+  if (index == HT_NIL) {
+    return NULL;
+  }
+  ht_node_t *node = &table->nodes[index];
+  table->view.key = ht_key(table, node);
+  table->view.value = table->values[index];
+  table->view.length = ht_key_length(table, node);
+  return &table->view;
+}
+
+/*
+ * Vyhledání prvku podle klíče o délce length, který nemusí končit nulovým
+ * znakem (např. úsek vstupního bufferu). Jinak stejné jako ht_search.
+ *
+ * Prvek je jen kopií uzlu pro čtení, která platí do dalšího volání
+ * ht_search nebo změny tabulky; hodnotu lze měnit přes ht_get.
+ */
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length) {
+  return ht_view(table,
+                 ht_search_hashed(table, key, length,
+                                  ht_hash_bytes(key, length, table->seed)));
+}
+
+/*
+ * Vyhledání prvku podle klíče s předem spočítaným hashem (viz ht_key_t).
+ * Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_key(ht_table_t *table, const ht_key_t *key) {
+  return ht_view(table,
+                 ht_search_hashed(table, key->data, key->length,
+                                  ht_handle_hash(key, table->seed)));
+}
+
+/*
+ * Vložení prvku s klíčem o známé délce a hashi (viz ht_insert). Seznam
+ * synonym se projde jen jednou. Pokud prvek s klíčem už existuje, jeho
+ * hodnota se přepíše jen při replace. Vrací index existujícího nebo
+ * nového uzlu, při chybě HT_NIL.
+ */
+static uint32_t ht_insert_hashed(ht_table_t *table, const char *key,
+                                 size_t length, uint64_t hash, float value,
+                                 bool replace) {
+  if (length > HT_MAX_KEY_LENGTH) {
+    return HT_NIL;  // Délka klíče se do prvku nevejde
+  }
+  size_t chain;
+  uint32_t index = ht_find(table, key, length, hash, &chain);
+  if (index != HT_NIL) {
+    ht_node_t *node = &table->nodes[index];
+    if (replace) {
+      table->values[index] = value;
+    }
+    if (table->capacity > 0 && !node->referenced) {
+      node->referenced = 1;
+    }
+    HT_COUNT(table, updates);
+    return index;
+  }
+
+  // Plná tabulka s omezenou kapacitou uvolní místo pro nový prvek
+  if (table->capacity > 0 && table->count >= table->capacity) {
+    ht_evict(table);
+  }
+
+  // První vložení alokuje pole o počáteční velikosti, překročení faktoru
+  // naplnění ho zdvojnásobí
+  if (table->buckets == NULL &&
+      !ht_relink(table, table->min_size, false)) {
+    return HT_NIL;  // Ošetření chyby při alokaci paměti
+  }
+  if (table->count >= table->size * HT_MAX_LOAD) {
+    ht_relink(table, table->size * 2, false);
+  }
+
+  size_t record = HT_KEY_RECORD(length);
+  if (!ht_reserve(table, record)) {
+    return HT_NIL;  // Ošetření chyby při alokaci paměti
+  }
+
+  // Zkopírujeme délku a bajty klíče na konec bufferu a ukončíme ho
+  uint32_t stored_length = (uint32_t)length;
+  char *block = table->keys + table->keys_used;
+  memcpy(block, &stored_length, sizeof(stored_length));
+  memcpy(block + sizeof(uint32_t), key, length);
+  memset(block + sizeof(uint32_t) + length, 0,
+         record - sizeof(uint32_t) - length);
+
+  // Nový uzel a hodnota se připojí na konec hustých polí
+  index = (uint32_t)table->count;
+  ht_node_t *node = &table->nodes[index];
+  node->key = (uint32_t)table->keys_used;
+  node->hash = ht_hash_tag(hash);
+  node->referenced = 0;
+  table->values[index] = value;
+  table->keys_used += record;
+
+  // Vložíme nový uzel na začátek seznamu synonym
+  uint32_t *head = &table->buckets[ht_index(node->hash, table->size)];
+  node->next = *head;
+  *head = index;
+  table->count++;
+  HT_COUNT(table, inserts);
+
+  // Příliš dlouhý seznam synonym značí cíleně kolidující klíče
+  size_t load = table->count / table->size;
+  if (chain + 1 > HT_FLOOD_CHAIN * (load > 1 ? load : 1)) {
+    HT_COUNT(table, reseeds);
+    ht_set_seed(table, ht_random_seed());
+  }
+  return index;
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahradí jeho hodnotu.
+ * Pokud by nový prvek překročil faktor naplnění, pole se nejprve
+ * zdvojnásobí.
+ */
+void ht_insert(ht_table_t *table, char *key, float value) {
+  ht_upsert(table, key, value);
+}
+
+/*
+ * Vložení prvku s klíčem o délce length, který nemusí končit nulovým
+ * znakem. Klíč se zkopíruje jen při vytvoření nového prvku.
+ */
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value) {
+  ht_insert_hashed(table, key, length, ht_hash_bytes(key, length, table->seed),
+                   value, true);
+}
+
+/*
+ * Vložení prvku s klíčem s předem spočítaným hashem (viz ht_key_t).
+ */
+void ht_insert_key(ht_table_t *table, const ht_key_t *key, float value) {
+  ht_insert_hashed(table, key->data, key->length,
+                   ht_handle_hash(key, table->seed), value, true);
+}
+
+/*
+ * Vložení nebo přepsání hodnoty jako ht_insert.
+ *
+ * Vrací ukazatel na hodnotu v poli hodnot, při chybě NULL. Ukazatel platí
+ * jen do další změny tabulky: pole se při růstu přesouvá a smazání na
+ * místo smazané hodnoty přesune poslední.
+ */
+float *ht_upsert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  uint32_t index = ht_insert_hashed(
+      table, key, length, ht_hash_bytes(key, length, table->seed), value, true);
+  return index != HT_NIL ? &table->values[index] : NULL;
+}
+
+/*
+ * Získání hodnoty, a pokud klíč v tabulce není, vložení prvku s hodnotou
+ * value. Klíč se hashuje jen jednou.
+ *
+ * Vrací ukazatel na hodnotu prvku (platný jako u ht_upsert), při chybě
+ * NULL.
+ */
+float *ht_get_or_insert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  uint32_t index =
+      ht_insert_hashed(table, key, length,
+                       ht_hash_bytes(key, length, table->seed), value, false);
+  return index != HT_NIL ? &table->values[index] : NULL;
+}
+
+/*
+ * Získání hodnoty podle klíče o délce length, který nemusí končit nulovým
+ * znakem. Jinak stejné jako ht_get. Ukazatel míří do hustého pole hodnot
+ * a platí jako u ht_upsert.
+ */
+float *ht_get_n(ht_table_t *table, const char *key, size_t length) {
+  uint32_t index = ht_search_hashed(table, key, length,
+                                    ht_hash_bytes(key, length, table->seed));
+  return index != HT_NIL ? &table->values[index] : NULL;
+}
+
+/*
+ * Získání hodnoty podle klíče s předem spočítaným hashem (viz ht_key_t).
+ */
+float *ht_get_key(ht_table_t *table, const ht_key_t *key) {
+  uint32_t index = ht_search_hashed(table, key->data, key->length,
+                                    ht_handle_hash(key, table->seed));
+  return index != HT_NIL ? &table->values[index] : NULL;
+}
+
+/*
+ * Dávkové získání hodnot: values[i] dostane výsledek ht_get(table, keys[i]).
+ *
+ * Klíče se zpracovávají po HT_BATCH_SIZE: nejprve se spočítají hashe
+ * a přednačtou začátky seznamů synonym, pak se přednačtou první uzly
+ * seznamů a teprve nakonec se seznamy projdou. Výpadky cache různých
+ * klíčů se tak překrývají.
+ */
+void ht_get_many(ht_table_t *table, char *keys[], size_t count,
+                 float *values[]) {
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    char **batch_keys = keys + start;
+    float **batch_values = values + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_keys[i]);
+      hashes[i] = ht_hash_bytes(batch_keys[i], lengths[i], table->seed);
+      if (table->buckets != NULL) {
+        HT_PREFETCH(&table->buckets[ht_index(ht_hash_tag(hashes[i]),
+                                             table->size)]);
+      }
+    }
+
+    // Přednačtení prvního uzlu každého neprázdného seznamu
+    for (size_t i = 0; i < batch && table->buckets != NULL; i++) {
+      uint32_t head =
+          table->buckets[ht_index(ht_hash_tag(hashes[i]), table->size)];
+      if (head != HT_NIL) {
+        HT_PREFETCH(&table->nodes[head]);
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      uint32_t index =
+          ht_search_hashed(table, batch_keys[i], lengths[i], hashes[i]);
+      batch_values[i] = index != HT_NIL ? &table->values[index] : NULL;
+    }
+  }
+}
+
+/*
+ * Dávkové vložení count prvků (klíč a hodnota z items[i]).
+ *
+ * Vkládání mění tabulku, proto se prvky vkládají postupně; pro každou
+ * dávku se ale předem spočítají hashe a přednačtou začátky seznamů.
+ */
+void ht_insert_many(ht_table_t *table, const ht_item_t items[], size_t count) {
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    const ht_item_t *batch_items = items + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_items[i].key);
+      hashes[i] = ht_hash_bytes(batch_items[i].key, lengths[i], table->seed);
+      if (table->buckets != NULL) {
+        HT_PREFETCH(&table->buckets[ht_index(ht_hash_tag(hashes[i]),
+                                             table->size)]);
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_insert_hashed(table, batch_items[i].key, lengths[i], hashes[i],
+                       batch_items[i].value, true);
+    }
+  }
+}
+
+// Uzly a klíče se přidělují ze společných polí, vstup má jediný úsek
+static size_t ht_build_shard(uint64_t hash, const void *context) {
+  (void)hash;
+  (void)context;
+  return 0;
+}
+
+/*
+ * Paralelní vložení count prvků (klíč keys[i] s hodnotou values[i]);
+ * výsledek je stejný jako po postupném ht_insert.
+ *
+ * Nové uzly i klíče se připojují na konec společných polí, vkládá se proto
+ * v jednom vlákně a threads vláken jen předem spočítá hashe klíčů. Pole
+ * seznamů synonym se před vkládáním jednou přepojí na velikost pro
+ * všechny nové klíče. Při chybě alokace vrací false; klíče vložené do té
+ * doby v tabulce zůstanou.
+ */
+bool ht_build_parallel(ht_table_t *table, char *keys[], const float values[],
+                       size_t count, int threads) {
+  size_t size = table->size > 0 ? table->size : table->min_size;
+  while (size * HT_MAX_LOAD < table->count + count) {
+    size *= 2;
+  }
+  if ((table->buckets == NULL || size > table->size) &&
+      !ht_relink(table, size, false)) {
+    return false;
+  }
+
+  ht_partition_t partition;
+  uint64_t seed = table->seed;
+  if (!ht_partition(&partition, keys, count, seed, 1, ht_build_shard, NULL,
+                    threads)) {
+    return false;
+  }
+  bool ok = true;
+  for (size_t i = 0; i < count && ok; i++) {
+    size_t length = strlen(keys[i]);
+    // Ochrana před zahlcením kolizemi mohla změnit semínko
+    uint64_t hash = table->seed == seed
+                        ? partition.hashes[i]
+                        : ht_hash_bytes(keys[i], length, table->seed);
+    ok = ht_insert_hashed(table, keys[i], length, hash, values[i], true) !=
+         HT_NIL;
+  }
+  ht_partition_free(&partition);
+  return ok;
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Funkce vyjme uzel ze seznamu synonym a odstraní ho (ht_remove), po
+ * hromadném mazání pole zmenší nebo zhustí (ht_shrink). Pokud prvek
+ * neexistuje, funkce nedělá nic.
+ */
+void ht_delete(ht_table_t *table, char *key) {
+  if (table->buckets == NULL) {
+    return;
+  }
+
+  size_t length = strlen(key);
+  uint32_t tag = ht_hash_tag(ht_hash_bytes(key, length, table->seed));
+  uint32_t *link = &table->buckets[ht_index(tag, table->size)];
+  size_t visited = 0;
+
+  while (*link != HT_NIL) {
+    visited++;
+    uint32_t index = *link;
+    ht_node_t *node = &table->nodes[index];
+    if (ht_node_matches(table, node, key, length, tag)) {
+      ht_count_probes(table, visited);
+      ht_remove(table, index, link);
+      HT_COUNT(table, deletes);
+      ht_shrink(table);
+      return;
+    }
+    link = &node->next;
+  }
+  ht_count_probes(table, visited);
+}
+
+/*
+ * Smazání všech prvků z tabulky.
+ *
+ * Funkce uvolní pole tabulky, pole uzlů a hodnot a buffer klíčů (bez
+ * procházení jednotlivých prvků) a uvede tabulku do stavu po inicializaci.
+ * Omezení kapacity (ht_set_capacity) zůstává.
+ */
+void ht_delete_all(ht_table_t *table) {
+  free(table->buckets);
+  free(table->nodes);
+  free(table->values);
+  free(table->keys);
+
+  table->buckets = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->clock_hand = 0;
+  table->nodes = NULL;
+  table->values = NULL;
+  table->node_capacity = 0;
+  table->keys = NULL;
+  table->keys_used = 0;
+  table->keys_capacity = 0;
+  table->keys_dead = 0;
+}
+
+/*
+ * Statistiky tabulky: počítadla operací (viz ht_stats_t) a stav pole.
+ * Nejdelší seznam synonym se hledá průchodem celého pole. Paměť zahrnuje
+ * pole seznamů, celá pole uzlů a hodnot i buffer klíčů včetně rezervy.
+ */
+void ht_stats(ht_table_t *table, ht_stats_t *stats) {
+#if HT_STATS
+  *stats = table->stats;
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+  stats->count = table->count;
+  stats->size = table->size;
+  stats->capacity = table->capacity;
+  stats->longest_chain = 0;
+  for (size_t i = 0; table->buckets != NULL && i < table->size; i++) {
+    size_t length = 0;
+    for (uint32_t index = table->buckets[i]; index != HT_NIL;
+         index = table->nodes[index].next) {
+      length++;
+    }
+    stats->longest_chain =
+        length > stats->longest_chain ? length : stats->longest_chain;
+  }
+  stats->load_factor =
+      stats->size > 0 ? (double)stats->count / stats->size : 0;
+  stats->hit_ratio =
+      stats->searches > 0 ? (double)stats->hits / stats->searches : 0;
+  stats->bytes = (table->buckets != NULL ? table->size * sizeof(uint32_t)
+                                         : 0) +
+                 table->node_capacity * (sizeof(ht_node_t) + sizeof(float)) +
+                 table->keys_capacity;
+}
+
+/*
+ * Na hodnotu každého prvku použije x * scale + offset a výsledek ořízne na
+ * interval <min, max> (viz ht_floats_map). Projde jen husté pole hodnot,
+ * uzlů ani klíčů se nedotkne.
+ */
+void ht_values_map(ht_table_t *table, float scale, float offset, float min,
+                   float max) {
+  ht_floats_map(table->values, table->count, scale, offset, min, max);
+}
+
+// Součet, nejmenší a největší hodnota všech prvků (viz values.c)
+double ht_values_sum(ht_table_t *table) {
+  return ht_floats_sum(table->values, table->count);
+}
+
+float ht_values_min(ht_table_t *table) {
+  return ht_floats_min(table->values, table->count);
+}
+
+float ht_values_max(ht_table_t *table) {
+  return ht_floats_max(table->values, table->count);
+}
+
+/*
+ * Smazání všech prvků s hodnotou mimo interval <min, max> (i NaN).
+ *
+ * Zachované hodnoty se nejprve označí v bitové mapě (ht_floats_select),
+ * pak se zachované uzly s hodnotami posunou v původním pořadí na začátek
+ * polí a pole seznamů se naplní znovu, místo aby se každý prvek
+ * vyjímal ze svého seznamu zvlášť. Nakonec se tabulka případně zmenší
+ * nebo zhustí jako po ht_delete. Vrací počet smazaných prvků; při chybě
+ * alokace bitové mapy nesmaže nic a vrací 0.
+ */
+size_t ht_values_filter(ht_table_t *table, float min, float max) {
+  size_t count = table->count;
+  if (count == 0) {
+    return 0;
+  }
+  uint8_t *keep = malloc((count + 7) / 8);
+  if (keep == NULL) {
+    return 0;
+  }
+  size_t kept = ht_floats_select(table->values, count, min, max, keep);
+  if (kept == count) {
+    free(keep);
+    return 0;
+  }
+
+  size_t used = 0;
+  size_t clock_hand = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (keep[i / 8] & (1u << (i % 8))) {
+      table->nodes[used] = table->nodes[i];
+      table->values[used] = table->values[i];
+      clock_hand += i < table->clock_hand;
+      used++;
+    } else {
+      table->keys_dead += HT_KEY_RECORD(ht_key_length(table, &table->nodes[i]));
+    }
+  }
+  free(keep);
+
+  table->count = kept;
+  table->clock_hand = clock_hand;
+  ht_link(table, table->buckets, table->size);
+#if HT_STATS
+  table->stats.deletes += count - kept;
+#endif
+  ht_shrink(table);
+  return count - kept;
+}
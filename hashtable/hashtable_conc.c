@@ -0,0 +1,1147 @@
+/*
+ * Tabulka s rozptýlenými položkami — souběžná varianta
+ *
+ * Varianta se stejným rozhraním jako hashtable.c, kterou mohou současně
+ * používat vlákna. Čtení (ht_search, ht_get) neberou žádný zámek:
+ * prvky se do seznamů synonym zveřejňují atomickým zápisem s release
+ * sémantikou a již zveřejněný prvek se nikdy nemění — změna hodnoty ho
+ * nahradí novou kopií. Zapisující vlákna se vylučují zámky (HT_LOCK_STRIPES
+ * zámků, každý pro pevný rozsah horních bitů hashe, a tedy pro pevnou
+ * množinu seznamů synonym). Změna velikosti pole zamkne všechny zámky,
+ * zkopíruje prvky do nového pole a to atomicky zveřejní.
+ *
+ * Odstraněné prvky a pole se neuvolňují hned, protože je mohou právě
+ * procházet čtenáři. Uvolní se epochovou správou paměti: čtenář při vstupu
+ * oznámí aktuální globální epochu a odstraněný blok se uvolní, až když
+ * žádný čtenář nečte v epoše, ve které byl blok odstraněn, nebo dřívější.
+ */
+
+#include "hashtable.h"
+#include "parallel.h"
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Velikost prvku s klíčem o délce length (včetně nulového terminátoru)
+#define HT_ITEM_SIZE(length) (sizeof(ht_item_t) + (length) + 1)
+
+// Počet odstraněných bloků, po kterém se zkusí uvolnit paměť
+#define HT_RECLAIM_THRESHOLD 64
+
+// Co ht_update udělá s hodnotou existujícího prvku
+typedef enum {
+  HT_UPDATE_SET,   // přepíše ji novou hodnotou
+  HT_UPDATE_KEEP,  // ponechá ji
+  HT_UPDATE_ADD,   // přičte k ní novou hodnotu
+} ht_update_mode_t;
+
+// Záznam vlákna pro epochovou správu paměti (každý na vlastní řádce cache)
+typedef struct {
+  _Alignas(64) _Atomic uint64_t epoch; // epocha čtení, 0 = vlákno nečte
+  atomic_int used;                     // záznam patří živému vláknu
+} ht_thread_record_t;
+
+static ht_thread_record_t ht_threads[HT_MAX_THREADS];
+static _Atomic uint64_t ht_global_epoch = 1;
+static _Thread_local ht_thread_record_t *ht_self;
+static _Thread_local unsigned ht_read_depth;
+static pthread_key_t ht_thread_key;
+static pthread_once_t ht_thread_once = PTHREAD_ONCE_INIT;
+
+// Při ukončení vlákna uvolní jeho záznam
+static void ht_thread_exit(void *record) {
+  atomic_store(&((ht_thread_record_t *)record)->used, 0);
+}
+
+static void ht_thread_key_init(void) {
+  pthread_key_create(&ht_thread_key, ht_thread_exit);
+}
+
+/*
+ * Vrátí záznam volajícího vlákna, při prvním volání mu ho přidělí.
+ * Pokud pracuje HT_MAX_THREADS vláken, čeká na ukončení některého z nich.
+ */
+static ht_thread_record_t *ht_thread_record(void) {
+  if (ht_self != NULL) {
+    return ht_self;
+  }
+  pthread_once(&ht_thread_once, ht_thread_key_init);
+  for (;;) {
+    for (int i = 0; i < HT_MAX_THREADS; i++) {
+      int expected = 0;
+      if (atomic_compare_exchange_strong(&ht_threads[i].used, &expected, 1)) {
+        ht_self = &ht_threads[i];
+        pthread_setspecific(ht_thread_key, ht_self);
+        return ht_self;
+      }
+    }
+    sched_yield();
+  }
+}
+
+/*
+ * Začátek čtení. Dokud vlákno nezavolá ht_read_unlock, nebude uvolněn
+ * žádný prvek, který mohlo během čtení vidět. Volání lze vnořovat.
+ */
+void ht_read_lock(void) {
+  ht_thread_record_t *self = ht_thread_record();
+  if (ht_read_depth++ == 0) {
+    atomic_store(&self->epoch, atomic_load(&ht_global_epoch));
+    atomic_thread_fence(memory_order_seq_cst);
+  }
+}
+
+/*
+ * Konec čtení začatého funkcí ht_read_lock.
+ */
+void ht_read_unlock(void) {
+  if (--ht_read_depth == 0) {
+    atomic_store_explicit(&ht_self->epoch, 0, memory_order_release);
+  }
+}
+
+/*
+ * Uvolní odstraněné bloky, které už žádný čtenář nemůže vidět. Volá se se
+ * zamčeným retire_lock.
+ */
+static void ht_reclaim(ht_table_t *table) {
+  atomic_fetch_add(&ht_global_epoch, 1);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  // Nejstarší epocha, ve které ještě některé vlákno čte
+  uint64_t oldest = UINT64_MAX;
+  for (int i = 0; i < HT_MAX_THREADS; i++) {
+    if (atomic_load_explicit(&ht_threads[i].used, memory_order_relaxed)) {
+      uint64_t epoch = atomic_load(&ht_threads[i].epoch);
+      if (epoch != 0 && epoch < oldest) {
+        oldest = epoch;
+      }
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < table->retired_count; i++) {
+    ht_retired_t *retired = &table->retired[i];
+    if (retired->epoch < oldest) {
+      table->retired_bytes -= retired->bytes;
+      free(retired->block);
+    } else {
+      table->retired[kept++] = *retired;
+    }
+  }
+  table->retired_count = kept;
+  // Bloky, které ještě nešlo uvolnit, zkusíme znovu až po dalších odstraněních
+  table->retired_limit = kept * 2 > HT_RECLAIM_THRESHOLD
+                             ? kept * 2
+                             : HT_RECLAIM_THRESHOLD;
+}
+
+/*
+ * Odstraněný blok zařadí k pozdějšímu uvolnění. Blok už nesmí být
+ * dosažitelný z tabulky.
+ */
+static void ht_retire(ht_table_t *table, void *block, size_t bytes) {
+  pthread_mutex_lock(&table->retire_lock);
+  if (table->retired_count == table->retired_capacity) {
+    size_t capacity =
+        table->retired_capacity == 0 ? HT_RECLAIM_THRESHOLD
+                                     : table->retired_capacity * 2;
+    ht_retired_t *retired =
+        realloc(table->retired, capacity * sizeof(ht_retired_t));
+    if (retired == NULL) {
+      /*
+       * Bez místa v seznamu nelze blok bezpečně uvolnit (čekat na čtenáře
+       * nejde, zapisující vlákna jsou také čtenáři a mohou čekat na naše
+       * zámky). Blok proto raději ponecháme neuvolněný.
+       */
+      pthread_mutex_unlock(&table->retire_lock);
+      return;
+    }
+    table->retired = retired;
+    table->retired_capacity = capacity;
+  }
+
+  ht_retired_t *retired = &table->retired[table->retired_count++];
+  retired->block = block;
+  retired->bytes = bytes;
+  retired->epoch = atomic_load(&ht_global_epoch);
+  table->retired_bytes += bytes;
+  if (table->retired_count >= table->retired_limit) {
+    ht_reclaim(table);
+  }
+  pthread_mutex_unlock(&table->retire_lock);
+}
+
+// Odstraní prvek z tabulky (prvek už musí být odpojený ze seznamu)
+static void ht_retire_item(ht_table_t *table, ht_item_t *item) {
+  size_t bytes = HT_ITEM_SIZE(item->length);
+  atomic_fetch_sub(&table->live_bytes, bytes);
+  ht_retire(table, item, bytes);
+}
+
+// Zámek chránící seznamy synonym klíčů s daným hashem
+static inline pthread_mutex_t *ht_lock_for(ht_table_t *table, uint64_t hash) {
+  return &table->locks[hash >> (64 - HT_LOCK_BITS)];
+}
+
+/*
+ * Počítadla zápisů se dělí podle zámků (zapisující vlákno drží zámek
+ * a jeho řádku cache tak jako tak), počítadla hledání podle vláken, aby
+ * čtení bez zámků nezapisovalo do sdílené řádky cache. Při HT_STATS == 0
+ * se nepřekládají.
+ */
+#if HT_STATS
+#define HT_COUNT(table, hash, counter)                                         \
+  atomic_fetch_add_explicit(                                                   \
+      &(table)->stats[(hash) >> (64 - HT_LOCK_BITS)].counter, 1,               \
+      memory_order_relaxed)
+
+/*
+ * Zvýší počítadlo vlákna. Jiné vlákno ho jen čte (ht_stats), stačí proto
+ * načtení a uložení bez atomického sčítání.
+ */
+static inline void ht_bump(_Atomic uint64_t *counter) {
+  atomic_store_explicit(
+      counter, atomic_load_explicit(counter, memory_order_relaxed) + 1,
+      memory_order_relaxed);
+}
+
+// Počítadla hledání volajícího vlákna
+static inline ht_thread_stats_t *ht_thread_stats(ht_table_t *table) {
+  return &table->reads[ht_thread_record() - ht_threads];
+}
+#else
+#define HT_COUNT(table, hash, counter) ((void)(hash))
+#endif
+
+/*
+ * Započítá hledání, které prošlo visited prvků, do histogramu.
+ */
+static inline void ht_count_probes(ht_table_t *table, size_t visited) {
+#if HT_STATS
+  ht_bump(&ht_thread_stats(table)->probes[visited < HT_STATS_PROBES
+                                              ? visited
+                                              : HT_STATS_PROBES - 1]);
+#else
+  (void)table;
+  (void)visited;
+#endif
+}
+
+/*
+ * Započítá vyhledání (ht_search, ht_get a jejich varianty) s výsledkem
+ * found.
+ */
+static inline void ht_count_search(ht_table_t *table, bool found) {
+#if HT_STATS
+  ht_thread_stats_t *reads = ht_thread_stats(table);
+  ht_bump(&reads->searches);
+  ht_bump(found ? &reads->hits : &reads->misses);
+#else
+  (void)table;
+  (void)found;
+#endif
+}
+
+static void ht_lock_all(ht_table_t *table) {
+  for (int i = 0; i < HT_LOCK_STRIPES; i++) {
+    pthread_mutex_lock(&table->locks[i]);
+  }
+}
+
+static void ht_unlock_all(ht_table_t *table) {
+  for (int i = HT_LOCK_STRIPES - 1; i >= 0; i--) {
+    pthread_mutex_unlock(&table->locks[i]);
+  }
+}
+
+/*
+ * Index seznamu synonym: horní bity hashe. Protože má pole alespoň
+ * HT_LOCK_STRIPES seznamů, leží všechny klíče jednoho seznamu pod stejným
+ * zámkem.
+ */
+static inline size_t ht_index(ht_buckets_t *buckets, uint64_t hash) {
+  return (size_t)(hash >> buckets->shift);
+}
+
+/*
+ * Alokace prázdného pole o size seznamech (size je mocnina dvojky).
+ */
+static ht_buckets_t *ht_buckets_new(size_t size, uint64_t seed) {
+  ht_buckets_t *buckets =
+      malloc(sizeof(ht_buckets_t) + size * sizeof(buckets->heads[0]));
+  if (buckets == NULL) {
+    return NULL;
+  }
+  buckets->size = size;
+  buckets->shift = 64;
+  for (size_t n = size; n > 1; n >>= 1) {
+    buckets->shift--;
+  }
+  buckets->seed = seed;
+  for (size_t i = 0; i < size; i++) {
+    atomic_init(&buckets->heads[i], NULL);
+  }
+  return buckets;
+}
+
+static inline size_t ht_buckets_bytes(ht_buckets_t *buckets) {
+  return sizeof(ht_buckets_t) + buckets->size * sizeof(buckets->heads[0]);
+}
+
+/*
+ * Nový prvek s kopií klíče, připravený ke zveřejnění.
+ */
+static ht_item_t *ht_item_new(ht_table_t *table, const char *key,
+                              size_t length, uint64_t hash, float value) {
+  ht_item_t *item = malloc(HT_ITEM_SIZE(length));
+  if (item == NULL) {
+    return NULL;
+  }
+  item->key = (char *)(item + 1);
+  memcpy(item->key, key, length);
+  item->key[length] = '\0';
+  item->value = value;
+  item->length = (uint32_t)length;
+  item->hash = hash;
+  atomic_init(&item->next, NULL);
+  atomic_fetch_add(&table->live_bytes, HT_ITEM_SIZE(length));
+  return item;
+}
+
+/*
+ * Zkopíruje všechny prvky do nového pole o new_size seznamech se
+ * semínkem seed a nové pole zveřejní. Staré prvky a pole odstraní.
+ * Volá se se všemi zámky zamčenými; při chybě alokace se nic nezmění.
+ */
+static void ht_rebuild(ht_table_t *table, size_t new_size, uint64_t seed) {
+  ht_buckets_t *old = atomic_load_explicit(&table->buckets,
+                                           memory_order_relaxed);
+  ht_buckets_t *buckets = ht_buckets_new(new_size, seed);
+  if (buckets == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < old->size; i++) {
+    ht_item_t *item = atomic_load_explicit(&old->heads[i], memory_order_relaxed);
+    for (; item != NULL;
+         item = atomic_load_explicit(&item->next, memory_order_relaxed)) {
+      uint64_t hash = seed == old->seed
+                          ? item->hash
+                          : ht_hash_bytes(item->key, item->length, seed);
+      ht_item_t *copy =
+          ht_item_new(table, item->key, item->length, hash, item->value);
+      if (copy == NULL) {
+        // Zahodíme rozpracované pole, tabulka zůstane beze změny
+        for (size_t j = 0; j < buckets->size; j++) {
+          ht_item_t *done = atomic_load_explicit(&buckets->heads[j],
+                                                 memory_order_relaxed);
+          while (done != NULL) {
+            ht_item_t *next = atomic_load_explicit(&done->next,
+                                                   memory_order_relaxed);
+            atomic_fetch_sub(&table->live_bytes, HT_ITEM_SIZE(done->length));
+            free(done);
+            done = next;
+          }
+        }
+        free(buckets);
+        return;
+      }
+      size_t index = ht_index(buckets, hash);
+      atomic_store_explicit(&copy->next,
+                            atomic_load_explicit(&buckets->heads[index],
+                                                 memory_order_relaxed),
+                            memory_order_relaxed);
+      atomic_store_explicit(&buckets->heads[index], copy, memory_order_relaxed);
+    }
+  }
+
+  atomic_store_explicit(&table->buckets, buckets, memory_order_release);
+  atomic_store(&table->size, new_size);
+
+  for (size_t i = 0; i < old->size; i++) {
+    ht_item_t *item = atomic_load_explicit(&old->heads[i], memory_order_relaxed);
+    while (item != NULL) {
+      ht_item_t *next = atomic_load_explicit(&item->next, memory_order_relaxed);
+      ht_retire_item(table, item);
+      item = next;
+    }
+  }
+  ht_retire(table, old, ht_buckets_bytes(old));
+}
+
+/*
+ * Změní velikost pole, pokud je aktuální pole stále expected a faktor
+ * naplnění je stále mimo povolené meze.
+ */
+static void ht_resize(ht_table_t *table, ht_buckets_t *expected) {
+  ht_lock_all(table);
+  ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                               memory_order_relaxed);
+  if (buckets == expected && buckets != NULL) {
+    size_t count = atomic_load(&table->count);
+    size_t new_size = buckets->size;
+    if (count > buckets->size * HT_MAX_LOAD) {
+      new_size = buckets->size * 2;
+    } else if (buckets->size > table->min_size &&
+               count * HT_MIN_LOAD_DIV < buckets->size) {
+      new_size = buckets->size / 2;
+    }
+    if (new_size != buckets->size) {
+      ht_rebuild(table, new_size, buckets->seed);
+    }
+  }
+  ht_unlock_all(table);
+}
+
+/*
+ * Rozmístí prvky do nového pole stejné velikosti s novým náhodným
+ * semínkem (ochrana před cíleně kolidujícími klíči, viz HT_FLOOD_CHAIN).
+ * Pokud pole mezitím nahradilo jiné vlákno, nedělá nic.
+ */
+static bool ht_reseed(ht_table_t *table, ht_buckets_t *expected) {
+  bool reseeded = false;
+  ht_lock_all(table);
+  if (atomic_load_explicit(&table->buckets, memory_order_relaxed) ==
+      expected) {
+    uint64_t seed = ht_random_seed();
+    ht_rebuild(table, expected->size, seed);
+    reseeded = atomic_load_explicit(&table->buckets, memory_order_relaxed) !=
+               expected;
+    if (reseeded) {
+      table->seed = seed;
+    }
+  }
+  ht_unlock_all(table);
+  return reseeded;
+}
+
+/*
+ * Inicializace tabulky — zavolá sa před prvním použitím tabulky a předtím,
+ * než ji začnou používat další vlákna.
+ *
+ * Pole tabulky (mocnina dvojky, alespoň HT_SIZE a HT_LOCK_STRIPES) se
+ * alokuje až při prvním vložení. Tabulka začíná s náhodným semínkem (při
+ * vypnutém HT_RANDOM_SEED s nulovým).
+ */
+void ht_init(ht_table_t *table) {
+  size_t min_size = HT_LOCK_STRIPES;
+  while (min_size < (size_t)HT_SIZE) {
+    min_size *= 2;
+  }
+
+  atomic_init(&table->buckets, NULL);
+  atomic_init(&table->size, 0);
+  atomic_init(&table->count, 0);
+  table->min_size = min_size;
+  table->seed = HT_RANDOM_SEED ? ht_random_seed() : 0;
+  for (int i = 0; i < HT_LOCK_STRIPES; i++) {
+    pthread_mutex_init(&table->locks[i], NULL);
+  }
+  pthread_mutex_init(&table->retire_lock, NULL);
+  table->retired = NULL;
+  table->retired_count = 0;
+  table->retired_capacity = 0;
+  table->retired_bytes = 0;
+  table->retired_limit = HT_RECLAIM_THRESHOLD;
+  atomic_init(&table->live_bytes, 0);
+#if HT_STATS
+  memset(table->stats, 0, sizeof(table->stats));
+  memset(table->reads, 0, sizeof(table->reads));
+#endif
+}
+
+/*
+ * Statistiky paměti tabulky: živé prvky a bloky čekající na uvolnění
+ * (odstraněné, ale možná ještě viditelné pro čtenáře).
+ */
+void ht_alloc_stats(ht_table_t *table, ht_arena_stats_t *stats) {
+  pthread_mutex_lock(&table->retire_lock);
+  stats->live = atomic_load(&table->live_bytes);
+  stats->free = table->retired_bytes;
+  pthread_mutex_unlock(&table->retire_lock);
+  stats->reserved = stats->live + stats->free;
+  stats->fragmentation =
+      stats->reserved == 0 ? 0 : (double)stats->free / stats->reserved;
+}
+
+/*
+ * Nastavení semínka rozptylovací funkce tabulky.
+ *
+ * Pokud tabulka již obsahuje prvky, zkopíruje je do nového pole
+ * rozmístěného podle nového semínka.
+ */
+void ht_set_seed(ht_table_t *table, uint64_t seed) {
+  ht_lock_all(table);
+  table->seed = seed;
+  ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                               memory_order_relaxed);
+  if (buckets != NULL) {
+    ht_rebuild(table, buckets->size, seed);
+  }
+  ht_unlock_all(table);
+}
+
+/*
+ * Filtr příslušnosti (viz filter.h) souběžná varianta nepodporuje:
+ * čítače by musely být atomické a čtení bez zámků by při výměně filtru
+ * spolu s polem (růst, změna semínka) mohlo vidět filtr jiného pole.
+ * Pro fp_rate v intervalu (0,1) proto vrací false, jinak (vypnutí
+ * filtru) true.
+ */
+bool ht_set_filter(ht_table_t *table, double fp_rate, size_t max_bytes) {
+  (void)table;
+  (void)max_bytes;
+  return !(fp_rate > 0 && fp_rate < 1);
+}
+
+/*
+ * Omezení kapacity s vyhazováním (viz zřetězená varianta) souběžná
+ * varianta nepodporuje: prvky se po zveřejnění nemění, referenční bit by
+ * tedy musel být atomický a zapisovaný každým čtenářem. Pro nenulovou
+ * kapacitu proto vrací false, jinak true.
+ */
+bool ht_set_capacity(ht_table_t *table, size_t capacity) {
+  (void)table;
+  return capacity == 0;
+}
+
+/*
+ * Hash klíče pro pole se semínkem seed. Hash předem připraveného klíče
+ * (prehashed, může být NULL) se použije, jen pokud byl spočítán se
+ * stejným semínkem.
+ */
+static inline uint64_t ht_handle_hash(const char *key, size_t length,
+                                      const ht_key_t *prehashed,
+                                      uint64_t seed) {
+  return prehashed != NULL && prehashed->seed == seed
+             ? prehashed->hash
+             : ht_hash_bytes(key, length, seed);
+}
+
+/*
+ * Vyhledání prvku s klíčem o délce length bez zamykání (viz ht_search).
+ */
+static ht_item_t *ht_find(ht_table_t *table, const char *key, size_t length,
+                          const ht_key_t *prehashed) {
+  ht_item_t *item = NULL;
+  uint64_t hash = 0;
+  size_t visited = 0;
+
+  ht_read_lock();
+  ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                               memory_order_acquire);
+  if (buckets != NULL) {
+    hash = ht_handle_hash(key, length, prehashed, buckets->seed);
+    item = atomic_load_explicit(&buckets->heads[ht_index(buckets, hash)],
+                                memory_order_acquire);
+    while (item != NULL &&
+           !(item->hash == hash && item->length == length &&
+             memcmp(item->key, key, length) == 0)) {
+      visited++;
+      item = atomic_load_explicit(&item->next, memory_order_acquire);
+    }
+  }
+  ht_read_unlock();
+  ht_count_probes(table, visited + (item != NULL));
+  ht_count_search(table, item != NULL);
+  return item;
+}
+
+/*
+ * Vyhledání prvku v tabulce bez zamykání.
+ *
+ * V případě úspěchu vrací ukazatel na nalezený prvek; v opačném případě vrací
+ * hodnotu NULL. Ukazatel zůstává platný, dokud volající drží ht_read_lock.
+ */
+ht_item_t *ht_search(ht_table_t *table, char *key) {
+  return ht_find(table, key, strlen(key), NULL);
+}
+
+/*
+ * Vyhledání prvku podle klíče o délce length, který nemusí končit nulovým
+ * znakem (např. úsek vstupního bufferu). Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length) {
+  return ht_find(table, key, length, NULL);
+}
+
+/*
+ * Vyhledání prvku podle klíče s předem spočítaným hashem (viz ht_key_t).
+ * Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_key(ht_table_t *table, const ht_key_t *key) {
+  return ht_find(table, key->data, key->length, key);
+}
+
+/*
+ * Zamkne zámek seznamu, do kterého patří klíč (prehashed viz
+ * ht_handle_hash), a vrátí aktuální pole a hash klíče. Pokud pole ještě neexistuje, vytvoří ho. Vrací NULL při
+ * chybě alokace. Volající musí být uvnitř ht_read_lock, protože pole může
+ * jiné vlákno mezitím nahradit a odstranit.
+ */
+static ht_buckets_t *ht_lock_key(ht_table_t *table, const char *key,
+                                 size_t length, const ht_key_t *prehashed,
+                                 uint64_t *hash, bool create) {
+  for (;;) {
+    ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                                 memory_order_acquire);
+    if (buckets == NULL) {
+      if (!create) {
+        return NULL;
+      }
+      ht_lock_all(table);
+      if (atomic_load_explicit(&table->buckets, memory_order_relaxed) == NULL) {
+        ht_buckets_t *created = ht_buckets_new(table->min_size, table->seed);
+        if (created == NULL) {
+          ht_unlock_all(table);
+          return NULL;
+        }
+        atomic_store_explicit(&table->buckets, created, memory_order_release);
+        atomic_store(&table->size, created->size);
+      }
+      ht_unlock_all(table);
+      continue;
+    }
+
+    *hash = ht_handle_hash(key, length, prehashed, buckets->seed);
+    pthread_mutex_lock(ht_lock_for(table, *hash));
+    // Pole se mohlo mezitím vyměnit (jiná velikost nebo semínko)
+    if (atomic_load_explicit(&table->buckets, memory_order_acquire) == buckets) {
+      return buckets;
+    }
+    pthread_mutex_unlock(ht_lock_for(table, *hash));
+  }
+}
+
+/*
+ * Vložení prvku s klíčem o délce length nebo změna hodnoty existujícího
+ * prvku podle mode (viz ht_update_mode_t) pod zámkem jeho seznamu synonym.
+ * Volá se uvnitř ht_read_lock, vrací platný prvek s výslednou hodnotou,
+ * při chybě NULL.
+ */
+static ht_item_t *ht_update(ht_table_t *table, const char *key,
+                            size_t length, const ht_key_t *prehashed,
+                            float value, ht_update_mode_t mode) {
+  if (length > UINT32_MAX) {
+    return NULL;  // Délka klíče se do prvku nevejde
+  }
+
+  uint64_t hash;
+  ht_buckets_t *buckets =
+      ht_lock_key(table, key, length, prehashed, &hash, true);
+  if (buckets == NULL) {
+    return NULL;  // Ošetření chyby při alokaci paměti
+  }
+
+  _Atomic(ht_item_t *) *link = &buckets->heads[ht_index(buckets, hash)];
+  ht_item_t *item = atomic_load_explicit(link, memory_order_relaxed);
+  size_t visited = 0;
+  while (item != NULL &&
+         !(item->hash == hash && item->length == length &&
+           memcmp(item->key, key, length) == 0)) {
+    visited++;
+    link = &item->next;
+    item = atomic_load_explicit(link, memory_order_relaxed);
+  }
+  ht_count_probes(table, visited + (item != NULL));
+  if (item != NULL) {
+    HT_COUNT(table, hash, updates);
+  }
+
+  if (item != NULL && mode == HT_UPDATE_KEEP) {
+    pthread_mutex_unlock(ht_lock_for(table, hash));
+    return item;
+  }
+  if (item != NULL && mode == HT_UPDATE_ADD) {
+    value += item->value;
+  }
+
+  ht_item_t *new_item = ht_item_new(table, key, length, hash, value);
+  if (new_item == NULL) {
+    pthread_mutex_unlock(ht_lock_for(table, hash));
+    return NULL;
+  }
+
+  bool added = item == NULL;
+  if (added) {
+    // Nový prvek zveřejníme na začátku seznamu
+    link = &buckets->heads[ht_index(buckets, hash)];
+    atomic_store_explicit(&new_item->next,
+                          atomic_load_explicit(link, memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(link, new_item, memory_order_release);
+    atomic_fetch_add(&table->count, 1);
+    HT_COUNT(table, hash, inserts);
+  } else {
+    // Existující prvek nahradíme kopií s novou hodnotou
+    atomic_store_explicit(&new_item->next,
+                          atomic_load_explicit(&item->next,
+                                               memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(link, new_item, memory_order_release);
+    ht_retire_item(table, item);
+  }
+  pthread_mutex_unlock(ht_lock_for(table, hash));
+
+  if (added && atomic_load(&table->count) > buckets->size * HT_MAX_LOAD) {
+    ht_resize(table, buckets);
+  }
+
+  // Příliš dlouhý seznam synonym značí cíleně kolidující klíče
+  size_t load = atomic_load(&table->count) / buckets->size;
+  if (added && visited + 1 > HT_FLOOD_CHAIN * (load > 1 ? load : 1) &&
+      ht_reseed(table, buckets)) {
+    HT_COUNT(table, hash, reseeds);
+  }
+  return new_item;
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahradí ho kopií
+ * s novou hodnotou. Nový prvek vloží na začátek seznamu synonym.
+ */
+void ht_insert(ht_table_t *table, char *key, float value) {
+  ht_insert_n(table, key, strlen(key), value);
+}
+
+/*
+ * Vložení prvku s klíčem o délce length, který nemusí končit nulovým
+ * znakem. Klíč se zkopíruje jen do nového prvku.
+ */
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value) {
+  ht_read_lock();
+  ht_update(table, key, length, NULL, value, HT_UPDATE_SET);
+  ht_read_unlock();
+}
+
+/*
+ * Vložení prvku s klíčem s předem spočítaným hashem (viz ht_key_t).
+ */
+void ht_insert_key(ht_table_t *table, const ht_key_t *key, float value) {
+  ht_read_lock();
+  ht_update(table, key->data, key->length, key, value, HT_UPDATE_SET);
+  ht_read_unlock();
+}
+
+/*
+ * Vložení nebo přepsání hodnoty jako ht_insert.
+ *
+ * Vrací ukazatel na hodnotu prvku, při chybě NULL. Ukazatel platí za
+ * stejných podmínek jako u ht_get; hodnotu nelze měnit přes ukazatel,
+ * protože prvek může současně číst jiné vlákno.
+ */
+float *ht_upsert(ht_table_t *table, char *key, float value) {
+  ht_read_lock();
+  ht_item_t *item =
+      ht_update(table, key, strlen(key), NULL, value, HT_UPDATE_SET);
+  ht_read_unlock();
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty, a pokud klíč v tabulce není, vložení prvku s hodnotou
+ * value. Hledání i vložení proběhne pod jedním zámkem, takže ze souběžných
+ * volání se stejným klíčem vloží prvek jen jedno.
+ *
+ * Vrací ukazatel na hodnotu prvku (platný jako u ht_upsert), při chybě
+ * NULL.
+ */
+float *ht_get_or_insert(ht_table_t *table, char *key, float value) {
+  ht_read_lock();
+  ht_item_t *item =
+      ht_update(table, key, strlen(key), NULL, value, HT_UPDATE_KEEP);
+  ht_read_unlock();
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Atomické přičtení delta k hodnotě klíče; chybějící klíč se vloží
+ * s hodnotou delta. Prvek se nahradí kopií s výslednou hodnotou, takže
+ * souběžná přičtení se neztratí.
+ *
+ * Vrací ukazatel na výslednou hodnotu (platný jako u ht_upsert), při chybě
+ * NULL.
+ */
+float *ht_add(ht_table_t *table, char *key, float delta) {
+  ht_read_lock();
+  ht_item_t *item =
+      ht_update(table, key, strlen(key), NULL, delta, HT_UPDATE_ADD);
+  ht_read_unlock();
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty z tabulky bez zamykání.
+ *
+ * V případě úspěchu vrací funkce ukazatel na hodnotu prvku, v opačném
+ * případě hodnotu NULL.
+ */
+float *ht_get(ht_table_t *table, char *key) {
+  ht_item_t *item = ht_search(table, key);
+  if (item != NULL) {
+    return &(item->value);
+  }
+  return NULL;
+}
+
+/*
+ * Získání hodnoty podle klíče o délce length, který nemusí končit nulovým
+ * znakem. Jinak stejné jako ht_get.
+ */
+float *ht_get_n(ht_table_t *table, const char *key, size_t length) {
+  ht_item_t *item = ht_find(table, key, length, NULL);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty podle klíče s předem spočítaným hashem (viz ht_key_t).
+ */
+float *ht_get_key(ht_table_t *table, const ht_key_t *key) {
+  ht_item_t *item = ht_find(table, key->data, key->length, key);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Dávkové získání hodnot bez zamykání: values[i] dostane výsledek
+ * ht_get(table, keys[i]).
+ *
+ * Klíče se zpracovávají po HT_BATCH_SIZE: pro celou dávku se spočítají
+ * hashe a přednačtou začátky seznamů, potom se seznamy všech klíčů
+ * procházejí střídavě po jednom prvku s přednačtením dalšího. Ukazatele
+ * platí za stejných podmínek jako u ht_get.
+ */
+void ht_get_many(ht_table_t *table, char *keys[], size_t count,
+                 float *values[]) {
+  ht_read_lock();
+  ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                               memory_order_acquire);
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    char **batch_keys = keys + start;
+    float **batch_values = values + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+    ht_item_t *cursors[HT_BATCH_SIZE];
+    size_t visited[HT_BATCH_SIZE];
+
+    for (size_t i = 0; i < batch; i++) {
+      batch_values[i] = NULL;
+      visited[i] = 0;
+    }
+    if (buckets == NULL) {
+      for (size_t i = 0; i < batch; i++) {
+        ht_count_probes(table, 0);
+        ht_count_search(table, false);
+      }
+      continue;
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_keys[i]);
+      hashes[i] = ht_hash_bytes(batch_keys[i], lengths[i], buckets->seed);
+      HT_PREFETCH(&buckets->heads[ht_index(buckets, hashes[i])]);
+    }
+    for (size_t i = 0; i < batch; i++) {
+      cursors[i] = atomic_load_explicit(
+          &buckets->heads[ht_index(buckets, hashes[i])], memory_order_acquire);
+      HT_PREFETCH(cursors[i]);
+    }
+
+    size_t active = batch;
+    while (active > 0) {
+      active = 0;
+      for (size_t i = 0; i < batch; i++) {
+        ht_item_t *item = cursors[i];
+        if (item == NULL) {
+          continue;
+        }
+        visited[i]++;
+        if (item->hash == hashes[i] && item->length == lengths[i] &&
+            memcmp(item->key, batch_keys[i], lengths[i]) == 0) {
+          batch_values[i] = &item->value;
+          cursors[i] = NULL;
+          continue;
+        }
+        cursors[i] = atomic_load_explicit(&item->next, memory_order_acquire);
+        if (cursors[i] != NULL) {
+          HT_PREFETCH(cursors[i]);
+          active++;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_count_probes(table, visited[i]);
+      ht_count_search(table, batch_values[i] != NULL);
+    }
+  }
+  ht_read_unlock();
+}
+
+/*
+ * Dávkové vložení count prvků (klíč a hodnota z items[i]).
+ *
+ * Každé vložení bere zámek svého klíče samostatně, aby dávka neblokovala
+ * ostatní zapisující vlákna; prvky se proto vkládají jednotlivě.
+ */
+void ht_insert_many(ht_table_t *table, const ht_item_t items[], size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    ht_insert(table, items[i].key, items[i].value);
+  }
+}
+
+// Rozpracované paralelní vkládání
+typedef struct {
+  ht_table_t *table;
+  char **keys;
+  const float *values;
+  uint64_t seed;                   // semínko hashů v partition
+  ht_partition_t partition;
+  bool failed[HT_MAX_WORKERS];     // chyba alokace v úseku
+} ht_build_t;
+
+/*
+ * Úsek, do kterého patří klíč: souvislá skupina zámků (a tedy seznamů
+ * synonym) vybraná horními bity hashe.
+ */
+static size_t ht_build_shard(uint64_t hash, const void *context) {
+  const ht_build_t *build = context;
+  return (size_t)(hash >> (64 - HT_LOCK_BITS)) * build->partition.shards /
+         HT_LOCK_STRIPES;
+}
+
+/*
+ * Vložení klíčů jednoho úseku. Zámky úseku nebere žádné jiné vlákno
+ * vkládání, takže se o ně vlákna nepřetahují.
+ */
+static void ht_build_shard_items(void *context, int index) {
+  ht_build_t *build = context;
+  ht_partition_t *partition = &build->partition;
+  for (size_t i = partition->starts[index];
+       i < partition->starts[index + 1] && !build->failed[index]; i++) {
+    size_t key_index = partition->order[i];
+    ht_key_t key = {build->keys[key_index], strlen(build->keys[key_index]),
+                    build->seed, partition->hashes[key_index]};
+    ht_read_lock();
+    build->failed[index] =
+        ht_update(build->table, key.data, key.length, &key,
+                  build->values[key_index], HT_UPDATE_SET) == NULL;
+    ht_read_unlock();
+  }
+}
+
+/*
+ * Paralelní vložení count prvků (klíč keys[i] s hodnotou values[i])
+ * pomocí threads vláken; výsledek je stejný jako po postupném ht_insert.
+ *
+ * Pole se nejprve zvětší pro všechny nové klíče, potom se vstup rozdělí
+ * podle zámků: každé vlákno vkládá klíče jedné souvislé skupiny zámků,
+ * takže se vlákna o zámky nepřetahují a opakované klíče se vloží ve
+ * stejném pořadí jako na vstupu. Ostatní vlákna mohou tabulku během
+ * volání číst i měnit. Při chybě alokace vrací false; klíče vložené do
+ * té doby v tabulce zůstanou.
+ */
+bool ht_build_parallel(ht_table_t *table, char *keys[], const float values[],
+                       size_t count, int threads) {
+  if (threads < 1) {
+    threads = 1;
+  } else if (threads > HT_LOCK_STRIPES) {
+    threads = HT_LOCK_STRIPES;
+  }
+
+  // Pole zvětšíme předem, aby ho během vkládání nebylo třeba kopírovat
+  size_t size = table->min_size;
+  while (atomic_load(&table->count) + count > size * HT_MAX_LOAD) {
+    size *= 2;
+  }
+  ht_lock_all(table);
+  ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                               memory_order_relaxed);
+  if (buckets == NULL) {
+    buckets = ht_buckets_new(size, table->seed);
+    if (buckets != NULL) {
+      atomic_store_explicit(&table->buckets, buckets, memory_order_release);
+      atomic_store(&table->size, size);
+    }
+  } else if (buckets->size < size) {
+    ht_rebuild(table, size, buckets->seed);
+  }
+  uint64_t seed = table->seed;
+  ht_unlock_all(table);
+
+  ht_build_t *build = calloc(1, sizeof(ht_build_t));
+  if (build == NULL) {
+    return false;
+  }
+  build->table = table;
+  build->keys = keys;
+  build->values = values;
+  build->seed = seed;
+  if (!ht_partition(&build->partition, keys, count, seed, (size_t)threads,
+                    ht_build_shard, build, threads)) {
+    free(build);
+    return false;
+  }
+  ht_parallel_run(threads, ht_build_shard_items, build);
+
+  bool failed = false;
+  for (int i = 0; i < threads; i++) {
+    failed = failed || build->failed[i];
+  }
+  ht_partition_free(&build->partition);
+  free(build);
+  return !failed;
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Prvek se odpojí ze seznamu synonym a uvolní se, až ho nebude moci vidět
+ * žádný čtenář. Pokud prvek neexistuje, funkce nedělá nic.
+ */
+void ht_delete(ht_table_t *table, char *key) {
+  size_t length = strlen(key);
+  ht_read_lock();
+  uint64_t hash;
+  ht_buckets_t *buckets = ht_lock_key(table, key, length, NULL, &hash, false);
+  if (buckets == NULL) {
+    ht_read_unlock();
+    return;
+  }
+
+  _Atomic(ht_item_t *) *link = &buckets->heads[ht_index(buckets, hash)];
+  ht_item_t *item = atomic_load_explicit(link, memory_order_relaxed);
+  size_t visited = 0;
+  while (item != NULL &&
+         !(item->hash == hash && item->length == length &&
+           memcmp(item->key, key, length) == 0)) {
+    visited++;
+    link = &item->next;
+    item = atomic_load_explicit(link, memory_order_relaxed);
+  }
+  ht_count_probes(table, visited + (item != NULL));
+
+  if (item != NULL) {
+    HT_COUNT(table, hash, deletes);
+    atomic_store_explicit(link,
+                          atomic_load_explicit(&item->next,
+                                               memory_order_relaxed),
+                          memory_order_release);
+    atomic_fetch_sub(&table->count, 1);
+    ht_retire_item(table, item);
+  }
+  pthread_mutex_unlock(ht_lock_for(table, hash));
+
+  if (item != NULL && buckets->size > table->min_size &&
+      atomic_load(&table->count) * HT_MIN_LOAD_DIV < buckets->size) {
+    ht_resize(table, buckets);
+  }
+  ht_read_unlock();
+}
+
+/*
+ * Smazání všech prvků z tabulky.
+ *
+ * Funkce odpojí celé pole, odstraní všechny prvky a uvede tabulku do stavu
+ * po inicializaci. Prvky, které ještě mohou vidět čtenáři, se uvolní až
+ * po skončení jejich čtení.
+ */
+void ht_delete_all(ht_table_t *table) {
+  ht_lock_all(table);
+  ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                               memory_order_relaxed);
+  atomic_store_explicit(&table->buckets, NULL, memory_order_release);
+  atomic_store(&table->size, 0);
+  atomic_store(&table->count, 0);
+  if (buckets != NULL) {
+    for (size_t i = 0; i < buckets->size; i++) {
+      ht_item_t *item = atomic_load_explicit(&buckets->heads[i],
+                                             memory_order_relaxed);
+      while (item != NULL) {
+        ht_item_t *next = atomic_load_explicit(&item->next,
+                                               memory_order_relaxed);
+        ht_retire_item(table, item);
+        item = next;
+      }
+    }
+    ht_retire(table, buckets, ht_buckets_bytes(buckets));
+  }
+  ht_unlock_all(table);
+
+  pthread_mutex_lock(&table->retire_lock);
+  ht_reclaim(table);
+  if (table->retired_count == 0) {
+    free(table->retired);
+    table->retired = NULL;
+    table->retired_capacity = 0;
+  }
+  pthread_mutex_unlock(&table->retire_lock);
+}
+
+/*
+ * Statistiky tabulky: součty počítadel všech zámků a vláken (viz
+ * ht_stats_t) a stav aktuálního pole. Tabulku lze během volání měnit,
+ * výsledek pak odpovídá některému stavu během volání jen přibližně.
+ * Nejdelší seznam synonym se hledá průchodem celého pole.
+ */
+void ht_stats(ht_table_t *table, ht_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+#if HT_STATS
+  for (int i = 0; i < HT_LOCK_STRIPES; i++) {
+    ht_stripe_stats_t *stripe = &table->stats[i];
+    stats->inserts += atomic_load_explicit(&stripe->inserts,
+                                           memory_order_relaxed);
+    stats->updates += atomic_load_explicit(&stripe->updates,
+                                           memory_order_relaxed);
+    stats->deletes += atomic_load_explicit(&stripe->deletes,
+                                           memory_order_relaxed);
+    stats->reseeds += atomic_load_explicit(&stripe->reseeds,
+                                           memory_order_relaxed);
+  }
+  for (int i = 0; i < HT_MAX_THREADS; i++) {
+    ht_thread_stats_t *reads = &table->reads[i];
+    stats->searches += atomic_load_explicit(&reads->searches,
+                                            memory_order_relaxed);
+    stats->hits += atomic_load_explicit(&reads->hits, memory_order_relaxed);
+    stats->misses += atomic_load_explicit(&reads->misses,
+                                          memory_order_relaxed);
+    for (int j = 0; j < HT_STATS_PROBES; j++) {
+      stats->probes[j] += atomic_load_explicit(&reads->probes[j],
+                                               memory_order_relaxed);
+    }
+  }
+#endif
+
+  ht_read_lock();
+  ht_buckets_t *buckets = atomic_load_explicit(&table->buckets,
+                                               memory_order_acquire);
+  stats->count = atomic_load(&table->count);
+  if (buckets != NULL) {
+    stats->size = buckets->size;
+    stats->bytes = ht_buckets_bytes(buckets);
+    for (size_t i = 0; i < buckets->size; i++) {
+      size_t length = 0;
+      ht_item_t *item = atomic_load_explicit(&buckets->heads[i],
+                                             memory_order_acquire);
+      for (; item != NULL; length++) {
+        item = atomic_load_explicit(&item->next, memory_order_acquire);
+      }
+      stats->longest_chain =
+          length > stats->longest_chain ? length : stats->longest_chain;
+    }
+  }
+  ht_read_unlock();
+
+  stats->load_factor =
+      stats->size > 0 ? (double)stats->count / stats->size : 0;
+  stats->hit_ratio =
+      stats->searches > 0 ? (double)stats->hits / stats->searches : 0;
+  ht_arena_stats_t memory;
+  ht_alloc_stats(table, &memory);
+  stats->bytes += memory.reserved;
+}
@@ -0,0 +1,724 @@
+/*
+ * Tabulka s rozptýlenými položkami — kukaččí hashování
+ *
+ * Varianta se stejným rozhraním jako hashtable.c, ve které má každý klíč
+ * jen dva možné koše po HT_BUCKET_SLOTS místech. Kôš zabírá právě jeden
+ * řádek cache, vyhledání proto přečte nejvýše dva řádky pole (a klíč
+ * kandidáta se shodným otiskem) bez ohledu na naplnění tabulky a délka
+ * nejhoršího vyhledání je shora omezená, ne jen v průměru krátká.
+ *
+ * Otisk (dolních 31 bitů hashe) leží v prvku vedle ukazatele na klíč:
+ * klíče se porovnávají jen při shodě otisku a druhý kôš prvku jde
+ * z otisku spočítat bez hashování klíče (b2 = b1 ^ f(otisk)), což
+ * potřebuje vytlačování. Jsou-li při vkládání oba koše plné, nový prvek
+ * zabere náhodné místo jednoho z nich a vytlačený prvek se přesune do
+ * svého druhého koše, nejvýše HT_CUCKOO_MAX_KICKS krát. Nenajde-li se
+ * místo (vytlačování se zacyklilo), pole se přestaví: při nízkém
+ * naplnění s novým semínkem, jinak na dvojnásobnou velikost.
+ *
+ * Délka klíče leží v aréně ve čtyřech bajtech před klíčem, aby se prvek
+ * vešel do 16 bajtů a kôš do jednoho řádku cache. Jako u otevřeného
+ * adresování se pole přestavuje najednou a ukazatele vrácené funkcemi
+ * ht_search a ht_get platí jen do další změny tabulky.
+ */
+
+#include "hashtable.h"
+#include "ht_common.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Délka klíče uložená v aréně před klíčem
+static inline uint32_t ht_key_length(const char *key) {
+  uint32_t length;
+  memcpy(&length, key - sizeof(uint32_t), sizeof(length));
+  return length;
+}
+
+// Dolních 31 bitů hashe je otisk prvku, horních 32 bitů vybírá první kôš
+static inline uint32_t ht_hash_tag(uint64_t hash) {
+  return (uint32_t)hash & 0x7fffffffu;
+}
+
+static inline size_t ht_hash_bucket(uint64_t hash, size_t mask) {
+  return (size_t)(hash >> 32) & mask;
+}
+
+/*
+ * Druhý kôš prvku s otiskem tag, který leží v koši bucket. Funkce je
+ * involuce (z druhého koše vrátí první) a lichá posunutí zaručují, že se
+ * oba koše liší, kdykoli má pole aspoň dva koše.
+ */
+static inline size_t ht_alt_bucket(size_t bucket, uint32_t tag, size_t mask) {
+  return (bucket ^ ((size_t)(tag * 0x5bd1e995u) | 1)) & mask;
+}
+
+/*
+ * Najde v koši prvek s daným klíčem a otiskem, klíče porovná jen při
+ * shodě otisku a délky.
+ */
+static inline ht_item_t *ht_match(ht_bucket_t *bucket, const char *key,
+                                  size_t length, uint32_t tag) {
+  for (int i = 0; i < HT_BUCKET_SLOTS; i++) {
+    ht_item_t *item = &bucket->slots[i];
+    if (item->key != NULL && item->tag == tag &&
+        ht_key_length(item->key) == length &&
+        memcmp(item->key, key, length) == 0) {
+      return item;
+    }
+  }
+  return NULL;
+}
+
+// Volné místo koše, nebo NULL, pokud je kôš plný
+static inline ht_item_t *ht_free_slot(ht_bucket_t *bucket) {
+  for (int i = 0; i < HT_BUCKET_SLOTS; i++) {
+    if (bucket->slots[i].key == NULL) {
+      return &bucket->slots[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Najde prvek s daným klíčem. Druhý kôš se přednačte hned, takže se
+ * výpadky cache obou košů překrývají; prohledá se ale, jen když klíč
+ * v prvním koši není.
+ */
+static ht_item_t *ht_find(ht_table_t *table, const char *key, size_t length,
+                          uint64_t hash) {
+  size_t mask = table->size - 1;
+  uint32_t tag = ht_hash_tag(hash);
+  size_t bucket = ht_hash_bucket(hash, mask);
+  ht_bucket_t *second = &table->buckets[ht_alt_bucket(bucket, tag, mask)];
+  HT_PREFETCH(second);
+
+  ht_item_t *found = ht_match(&table->buckets[bucket], key, length, tag);
+  size_t visited = 1;
+  if (found == NULL) {
+    found = ht_match(second, key, length, tag);
+    visited = 2;
+  }
+  ht_count_probes(table, visited);
+  return found;
+}
+
+/*
+ * Uloží prvek item (hash jeho klíče je hash) do pole buckets o size
+ * koších. Jsou-li oba koše prvku plné, prvek zabere pseudonáhodně vybrané
+ * místo koše a vytlačený prvek pokračuje do svého druhého koše. Pokud ani
+ * po HT_CUCKOO_MAX_KICKS vytlačeních nezbude volné místo, všechna
+ * vytlačení se vrátí a funkce vrací false; pole i item jsou pak beze
+ * změny.
+ */
+static bool ht_place(ht_bucket_t *buckets, size_t size, ht_item_t *item,
+                     uint64_t hash) {
+  size_t mask = size - 1;
+  size_t bucket = ht_hash_bucket(hash, mask);
+  ht_item_t *slot = ht_free_slot(&buckets[bucket]);
+  if (slot == NULL) {
+    bucket = ht_alt_bucket(bucket, item->tag, mask);
+    slot = ht_free_slot(&buckets[bucket]);
+  }
+
+  // Posloupnost je deterministická, aby přestavba dopadla vždy stejně
+  uint32_t random = item->tag | 1;
+  ht_item_t *path[HT_CUCKOO_MAX_KICKS];
+  int kicks = 0;
+  while (slot == NULL && kicks < HT_CUCKOO_MAX_KICKS) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    ht_item_t *victim = &buckets[bucket].slots[random % HT_BUCKET_SLOTS];
+    ht_item_t displaced = *victim;
+    *victim = *item;
+    *item = displaced;
+    path[kicks++] = victim;
+    bucket = ht_alt_bucket(bucket, item->tag, mask);
+    slot = ht_free_slot(&buckets[bucket]);
+  }
+
+  if (slot == NULL) {
+    // Výměny jsou samy sobě inverzní, stačí je zopakovat pozpátku
+    while (kicks > 0) {
+      ht_item_t *victim = path[--kicks];
+      ht_item_t displaced = *victim;
+      *victim = *item;
+      *item = displaced;
+    }
+    return false;
+  }
+  *slot = *item;
+  return true;
+}
+
+/*
+ * Nejmenší počet košů (mocnina dvojky, alespoň dva), do kterého se vejde
+ * count prvků bez překročení maximálního faktoru naplnění.
+ */
+static size_t ht_buckets_for(size_t count) {
+  size_t size = 2;
+  while (count * HT_MAX_LOAD_DEN > size * HT_BUCKET_SLOTS * HT_MAX_LOAD_NUM) {
+    size *= 2;
+  }
+  return size;
+}
+
+/*
+ * Přestaví tabulku do nového pole o new_size koších, hashe všech klíčů
+ * (a s nimi otisky prvků) se přitom počítají znovu se semínkem tabulky.
+ * Prvek extra (může být NULL) se vloží spolu s ostatními. Když se některý
+ * prvek do nového pole nevejde, zkusí se pole dvojnásobné velikosti.
+ * Při chybě alokace vrací false a tabulka zůstane beze změny.
+ */
+static bool ht_rebuild(ht_table_t *table, size_t new_size,
+                       const ht_item_t *extra) {
+  for (;;) {
+    ht_bucket_t *buckets =
+        aligned_alloc(HT_CACHE_LINE, new_size * sizeof(ht_bucket_t));
+    if (buckets == NULL) {
+      return false;
+    }
+    memset(buckets, 0, new_size * sizeof(ht_bucket_t));
+
+    bool placed = true;
+    for (size_t i = 0; placed && i < table->size * HT_BUCKET_SLOTS; i++) {
+      ht_item_t item = table->buckets[i / HT_BUCKET_SLOTS]
+                           .slots[i % HT_BUCKET_SLOTS];
+      if (item.key != NULL) {
+        uint64_t hash =
+            ht_hash_bytes(item.key, ht_key_length(item.key), table->seed);
+        item.tag = ht_hash_tag(hash);
+        placed = ht_place(buckets, new_size, &item, hash);
+      }
+    }
+    if (placed && extra != NULL) {
+      ht_item_t item = *extra;
+      uint64_t hash =
+          ht_hash_bytes(item.key, ht_key_length(item.key), table->seed);
+      item.tag = ht_hash_tag(hash);
+      placed = ht_place(buckets, new_size, &item, hash);
+    }
+
+    if (placed) {
+      free(table->buckets);
+      table->buckets = buckets;
+      table->size = new_size;
+      return true;
+    }
+    free(buckets);
+    new_size *= 2;
+  }
+}
+
+/*
+ * Inicializace tabulky — zavolá sa před prvním použitím tabulky.
+ *
+ * Pole tabulky pro HT_SIZE prvků se alokuje až při prvním vložení.
+ * Tabulka začíná s náhodným semínkem (při vypnutém HT_RANDOM_SEED
+ * s nulovým), jiné lze nastavit funkcí ht_set_seed.
+ */
+void ht_init(ht_table_t *table) {
+  table->buckets = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->min_size = ht_buckets_for(HT_SIZE > 0 ? (size_t)HT_SIZE : 1);
+  table->capacity = 0;
+  table->clock_hand = 0;
+  table->seed = HT_RANDOM_SEED ? ht_random_seed() : 0;
+  ht_arena_init(&table->arena);
+#if HT_STATS
+  memset(&table->stats, 0, sizeof(table->stats));
+#endif
+}
+
+/*
+ * Statistiky alokátoru klíčů tabulky: rezervovaná paměť, paměť živých
+ * klíčů, paměť připravená k recyklaci a podíl nevyužité paměti.
+ */
+void ht_alloc_stats(ht_table_t *table, ht_arena_stats_t *stats) {
+  ht_arena_stats(&table->arena, stats);
+}
+
+/*
+ * Nastavení semínka rozptylovací funkce tabulky.
+ *
+ * Pokud tabulka již obsahuje prvky, přestaví ji podle nového semínka.
+ */
+void ht_set_seed(ht_table_t *table, uint64_t seed) {
+  uint64_t old_seed = table->seed;
+  table->seed = seed;
+  if (table->buckets != NULL && !ht_rebuild(table, table->size, NULL)) {
+    table->seed = old_seed;  // Prvky zůstaly rozmístěné podle starého
+  }
+}
+
+/*
+ * Filtr příslušnosti (viz filter.h) kukaččí varianta nepodporuje:
+ * neúspěšné vyhledání tu přečte vždy právě dva koše a filtr by k nim
+ * přidal třetí řádek cache. Pro fp_rate v intervalu (0,1) proto vrací
+ * false, jinak (vypnutí filtru) true.
+ */
+bool ht_set_filter(ht_table_t *table, double fp_rate, size_t max_bytes) {
+  (void)table;
+  (void)max_bytes;
+  return !(fp_rate > 0 && fp_rate < 1);
+}
+
+/*
+ * Odstranění prvku z místa tabulky, klíč se vrátí do arény.
+ */
+static void ht_remove_slot(ht_table_t *table, ht_item_t *item) {
+  ht_arena_free(&table->arena, item->key - sizeof(uint32_t),
+                sizeof(uint32_t) + ht_key_length(item->key) + 1);
+  item->key = NULL;
+  table->count--;
+}
+
+/*
+ * Vyhodí jeden prvek algoritmem CLOCK (viz ht_set_capacity). Ručička
+ * prochází místa košů po řadě, obsazeným místům s referenčním bitem ho
+ * vynuluje a první prvek bez něj vyhodí. Vrací false, pokud je tabulka
+ * prázdná.
+ */
+static bool ht_evict(ht_table_t *table) {
+  if (table->count == 0) {
+    return false;
+  }
+  for (;;) {
+    if (table->clock_hand >= table->size * HT_BUCKET_SLOTS) {
+      table->clock_hand = 0;
+    }
+    ht_item_t *item = &table->buckets[table->clock_hand / HT_BUCKET_SLOTS]
+                           .slots[table->clock_hand % HT_BUCKET_SLOTS];
+    table->clock_hand++;
+    if (item->key == NULL) {
+      continue;
+    }
+    if (item->referenced) {
+      item->referenced = 0;
+      continue;
+    }
+    ht_remove_slot(table, item);
+    HT_COUNT(table, evictions);
+    return true;
+  }
+}
+
+/*
+ * Omezení počtu prvků tabulky na capacity (0 = bez omezení). Tabulka se
+ * pak chová jako cache: když je plná, vkládající funkce před vložením
+ * nového klíče vyhodí jiný prvek přibližným LRU (algoritmus CLOCK, viz
+ * zřetězená varianta). Referenční bit leží vedle otisku prvku. Pokud má
+ * tabulka víc prvků, vyhodí se nadbytečné hned.
+ */
+bool ht_set_capacity(ht_table_t *table, size_t capacity) {
+  table->capacity = capacity;
+  while (capacity > 0 && table->count > capacity) {
+    ht_evict(table);
+  }
+  return true;
+}
+
+/*
+ * Vyhledání prvku s klíčem o známé délce a hashi (ht_search a jeho
+ * varianty).
+ */
+static ht_item_t *ht_search_hashed(ht_table_t *table, const char *key,
+                                   size_t length, uint64_t hash) {
+  ht_item_t *item = NULL;
+  if (table->buckets != NULL) {
+    item = ht_find(table, key, length, hash);
+  }
+  ht_count_search(table, item != NULL);
+  if (item != NULL && table->capacity > 0 && !item->referenced) {
+    item->referenced = 1;
+  }
+  return item;
+}
+
+/*
+ * Vyhledání prvku podle klíče o délce length, který nemusí končit nulovým
+ * znakem (např. úsek vstupního bufferu). Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length) {
+  return ht_search_hashed(table, key, length,
+                          ht_hash_bytes(key, length, table->seed));
+}
+
+/*
+ * Vyhledání prvku podle klíče s předem spočítaným hashem (viz ht_key_t).
+ * Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_key(ht_table_t *table, const ht_key_t *key) {
+  return ht_search_hashed(table, key->data, key->length,
+                          ht_handle_hash(key, table->seed));
+}
+
+/*
+ * Vložení prvku s klíčem o známé délce a hashi (viz ht_insert). Pokud
+ * prvek s klíčem už existuje, jeho hodnota se přepíše jen při replace.
+ * Vrací existující nebo nový prvek, při chybě NULL.
+ */
+static ht_item_t *ht_insert_hashed(ht_table_t *table, const char *key,
+                                   size_t length, uint64_t hash, float value,
+                                   bool replace) {
+  if (length > HT_MAX_KEY_LENGTH) {
+    return NULL;  // Délka klíče se do prvku nevejde
+  }
+  if (table->buckets == NULL && !ht_rebuild(table, table->min_size, NULL)) {
+    return NULL;  // Ošetření chyby při alokaci paměti
+  }
+
+  ht_item_t *item = ht_find(table, key, length, hash);
+  if (item != NULL) {
+    if (replace) {
+      item->value = value;
+    }
+    if (table->capacity > 0 && !item->referenced) {
+      item->referenced = 1;
+    }
+    HT_COUNT(table, updates);
+    return item;
+  }
+
+  // Plná tabulka s omezenou kapacitou uvolní místo pro nový prvek
+  if (table->capacity > 0 && table->count >= table->capacity) {
+    ht_evict(table);
+  }
+
+  if ((table->count + 1) * HT_MAX_LOAD_DEN >
+          table->size * HT_BUCKET_SLOTS * HT_MAX_LOAD_NUM &&
+      !ht_rebuild(table, table->size * 2, NULL)) {
+    return NULL;
+  }
+
+  char *block = ht_arena_alloc(&table->arena, sizeof(uint32_t) + length + 1);
+  if (block == NULL) {
+    return NULL;
+  }
+  uint32_t stored_length = (uint32_t)length;
+  memcpy(block, &stored_length, sizeof(stored_length));
+  char *new_key = block + sizeof(uint32_t);
+  memcpy(new_key, key, length);
+  new_key[length] = '\0';
+
+  ht_item_t new_item;
+  new_item.key = new_key;
+  new_item.value = value;
+  new_item.tag = ht_hash_tag(hash);
+  new_item.referenced = 0;
+
+  // Volné místo v některém z obou košů
+  size_t mask = table->size - 1;
+  size_t bucket = ht_hash_bucket(hash, mask);
+  ht_item_t *slot = ht_free_slot(&table->buckets[bucket]);
+  if (slot == NULL) {
+    slot = ht_free_slot(
+        &table->buckets[ht_alt_bucket(bucket, new_item.tag, mask)]);
+  }
+  if (slot != NULL) {
+    *slot = new_item;
+  } else if (!ht_place(table->buckets, table->size, &new_item, hash)) {
+    // Vytlačování se zacyklilo: při nízkém naplnění stačí nové semínko
+    uint64_t seed = table->seed;
+    bool reseed = table->count * 2 < table->size * HT_BUCKET_SLOTS;
+    if (reseed) {
+      table->seed = ht_random_seed();
+    }
+    if (!ht_rebuild(table, reseed ? table->size : table->size * 2,
+                    &new_item)) {
+      table->seed = seed;
+      ht_arena_free(&table->arena, block, sizeof(uint32_t) + length + 1);
+      return NULL;
+    }
+    if (reseed) {
+      HT_COUNT(table, reseeds);
+      hash = ht_hash_bytes(key, length, table->seed);
+    }
+  }
+  table->count++;
+  HT_COUNT(table, inserts);
+  return slot != NULL ? slot : ht_find(table, key, length, hash);
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahradí jeho hodnotu.
+ * Pokud by nový prvek překročil faktor naplnění, tabulka se nejprve
+ * přestaví na dvojnásobnou velikost.
+ */
+void ht_insert(ht_table_t *table, char *key, float value) {
+  ht_upsert(table, key, value);
+}
+
+/*
+ * Vložení prvku s klíčem o délce length, který nemusí končit nulovým
+ * znakem. Klíč se zkopíruje jen při vytvoření nového prvku.
+ */
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value) {
+  ht_insert_hashed(table, key, length, ht_hash_bytes(key, length, table->seed),
+                   value, true);
+}
+
+/*
+ * Vložení prvku s klíčem s předem spočítaným hashem (viz ht_key_t).
+ */
+void ht_insert_key(ht_table_t *table, const ht_key_t *key, float value) {
+  ht_insert_hashed(table, key->data, key->length,
+                   ht_handle_hash(key, table->seed), value, true);
+}
+
+/*
+ * Vložení nebo přepsání hodnoty jako ht_insert.
+ *
+ * Vrací ukazatel na hodnotu prvku, při chybě NULL. Ukazatel platí jen do
+ * další změny tabulky: vytlačování i přestavba pole prvky přesouvají.
+ */
+float *ht_upsert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  ht_item_t *item = ht_insert_hashed(
+      table, key, length, ht_hash_bytes(key, length, table->seed), value, true);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty, a pokud klíč v tabulce není, vložení prvku s hodnotou
+ * value. Klíč se hashuje jen jednou.
+ *
+ * Vrací ukazatel na hodnotu prvku (platný jako u ht_upsert), při chybě
+ * NULL.
+ */
+float *ht_get_or_insert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  ht_item_t *item = ht_insert_hashed(
+      table, key, length, ht_hash_bytes(key, length, table->seed), value, false);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Dávkové získání hodnot: values[i] dostane výsledek ht_get(table, keys[i]).
+ *
+ * Klíče se zpracovávají po HT_BATCH_SIZE: nejprve se spočítají hashe
+ * a přednačtou oba koše každého klíče, pak se přednačte klíč kandidáta
+ * se shodným otiskem a teprve nakonec se klíče porovnají. Výpadky cache
+ * různých klíčů se tak překrývají.
+ */
+void ht_get_many(ht_table_t *table, char *keys[], size_t count,
+                 float *values[]) {
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    char **batch_keys = keys + start;
+    float **batch_values = values + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+    ht_bucket_t *buckets[HT_BATCH_SIZE][2];
+
+    if (table->buckets == NULL) {
+      for (size_t i = 0; i < batch; i++) {
+        batch_values[i] = NULL;
+        ht_count_search(table, false);
+      }
+      continue;
+    }
+    size_t mask = table->size - 1;
+
+    // Hashe klíčů a přednačtení obou košů
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_keys[i]);
+      hashes[i] = ht_hash_bytes(batch_keys[i], lengths[i], table->seed);
+      size_t bucket = ht_hash_bucket(hashes[i], mask);
+      buckets[i][0] = &table->buckets[bucket];
+      buckets[i][1] = &table->buckets[ht_alt_bucket(
+          bucket, ht_hash_tag(hashes[i]), mask)];
+      HT_PREFETCH(buckets[i][0]);
+      HT_PREFETCH(buckets[i][1]);
+    }
+
+    // Přednačtení klíče prvního kandidáta se shodným otiskem
+    for (size_t i = 0; i < batch; i++) {
+      uint32_t tag = ht_hash_tag(hashes[i]);
+      for (int b = 0; b < 2 * HT_BUCKET_SLOTS; b++) {
+        ht_item_t *item = &buckets[i][b / HT_BUCKET_SLOTS]
+                               ->slots[b % HT_BUCKET_SLOTS];
+        if (item->key != NULL && item->tag == tag) {
+          HT_PREFETCH(item->key - sizeof(uint32_t));
+          break;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_item_t *item =
+          ht_search_hashed(table, batch_keys[i], lengths[i], hashes[i]);
+      batch_values[i] = item != NULL ? &item->value : NULL;
+    }
+  }
+}
+
+/*
+ * Dávkové vložení count prvků (klíč a hodnota z items[i]).
+ *
+ * Vkládání mění tabulku, proto se prvky vkládají postupně; pro každou
+ * dávku se ale předem spočítají hashe a přednačtou oba koše klíčů.
+ */
+void ht_insert_many(ht_table_t *table, const ht_item_t items[], size_t count) {
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    const ht_item_t *batch_items = items + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_items[i].key);
+      hashes[i] = ht_hash_bytes(batch_items[i].key, lengths[i], table->seed);
+      if (table->buckets != NULL) {
+        size_t mask = table->size - 1;
+        size_t bucket = ht_hash_bucket(hashes[i], mask);
+        HT_PREFETCH(&table->buckets[bucket]);
+        HT_PREFETCH(&table->buckets[ht_alt_bucket(
+            bucket, ht_hash_tag(hashes[i]), mask)]);
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_insert_hashed(table, batch_items[i].key, lengths[i], hashes[i],
+                       batch_items[i].value, true);
+    }
+  }
+}
+
+// Vytlačování prochází celým polem, rozdělení vstupu má jediný úsek
+static size_t ht_build_shard(uint64_t hash, const void *context) {
+  (void)hash;
+  (void)context;
+  return 0;
+}
+
+/*
+ * Paralelní vložení count prvků (klíč keys[i] s hodnotou values[i]);
+ * výsledek je stejný jako po postupném ht_insert.
+ *
+ * Vytlačený prvek může přejít do libovolného koše, pole proto nejde
+ * rozdělit na nezávislé úseky. Paralelně (threads vláken) se počítají
+ * jen hashe; pole košů se předem přestaví na velikost pro všechny nové
+ * klíče, aby vkládání v jednom vlákně nemuselo pole zvětšovat. Při chybě
+ * alokace vrací false; klíče vložené do té doby v tabulce zůstanou.
+ */
+bool ht_build_parallel(ht_table_t *table, char *keys[], const float values[],
+                       size_t count, int threads) {
+  size_t size = ht_buckets_for(table->count + count);
+  size = size > table->min_size ? size : table->min_size;
+  if ((table->buckets == NULL || size > table->size) &&
+      !ht_rebuild(table, size, NULL)) {
+    return false;
+  }
+
+  ht_partition_t partition;
+  uint64_t seed = table->seed;
+  if (!ht_partition(&partition, keys, count, seed, 1, ht_build_shard, NULL,
+                    threads)) {
+    return false;
+  }
+  bool ok = true;
+  for (size_t i = 0; i < count && ok; i++) {
+    size_t length = strlen(keys[i]);
+    // Přestavba s novým semínkem mohla změnit hashe
+    uint64_t hash = table->seed == seed
+                        ? partition.hashes[i]
+                        : ht_hash_bytes(keys[i], length, table->seed);
+    ok = ht_insert_hashed(table, keys[i], length, hash, values[i], true) !=
+         NULL;
+  }
+  ht_partition_free(&partition);
+  return ok;
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Funkce vrátí klíč prvku do arény a místo uvolní. Pokud prvek
+ * neexistuje, funkce nedělá nic.
+ */
+void ht_delete(ht_table_t *table, char *key) {
+  if (table->buckets == NULL) {
+    return;
+  }
+  size_t length = strlen(key);
+  ht_item_t *item =
+      ht_find(table, key, length, ht_hash_bytes(key, length, table->seed));
+  if (item == NULL) {
+    return;
+  }
+
+  ht_remove_slot(table, item);
+  HT_COUNT(table, deletes);
+
+  // Po hromadném mazání pole zmenšíme, nejvýše však na počáteční velikost
+  if (table->size > table->min_size &&
+      table->count * HT_MIN_LOAD_DIV < table->size * HT_BUCKET_SLOTS) {
+    size_t new_size = ht_buckets_for(table->count * 2);
+    ht_rebuild(table, new_size > table->min_size ? new_size : table->min_size,
+               NULL);
+  }
+}
+
+/*
+ * Smazání všech prvků z tabulky.
+ *
+ * Funkce uvolní pole tabulky a celou arénu klíčů (bez procházení
+ * jednotlivých míst) a uvede tabulku do stavu po inicializaci. Omezení
+ * kapacity (ht_set_capacity) zůstává.
+ */
+void ht_delete_all(ht_table_t *table) {
+  free(table->buckets);
+  ht_arena_release(&table->arena);
+
+  table->buckets = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->clock_hand = 0;
+}
+
+/*
+ * Statistiky tabulky: počítadla operací (viz ht_stats_t) a stav pole.
+ * Velikost je počet míst (koše krát HT_BUCKET_SLOTS) a délka seznamu
+ * synonym počet košů, které projde hledání klíče: 1, leží-li prvek ve
+ * svém prvním koši, jinak 2. Zjišťuje se přepočítáním hashů všech klíčů.
+ */
+void ht_stats(ht_table_t *table, ht_stats_t *stats) {
+#if HT_STATS
+  *stats = table->stats;
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+  stats->count = table->count;
+  stats->size = table->size * HT_BUCKET_SLOTS;
+  stats->capacity = table->capacity;
+  stats->longest_chain = 0;
+  for (size_t i = 0; i < table->size * HT_BUCKET_SLOTS; i++) {
+    ht_item_t *item = &table->buckets[i / HT_BUCKET_SLOTS]
+                           .slots[i % HT_BUCKET_SLOTS];
+    if (item->key == NULL) {
+      continue;
+    }
+    uint64_t hash =
+        ht_hash_bytes(item->key, ht_key_length(item->key), table->seed);
+    size_t length =
+        ht_hash_bucket(hash, table->size - 1) == i / HT_BUCKET_SLOTS ? 1 : 2;
+    stats->longest_chain =
+        length > stats->longest_chain ? length : stats->longest_chain;
+  }
+  stats->load_factor =
+      stats->size > 0 ? (double)stats->count / stats->size : 0;
+  stats->hit_ratio =
+      stats->searches > 0 ? (double)stats->hits / stats->searches : 0;
+
+  ht_arena_stats_t arena;
+  ht_arena_stats(&table->arena, &arena);
+  stats->bytes = arena.reserved + table->size * sizeof(ht_bucket_t);
+}
@@ -0,0 +1,752 @@
+/*
+ * Tabulka s rozptýlenými položkami — otevřené adresování
+ *
+ * Varianta se stejným rozhraním jako hashtable.c, která místo seznamů
+ * synonym ukládá prvky přímo do pole tabulky. Ke každému místu patří
+ * řídicí bajt se 7 bity hashe uloženého klíče. Místa se prohledávají po
+ * skupinách HT_GROUP_SIZE a řídicí bajty celé skupiny se porovnají jedinou
+ * instrukcí SSE2, takže většina vyhledání projde jen jednu skupinu a klíč
+ * porovná nejvýše s jedním kandidátem.
+ *
+ * Smazané místo se označí HT_CTRL_DELETED jen tehdy, když jím mohou
+ * procházet posloupnosti zkoušení jiných klíčů (jeho skupina nemá žádné
+ * prázdné místo). Smazaná místa se započítávají do faktoru naplnění
+ * a po jeho překročení se pole přestaví, takže se posloupnosti zkoušení
+ * mazáním dlouhodobě neprodlužují.
+ *
+ * Na rozdíl od zřetězené varianty se pole přestavuje najednou a ukazatele
+ * vrácené funkcemi ht_search a ht_get platí jen do další změny tabulky.
+ */
+
+#include "hashtable.h"
+#include "ht_common.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Bitová maska míst ve skupině, bit i odpovídá i-tému místu skupiny
+typedef uint32_t ht_mask_t;
+
+/*
+ * Vrátí masku míst skupiny, jejichž řídicí bajt je roven byte.
+ */
+static inline ht_mask_t ht_match(const uint8_t *group, uint8_t byte) {
+#ifdef __SSE2__
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (ht_mask_t)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#else
+  ht_mask_t mask = 0;
+  for (int i = 0; i < HT_GROUP_SIZE; i++) {
+    if (group[i] == byte) {
+      mask |= (ht_mask_t)1 << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/*
+ * Vrátí masku volných (prázdných nebo smazaných) míst skupiny. Oba řídicí
+ * bajty mají nastavený nejvyšší bit, obsazená místa ho mají nulový.
+ */
+static inline ht_mask_t ht_match_free(const uint8_t *group) {
+#ifdef __SSE2__
+  return (ht_mask_t)_mm_movemask_epi8(
+      _mm_loadu_si128((const __m128i *)group));
+#else
+  ht_mask_t mask = 0;
+  for (int i = 0; i < HT_GROUP_SIZE; i++) {
+    if (group[i] & 0x80) {
+      mask |= (ht_mask_t)1 << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+// Index nejnižšího nastaveného bitu nenulové masky
+static inline int ht_first_bit(ht_mask_t mask) {
+#ifdef __GNUC__
+  return __builtin_ctz(mask);
+#else
+  int i = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+// Dolních 7 bitů hashe se ukládá do řídicího bajtu, zbytek vybírá skupinu
+static inline uint8_t ht_hash_ctrl(uint64_t hash) {
+  return (uint8_t)(hash & 0x7f);
+}
+
+static inline size_t ht_hash_group(uint64_t hash, size_t group_mask) {
+  return (size_t)(hash >> 7) & group_mask;
+}
+
+/*
+ * Najde prvek s daným klíčem. Skupiny se zkoušejí s rostoucím krokem
+ * (1, 2, 3, ...), což při počtu skupin rovném mocnině dvojky projde každou
+ * skupinu právě jednou. Hledání končí ve skupině s prázdným místem.
+ * Pokud visited není NULL, uloží do něj počet prošlých skupin.
+ */
+static ht_item_t *ht_find(ht_table_t *table, const char *key, size_t length,
+                          uint64_t hash, size_t *visited) {
+  size_t group_mask = table->size / HT_GROUP_SIZE - 1;
+  size_t group = ht_hash_group(hash, group_mask);
+  uint8_t tag = ht_hash_ctrl(hash);
+  ht_item_t *found = NULL;
+  size_t step = 0;
+  bool done = false;
+
+  while (!done && step <= group_mask) {
+    const uint8_t *ctrl = table->ctrl + group * HT_GROUP_SIZE;
+    step++;
+    for (ht_mask_t mask = ht_match(ctrl, tag); mask != 0; mask &= mask - 1) {
+      ht_item_t *item = &table->items[group * HT_GROUP_SIZE + ht_first_bit(mask)];
+      if (item->length == length && memcmp(item->key, key, length) == 0) {
+        found = item;
+        break;
+      }
+    }
+    done = found != NULL || ht_match(ctrl, HT_CTRL_EMPTY) != 0;
+    group = (group + step) & group_mask;
+  }
+  ht_count_probes(table, step);
+  if (visited != NULL) {
+    *visited = step;
+  }
+  return found;
+}
+
+/*
+ * Vrátí index prvního volného místa na posloupnosti zkoušení daného hashe.
+ * Faktor naplnění zaručuje, že takové místo existuje.
+ */
+static size_t ht_find_free(ht_table_t *table, uint64_t hash) {
+  size_t group_mask = table->size / HT_GROUP_SIZE - 1;
+  size_t group = ht_hash_group(hash, group_mask);
+
+  for (size_t step = 1;; step++) {
+    ht_mask_t mask = ht_match_free(table->ctrl + group * HT_GROUP_SIZE);
+    if (mask != 0) {
+      return group * HT_GROUP_SIZE + ht_first_bit(mask);
+    }
+    group = (group + step) & group_mask;
+  }
+}
+
+/*
+ * Nejmenší počet míst (mocnina dvojky, alespoň jedna skupina), do kterého
+ * se vejde count prvků bez překročení maximálního faktoru naplnění.
+ */
+static size_t ht_capacity_for(size_t count) {
+  size_t size = HT_GROUP_SIZE;
+  while (count * HT_MAX_LOAD_DEN > size * HT_MAX_LOAD_NUM) {
+    size *= 2;
+  }
+  return size;
+}
+
+/*
+ * Přestaví tabulku do nového pole o new_size místech. Řídicí bajty a místa
+ * leží v jednom bloku paměti, smazaná místa se při přestavbě zahodí.
+ * Hashe všech klíčů se přitom počítají znovu, proto se zároveň znovu
+ * naplní filtr, dimenzovaný na plné nové pole.
+ * Při chybě alokace vrací false a tabulka zůstane beze změny.
+ */
+static bool ht_rebuild(ht_table_t *table, size_t new_size) {
+  uint8_t *block = malloc(new_size + new_size * sizeof(ht_item_t));
+  if (block == NULL) {
+    return false;
+  }
+
+  uint8_t *old_ctrl = table->ctrl;
+  ht_item_t *old_items = table->items;
+  size_t old_size = table->size;
+
+  table->ctrl = block;
+  table->items = (ht_item_t *)(block + new_size);
+  table->size = new_size;
+  table->deleted = 0;
+  memset(table->ctrl, HT_CTRL_EMPTY, new_size);
+  size_t capacity = new_size / HT_MAX_LOAD_DEN * HT_MAX_LOAD_NUM;
+  if (!ht_filter_reserve(&table->filter, capacity)) {
+    ht_filter_clear(&table->filter);
+  }
+
+  for (size_t i = 0; i < old_size; i++) {
+    if (!(old_ctrl[i] & 0x80)) {
+      uint64_t hash =
+          ht_hash_bytes(old_items[i].key, old_items[i].length, table->seed);
+      size_t slot = ht_find_free(table, hash);
+      table->ctrl[slot] = ht_hash_ctrl(hash);
+      table->items[slot] = old_items[i];
+      ht_filter_add(&table->filter, hash);
+    }
+  }
+  free(old_ctrl);
+  return true;
+}
+
+/*
+ * Inicializace tabulky — zavolá sa před prvním použitím tabulky.
+ *
+ * Pole tabulky pro HT_SIZE prvků se alokuje až při prvním vložení.
+ * Tabulka začíná s náhodným semínkem (při vypnutém HT_RANDOM_SEED
+ * s nulovým), jiné lze nastavit funkcí ht_set_seed.
+ */
+void ht_init(ht_table_t *table) {
+  table->ctrl = NULL;
+  table->items = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->deleted = 0;
+  table->min_size = ht_capacity_for(HT_SIZE > 0 ? (size_t)HT_SIZE : 1);
+  table->capacity = 0;
+  table->clock_hand = 0;
+  table->seed = HT_RANDOM_SEED ? ht_random_seed() : 0;
+  ht_arena_init(&table->arena);
+  ht_filter_init(&table->filter);
+#if HT_STATS
+  memset(&table->stats, 0, sizeof(table->stats));
+#endif
+}
+
+/*
+ * Statistiky alokátoru klíčů tabulky: rezervovaná paměť, paměť živých
+ * klíčů, paměť připravená k recyklaci a podíl nevyužité paměti.
+ */
+void ht_alloc_stats(ht_table_t *table, ht_arena_stats_t *stats) {
+  ht_arena_stats(&table->arena, stats);
+}
+
+/*
+ * Nastavení semínka rozptylovací funkce tabulky.
+ *
+ * Pokud tabulka již obsahuje prvky, přestaví ji podle nového semínka.
+ */
+void ht_set_seed(ht_table_t *table, uint64_t seed) {
+  uint64_t old_seed = table->seed;
+  table->seed = seed;
+  if (table->ctrl != NULL && !ht_rebuild(table, table->size)) {
+    table->seed = old_seed;  // Prvky zůstaly rozmístěné podle starého
+  }
+}
+
+/*
+ * Zapnutí filtru příslušnosti (viz filter.h) s pravděpodobností falešné
+ * shody fp_rate, jehož pole čítačů zabere nejvýše max_bytes bajtů
+ * (0 = bez omezení). Filtr se dimenzuje na plné pole tabulky a při každé
+ * přestavbě pole se naplní znovu; na limitu paměti jen roste
+ * pravděpodobnost falešné shody. Pro fp_rate mimo interval (0,1) se filtr
+ * vypne, ht_delete_all ho vypne také.
+ *
+ * Vyhledání klíče, který filtr odmítne, vrátí NULL bez procházení skupin.
+ * Vkládání filtr nepoužívá, posloupnost zkoušení prochází tak jako tak
+ * kvůli ochraně před zahlcením kolizemi (HT_FLOOD_GROUPS).
+ * Při chybě alokace vrací false a nastavení filtru se nezmění.
+ */
+bool ht_set_filter(ht_table_t *table, double fp_rate, size_t max_bytes) {
+  size_t capacity = table->size / HT_MAX_LOAD_DEN * HT_MAX_LOAD_NUM;
+  if (!ht_filter_setup(&table->filter, fp_rate, max_bytes, capacity)) {
+    return false;
+  }
+  for (size_t slot = 0; slot < table->size; slot++) {
+    if (!(table->ctrl[slot] & 0x80)) {
+      ht_item_t *item = &table->items[slot];
+      ht_filter_add(&table->filter,
+                    ht_hash_bytes(item->key, item->length, table->seed));
+    }
+  }
+  return true;
+}
+
+/*
+ * Odstranění prvku na obsazeném místě slot (klíč má hash hash). Pokud
+ * skupina místa obsahuje prázdné místo, žádná posloupnost zkoušení
+ * skupinou neprochází a místo se může rovnou označit jako prázdné.
+ */
+static void ht_remove_slot(ht_table_t *table, size_t slot, uint64_t hash) {
+  ht_item_t *item = &table->items[slot];
+  const uint8_t *group = table->ctrl + (slot & ~(size_t)(HT_GROUP_SIZE - 1));
+  ht_filter_remove(&table->filter, hash);
+  ht_arena_free(&table->arena, item->key, item->length + 1);
+  if (ht_match(group, HT_CTRL_EMPTY) != 0) {
+    table->ctrl[slot] = HT_CTRL_EMPTY;
+  } else {
+    table->ctrl[slot] = HT_CTRL_DELETED;
+    table->deleted++;
+  }
+  table->count--;
+}
+
+/*
+ * Vyhodí jeden prvek algoritmem CLOCK (viz ht_set_capacity). Ručička
+ * prochází místa pole po skupinách a přeskakuje volná místa celé skupiny
+ * najednou; obsazeným místům s referenčním bitem ho vynuluje a první
+ * prvek bez něj vyhodí. Vrací false, pokud je tabulka prázdná.
+ */
+static bool ht_evict(ht_table_t *table) {
+  if (table->count == 0) {
+    return false;
+  }
+  for (;;) {
+    if (table->clock_hand >= table->size) {
+      table->clock_hand = 0;
+    }
+    size_t start = table->clock_hand & ~(size_t)(HT_GROUP_SIZE - 1);
+    ht_mask_t full = ~ht_match_free(table->ctrl + start) &
+                     ((ht_mask_t)~0u << (table->clock_hand - start)) &
+                     (((ht_mask_t)1 << HT_GROUP_SIZE) - 1);
+    if (full == 0) {
+      table->clock_hand = start + HT_GROUP_SIZE;
+      continue;
+    }
+    size_t slot = start + (size_t)ht_first_bit(full);
+    ht_item_t *item = &table->items[slot];
+    table->clock_hand = slot + 1;
+    if (item->referenced) {
+      item->referenced = 0;
+      continue;
+    }
+    ht_remove_slot(table, slot,
+                   ht_hash_bytes(item->key, item->length, table->seed));
+    HT_COUNT(table, evictions);
+    return true;
+  }
+}
+
+/*
+ * Omezení počtu prvků tabulky na capacity (0 = bez omezení). Tabulka se
+ * pak chová jako cache: když je plná, vkládající funkce před vložením
+ * nového klíče vyhodí jiný prvek přibližným LRU (algoritmus CLOCK, viz
+ * zřetězená varianta). Referenční bit leží v nejvyšším bitu délky klíče,
+ * takže se místo nezvětší, a vyhozené místo i klíč se hned použijí pro
+ * nový prvek. Pokud má tabulka víc prvků, vyhodí se nadbytečné hned.
+ */
+bool ht_set_capacity(ht_table_t *table, size_t capacity) {
+  table->capacity = capacity;
+  while (capacity > 0 && table->count > capacity) {
+    ht_evict(table);
+  }
+  return true;
+}
+
+/*
+ * Vyhledání prvku s klíčem o známé délce a hashi (ht_search a jeho
+ * varianty). Klíč odmítnutý filtrem se v poli nehledá.
+ */
+static ht_item_t *ht_search_hashed(ht_table_t *table, const char *key,
+                                   size_t length, uint64_t hash) {
+  ht_item_t *item = NULL;
+  if (!ht_filter_may_contain(&table->filter, hash)) {
+    HT_COUNT(table, filtered);
+    ht_count_probes(table, 0);
+  } else if (table->ctrl != NULL) {
+    item = ht_find(table, key, length, hash, NULL);
+  }
+  ht_count_search(table, item != NULL);
+  if (item != NULL && table->capacity > 0 && !item->referenced) {
+    item->referenced = 1;
+  }
+  return item;
+}
+
+/*
+ * Vyhledání prvku podle klíče o délce length, který nemusí končit nulovým
+ * znakem (např. úsek vstupního bufferu). Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_n(ht_table_t *table, const char *key, size_t length) {
+  return ht_search_hashed(table, key, length,
+                          ht_hash_bytes(key, length, table->seed));
+}
+
+/*
+ * Vyhledání prvku podle klíče s předem spočítaným hashem (viz ht_key_t).
+ * Jinak stejné jako ht_search.
+ */
+ht_item_t *ht_search_key(ht_table_t *table, const ht_key_t *key) {
+  return ht_search_hashed(table, key->data, key->length,
+                          ht_handle_hash(key, table->seed));
+}
+
+/*
+ * Vložení prvku s klíčem o známé délce a hashi (viz ht_insert). Pokud
+ * prvek s klíčem už existuje, jeho hodnota se přepíše jen při replace.
+ * Vrací existující nebo nový prvek, při chybě NULL.
+ */
+static ht_item_t *ht_insert_hashed(ht_table_t *table, const char *key,
+                                   size_t length, uint64_t hash, float value,
+                                   bool replace) {
+  if (length > HT_MAX_KEY_LENGTH) {
+    return NULL;  // Délka klíče se do prvku nevejde
+  }
+  if (table->ctrl == NULL && !ht_rebuild(table, table->min_size)) {
+    return NULL;  // Ošetření chyby při alokaci paměti
+  }
+
+  size_t groups;
+  ht_item_t *item = ht_find(table, key, length, hash, &groups);
+  if (item != NULL) {
+    if (replace) {
+      item->value = value;
+    }
+    if (table->capacity > 0 && !item->referenced) {
+      item->referenced = 1;
+    }
+    HT_COUNT(table, updates);
+    return item;
+  }
+
+  // Plná tabulka s omezenou kapacitou uvolní místo pro nový prvek
+  if (table->capacity > 0 && table->count >= table->capacity) {
+    ht_evict(table);
+  }
+
+  if ((table->count + table->deleted + 1) * HT_MAX_LOAD_DEN >
+      table->size * HT_MAX_LOAD_NUM) {
+    bool grow = (table->count + 1) * HT_MAX_LOAD_DEN * 2 >
+                table->size * HT_MAX_LOAD_NUM;
+    if (!ht_rebuild(table, grow ? table->size * 2 : table->size)) {
+      return NULL;
+    }
+  }
+
+  char *new_key = ht_arena_alloc(&table->arena, length + 1);
+  if (new_key == NULL) {
+    return NULL;
+  }
+  memcpy(new_key, key, length);
+  new_key[length] = '\0';
+
+  size_t slot = ht_find_free(table, hash);
+  if (table->ctrl[slot] == HT_CTRL_DELETED) {
+    table->deleted--;
+  }
+  table->ctrl[slot] = ht_hash_ctrl(hash);
+  table->items[slot].key = new_key;
+  table->items[slot].value = value;
+  table->items[slot].length = (uint32_t)length;
+  table->items[slot].referenced = 0;
+  table->count++;
+  HT_COUNT(table, inserts);
+  ht_filter_add(&table->filter, hash);
+
+  // Příliš dlouhá posloupnost zkoušení značí cíleně kolidující klíče
+  if (groups > HT_FLOOD_GROUPS) {
+    uint64_t seed = table->seed;
+    table->seed = ht_random_seed();
+    if (ht_rebuild(table, table->size)) {
+      HT_COUNT(table, reseeds);
+      return ht_find(table, key, length,
+                     ht_hash_bytes(key, length, table->seed), NULL);
+    }
+    table->seed = seed;
+  }
+  return &table->items[slot];
+}
+
+/*
+ * Vložení nového prvku do tabulky.
+ *
+ * Pokud prvek s daným klíčem už v tabulce existuje, nahradí jeho hodnotu.
+ * Pokud by nový prvek překročil faktor naplnění, tabulka se nejprve
+ * přestaví: při velkém počtu smazaných míst na stejnou velikost, jinak na
+ * dvojnásobnou.
+ */
+void ht_insert(ht_table_t *table, char *key, float value) {
+  ht_upsert(table, key, value);
+}
+
+/*
+ * Vložení prvku s klíčem o délce length, který nemusí končit nulovým
+ * znakem. Klíč se zkopíruje jen při vytvoření nového prvku.
+ */
+void ht_insert_n(ht_table_t *table, const char *key, size_t length,
+                 float value) {
+  ht_insert_hashed(table, key, length, ht_hash_bytes(key, length, table->seed),
+                   value, true);
+}
+
+/*
+ * Vložení prvku s klíčem s předem spočítaným hashem (viz ht_key_t).
+ */
+void ht_insert_key(ht_table_t *table, const ht_key_t *key, float value) {
+  ht_insert_hashed(table, key->data, key->length,
+                   ht_handle_hash(key, table->seed), value, true);
+}
+
+/*
+ * Vložení nebo přepsání hodnoty jako ht_insert.
+ *
+ * Vrací ukazatel na hodnotu prvku, při chybě NULL. Ukazatel platí jen do
+ * další změny tabulky: přestavba pole prvky přesouvá.
+ */
+float *ht_upsert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  ht_item_t *item = ht_insert_hashed(
+      table, key, length, ht_hash_bytes(key, length, table->seed), value, true);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty, a pokud klíč v tabulce není, vložení prvku s hodnotou
+ * value. Klíč se hashuje jen jednou.
+ *
+ * Vrací ukazatel na hodnotu prvku (platný jako u ht_upsert), při chybě
+ * NULL.
+ */
+float *ht_get_or_insert(ht_table_t *table, char *key, float value) {
+  size_t length = strlen(key);
+  ht_item_t *item = ht_insert_hashed(
+      table, key, length, ht_hash_bytes(key, length, table->seed), value, false);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Dávkové získání hodnot: values[i] dostane výsledek ht_get(table, keys[i]).
+ *
+ * Klíče se zpracovávají po HT_BATCH_SIZE v několika průchodech přes celou
+ * dávku: spočítají se hashe a přednačtou řídicí bajty domovských skupin,
+ * pak se přednačte první kandidát ve skupině a jeho klíč a teprve nakonec
+ * se klíče porovnají. Výpadky cache různých klíčů se tak překrývají.
+ */
+void ht_get_many(ht_table_t *table, char *keys[], size_t count,
+                 float *values[]) {
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    char **batch_keys = keys + start;
+    float **batch_values = values + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+    const uint8_t *groups[HT_BATCH_SIZE];
+    bool filtered[HT_BATCH_SIZE];
+
+    if (table->ctrl == NULL) {
+      for (size_t i = 0; i < batch; i++) {
+        batch_values[i] = NULL;
+        ht_count_search(table, false);
+      }
+      continue;
+    }
+    size_t group_mask = table->size / HT_GROUP_SIZE - 1;
+
+    // Hashe klíčů a přednačtení řídicích bajtů domovských skupin (kromě
+    // klíčů odmítnutých filtrem)
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_keys[i]);
+      hashes[i] = ht_hash_bytes(batch_keys[i], lengths[i], table->seed);
+      groups[i] = table->ctrl +
+                  ht_hash_group(hashes[i], group_mask) * HT_GROUP_SIZE;
+      filtered[i] = !ht_filter_may_contain(&table->filter, hashes[i]);
+      if (!filtered[i]) {
+        HT_PREFETCH(groups[i]);
+      }
+    }
+
+    // Přednačtení prvního kandidáta ve skupině
+    for (size_t i = 0; i < batch; i++) {
+      ht_mask_t mask =
+          filtered[i] ? 0 : ht_match(groups[i], ht_hash_ctrl(hashes[i]));
+      if (mask != 0) {
+        HT_PREFETCH(&table->items[(size_t)(groups[i] - table->ctrl) +
+                                  ht_first_bit(mask)]);
+      }
+    }
+
+    // Přednačtení klíče kandidáta
+    for (size_t i = 0; i < batch; i++) {
+      ht_mask_t mask =
+          filtered[i] ? 0 : ht_match(groups[i], ht_hash_ctrl(hashes[i]));
+      if (mask != 0) {
+        HT_PREFETCH(table->items[(size_t)(groups[i] - table->ctrl) +
+                                 ht_first_bit(mask)].key);
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_item_t *item =
+          ht_search_hashed(table, batch_keys[i], lengths[i], hashes[i]);
+      batch_values[i] = item != NULL ? &item->value : NULL;
+    }
+  }
+}
+
+/*
+ * Dávkové vložení count prvků (klíč a hodnota z items[i]).
+ *
+ * Vkládání mění tabulku, proto se prvky vkládají postupně; pro každou
+ * dávku se ale předem spočítají hashe a přednačtou řídicí bajty skupin,
+ * do kterých klíče patří.
+ */
+void ht_insert_many(ht_table_t *table, const ht_item_t items[], size_t count) {
+  for (size_t start = 0; start < count; start += HT_BATCH_SIZE) {
+    size_t batch = count - start < HT_BATCH_SIZE ? count - start
+                                                 : HT_BATCH_SIZE;
+    const ht_item_t *batch_items = items + start;
+    size_t lengths[HT_BATCH_SIZE];
+    uint64_t hashes[HT_BATCH_SIZE];
+
+    for (size_t i = 0; i < batch; i++) {
+      lengths[i] = strlen(batch_items[i].key);
+      hashes[i] = ht_hash_bytes(batch_items[i].key, lengths[i], table->seed);
+      if (table->ctrl != NULL) {
+        size_t group_mask = table->size / HT_GROUP_SIZE - 1;
+        HT_PREFETCH(table->ctrl +
+                    ht_hash_group(hashes[i], group_mask) * HT_GROUP_SIZE);
+      }
+    }
+
+    for (size_t i = 0; i < batch; i++) {
+      ht_insert_hashed(table, batch_items[i].key, lengths[i], hashes[i],
+                       batch_items[i].value, true);
+    }
+  }
+}
+
+// Otevřené adresování vkládá sériově, rozdělení vstupu má jediný úsek
+static size_t ht_build_shard(uint64_t hash, const void *context) {
+  (void)hash;
+  (void)context;
+  return 0;
+}
+
+/*
+ * Paralelní vložení count prvků (klíč keys[i] s hodnotou values[i]);
+ * výsledek je stejný jako po postupném ht_insert.
+ *
+ * Posloupnosti zkoušení procházejí celým polem, které proto nejde
+ * rozdělit na nezávislé úseky. Pole se jen předem zvětší pro všechny nové
+ * klíče a threads vláken spočítá hashe klíčů; vkládá se pak v jednom
+ * vlákně bez přestaveb pole. Při chybě alokace vrací false; klíče
+ * vložené do té doby v tabulce zůstanou.
+ */
+bool ht_build_parallel(ht_table_t *table, char *keys[], const float values[],
+                       size_t count, int threads) {
+  size_t size = ht_capacity_for(table->count + count);
+  size = size > table->min_size ? size : table->min_size;
+  if ((table->ctrl == NULL || size > table->size) &&
+      !ht_rebuild(table, size)) {
+    return false;
+  }
+
+  ht_partition_t partition;
+  uint64_t seed = table->seed;
+  if (!ht_partition(&partition, keys, count, seed, 1, ht_build_shard, NULL,
+                    threads)) {
+    return false;
+  }
+  bool ok = true;
+  for (size_t i = 0; i < count && ok; i++) {
+    size_t length = strlen(keys[i]);
+    // Ochrana před zahlcením kolizemi mohla změnit semínko
+    uint64_t hash = table->seed == seed
+                        ? partition.hashes[i]
+                        : ht_hash_bytes(keys[i], length, table->seed);
+    ok = ht_insert_hashed(table, keys[i], length, hash, values[i], true) !=
+         NULL;
+  }
+  ht_partition_free(&partition);
+  return ok;
+}
+
+/*
+ * Smazání prvku z tabulky.
+ *
+ * Funkce vrátí klíč prvku do arény a místo uvolní (ht_remove_slot). Pokud
+ * prvek neexistuje, funkce nedělá nic.
+ */
+void ht_delete(ht_table_t *table, char *key) {
+  if (table->ctrl == NULL) {
+    return;
+  }
+  size_t length = strlen(key);
+  uint64_t hash = ht_hash_bytes(key, length, table->seed);
+  ht_item_t *item = ht_find(table, key, length, hash, NULL);
+  if (item == NULL) {
+    return;
+  }
+
+  ht_remove_slot(table, (size_t)(item - table->items), hash);
+  HT_COUNT(table, deletes);
+
+  // Po hromadném mazání pole zmenšíme, nejvýše však na počáteční velikost
+  if (table->size > table->min_size &&
+      table->count * HT_MIN_LOAD_DIV < table->size) {
+    size_t new_size = ht_capacity_for(table->count * 2);
+    ht_rebuild(table, new_size > table->min_size ? new_size : table->min_size);
+  }
+}
+
+/*
+ * Smazání všech prvků z tabulky.
+ *
+ * Funkce uvolní pole tabulky a celou arénu klíčů (bez procházení
+ * jednotlivých míst) a uvede tabulku do stavu po inicializaci. Omezení
+ * kapacity (ht_set_capacity) zůstává.
+ */
+void ht_delete_all(ht_table_t *table) {
+  free(table->ctrl);
+  ht_arena_release(&table->arena);
+  ht_filter_free(&table->filter);
+
+  table->ctrl = NULL;
+  table->items = NULL;
+  table->size = 0;
+  table->count = 0;
+  table->deleted = 0;
+  table->clock_hand = 0;
+}
+
+/*
+ * Statistiky tabulky: počítadla operací (viz ht_stats_t) a stav pole.
+ * Délka seznamu synonym je zde počet skupin, které projde hledání klíče
+ * od jeho domovské skupiny; nejdelší se zjišťuje přepočítáním hashů všech
+ * klíčů, takže doba volání roste s velikostí tabulky.
+ */
+void ht_stats(ht_table_t *table, ht_stats_t *stats) {
+#if HT_STATS
+  *stats = table->stats;
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+  stats->count = table->count;
+  stats->size = table->size;
+  stats->capacity = table->capacity;
+  stats->longest_chain = 0;
+  size_t group_mask = table->size / HT_GROUP_SIZE - 1;
+  for (size_t slot = 0; slot < table->size; slot++) {
+    if (table->ctrl[slot] & 0x80) {
+      continue;  // Prázdné nebo smazané místo
+    }
+    ht_item_t *item = &table->items[slot];
+    uint64_t hash = ht_hash_bytes(item->key, item->length, table->seed);
+    size_t group = ht_hash_group(hash, group_mask);
+    size_t step = 1;
+    while (group != slot / HT_GROUP_SIZE) {
+      group = (group + step) & group_mask;
+      step++;
+    }
+    stats->longest_chain =
+        step > stats->longest_chain ? step : stats->longest_chain;
+  }
+  stats->load_factor =
+      stats->size > 0 ? (double)stats->count / stats->size : 0;
+  stats->hit_ratio =
+      stats->searches > 0 ? (double)stats->hits / stats->searches : 0;
+
+  ht_arena_stats_t arena;
+  ht_arena_stats(&table->arena, &arena);
+  stats->bytes = arena.reserved + table->size * (1 + sizeof(ht_item_t)) +
+                 ht_filter_bytes(&table->filter);
+}
@@ -0,0 +1,122 @@
+/*
+ * Interní hlavičkový soubor se společným kódem variant tabulky, které
+ * pracují v jednom vlákně (hashtable.c, hashtable_oa.c, hashtable_cuckoo.c
+ * a hashtable_compact.c). Souběžná varianta má vlastní počítadla
+ * statistik i obaly, protože čtení nesmí zapisovat do sdílené paměti.
+ *
+ * Hlavičku vkládá jen zdrojový soubor varianty, v programu je tedy právě
+ * jednou. Kromě statických pomocných funkcí proto obsahuje i veřejné
+ * obaly (ht_search, ht_get, ht_add), které jen doplní délku klíče nebo
+ * zavolají obecnější funkci varianty; překladač je může vložit přímo do
+ * kódu varianty.
+ */
+
+#ifndef IAL_HASHTABLE_COMMON_H
+#define IAL_HASHTABLE_COMMON_H
+
+#include "hashtable.h"
+#include <string.h>
+
+// Zvýšení počítadla statistik (při HT_STATS == 0 se nepřekládá)
+#if HT_STATS
+#define HT_COUNT(table, counter) ((table)->stats.counter++)
+#else
+#define HT_COUNT(table, counter) ((void)(table))
+#endif
+
+/*
+ * Započítá hledání klíče, které prošlo visited prvků (u otevřeného
+ * adresování skupin, u kukaččího hashování košů), do histogramu.
+ */
+static inline void ht_count_probes(ht_table_t *table, size_t visited) {
+#if HT_STATS
+  table->stats.probes[visited < HT_STATS_PROBES ? visited
+                                                : HT_STATS_PROBES - 1]++;
+#else
+  (void)table;
+  (void)visited;
+#endif
+}
+
+/*
+ * Započítá vyhledání (ht_search, ht_get a jejich varianty) s výsledkem
+ * found.
+ */
+static inline void ht_count_search(ht_table_t *table, bool found) {
+#if HT_STATS
+  table->stats.searches++;
+  if (found) {
+    table->stats.hits++;
+  } else {
+    table->stats.misses++;
+  }
+#else
+  (void)table;
+  (void)found;
+#endif
+}
+
+/*
+ * Hash klíče pro tabulku se semínkem seed. Hash předem připraveného klíče
+ * se použije, jen pokud byl spočítán se stejným semínkem.
+ */
+static inline uint64_t ht_handle_hash(const ht_key_t *key, uint64_t seed) {
+  return key->seed == seed ? key->hash
+                           : ht_hash_bytes(key->data, key->length, seed);
+}
+
+/*
+ * Vyhledání prvku v tabulce.
+ *
+ * V případě úspěchu vrací ukazatel na nalezený prvek; v opačném případě vrací
+ * hodnotu NULL. Platnost prvku popisuje ht_search_n varianty.
+ */
+ht_item_t *ht_search(ht_table_t *table, char *key) {
+  return ht_search_n(table, key, strlen(key));
+}
+
+/*
+ * Získání hodnoty z tabulky.
+ *
+ * V případě úspěchu vrací funkce ukazatel na hodnotu prvku, v opačném
+ * případě hodnotu NULL.
+ */
+float *ht_get(ht_table_t *table, char *key) {
+  return ht_get_n(table, key, strlen(key));
+}
+
+/*
+ * Přičtení delta k hodnotě klíče; chybějící klíč se vloží s hodnotou
+ * delta. Vrací ukazatel na výslednou hodnotu, při chybě NULL.
+ */
+float *ht_add(ht_table_t *table, char *key, float delta) {
+  float *value = ht_get_or_insert(table, key, 0);
+  if (value != NULL) {
+    *value += delta;
+  }
+  return value;
+}
+
+// Otevřené adresování a kukaččí hashování vracejí hodnotu z prvku v poli
+#if defined(HT_BACKEND_OA) || defined(HT_BACKEND_CUCKOO)
+
+/*
+ * Získání hodnoty podle klíče o délce length, který nemusí končit nulovým
+ * znakem. Jinak stejné jako ht_get.
+ */
+float *ht_get_n(ht_table_t *table, const char *key, size_t length) {
+  ht_item_t *item = ht_search_n(table, key, length);
+  return item != NULL ? &item->value : NULL;
+}
+
+/*
+ * Získání hodnoty podle klíče s předem spočítaným hashem (viz ht_key_t).
+ */
+float *ht_get_key(ht_table_t *table, const ht_key_t *key) {
+  ht_item_t *item = ht_search_key(table, key);
+  return item != NULL ? &item->value : NULL;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,322 @@
+/*
+ * Hlavičkový soubor pro typované tabulky s rozptýlenými položkami.
+ *
+ * Makra HTDEC a HTDEF generují tabulku pro libovolný typ klíče K a hodnoty
+ * V (podobně jako STACKDEC a STACKDEF v btree/iter/stack.h). Klíče
+ * a hodnoty leží přímo v poli tabulky, takže se nemusí převádět na
+ * řetězce ani alokovat, a rozptylovací funkce i porovnání klíčů se
+ * překladači nabízejí k vložení přímo do kódu tabulky.
+ *
+ * Tabulka používá otevřené adresování s lineárním zkoušením. Ke každému
+ * místu patří řídicí bajt: HTGEN_EMPTY, HTGEN_DELETED, nebo u obsazeného
+ * místa nejvyšší bit a 7 bitů hashe, takže se klíče porovnávají jen při
+ * shodě těchto bitů.
+ */
+
+#ifndef IAL_HASHTABLE_HTGEN_H
+#define IAL_HASHTABLE_HTGEN_H
+
+#include "hashtable.h"
+#include "pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Počáteční velikost pole (mocnina dvojky)
+#define HTGEN_MIN_SIZE 16
+
+// Maximální faktor naplnění včetně smazaných míst
+#define HTGEN_MAX_LOAD_NUM 7
+#define HTGEN_MAX_LOAD_DEN 8
+
+/*
+ * Nejdelší zkoušení při vložení, po kterém tabulka usoudí, že klíče
+ * cíleně kolidují, a přestaví pole s novým semínkem
+ */
+#define HTGEN_FLOOD_PROBE 1024
+
+// Řídicí bajty volných míst
+#define HTGEN_EMPTY 0x00
+#define HTGEN_DELETED 0x01
+
+// Řídicí bajt obsazeného místa a počáteční místo pro daný hash
+#define HTGEN_TAG(hash) ((uint8_t)(0x80 | ((hash) & 0x7f)))
+#define HTGEN_HOME(hash, size) ((size_t)((hash) >> 7) & ((size) - 1))
+
+/*
+ * Rozptylovací funkce a porovnání pro celočíselné klíče. Nevolají strlen
+ * ani strcmp: hash je jedno promíchání bitů klíče se semínkem.
+ */
+static inline uint64_t ht_int_hash(uint64_t key, uint64_t seed) {
+  key ^= seed;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdu;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53u;
+  key ^= key >> 33;
+  return key;
+}
+
+static inline bool ht_int_eq(uint64_t a, uint64_t b) { return a == b; }
+
+/*
+ * Rozptylovací funkce a porovnání pro řetězcové klíče (klíč se nekopíruje,
+ * musí platit po celou dobu, kdy je v tabulce).
+ */
+static inline uint64_t ht_str_hash(const char *key, uint64_t seed) {
+  return ht_hash_bytes(key, strlen(key), seed);
+}
+
+static inline bool ht_str_eq(const char *a, const char *b) {
+  return strcmp(a, b) == 0;
+}
+
+/*
+ * Makro generující deklarace tabulky s klíči typu K a hodnotami typu V
+ * s názvovým infixem NAME. Pro NAME="u64", K="uint64_t", V="float":
+ *   Datové typy ht_u64_t a ht_u64_entry_t (dvojice klíč a hodnota)
+ *   Funkce void ht_u64_init(ht_u64_t *table)
+ *          float *ht_u64_get(ht_u64_t *table, uint64_t key)
+ *          void ht_u64_insert(ht_u64_t *table, uint64_t key, float value)
+ *          void ht_u64_delete(ht_u64_t *table, uint64_t key)
+ *          void ht_u64_delete_all(ht_u64_t *table)
+ *
+ * Parametry hash_fn a eq_fn se v deklaracích nepoužívají, makro je přijímá
+ * kvůli shodnému zápisu s HTDEF.
+ */
+#define HTDEC(K, V, NAME, hash_fn, eq_fn)                                      \
+  typedef struct {                                                             \
+    K key;                                                                     \
+    V value;                                                                   \
+  } ht_##NAME##_entry_t;                                                       \
+                                                                               \
+  typedef struct {                                                             \
+    uint8_t *ctrl;                 /* řídicí bajty míst */                     \
+    ht_##NAME##_entry_t *entries;  /* klíče a hodnoty */                       \
+    size_t size;                   /* počet míst (mocnina dvojky) */           \
+    size_t count;                  /* počet prvků */                           \
+    size_t deleted;                /* počet smazaných míst */                  \
+    uint64_t seed;                 /* semínko rozptylovací funkce */           \
+  } ht_##NAME##_t;                                                             \
+                                                                               \
+  void ht_##NAME##_init(ht_##NAME##_t *table);                                 \
+  V *ht_##NAME##_get(ht_##NAME##_t *table, K key);                             \
+  void ht_##NAME##_insert(ht_##NAME##_t *table, K key, V value);               \
+  void ht_##NAME##_delete(ht_##NAME##_t *table, K key);                        \
+  void ht_##NAME##_delete_all(ht_##NAME##_t *table);
+
+/*
+ * Makro generující implementaci funkcí tabulky deklarované makrem HTDEC.
+ * Použije se v jednom zdrojovém souboru se stejnými parametry jako HTDEC.
+ *
+ * hash_fn(key, seed) vrací 64bitový hash klíče, eq_fn(a, b) vrací true pro
+ * shodné klíče; obojí může být funkce static inline nebo makro.
+ * Tabulka začíná s náhodným semínkem (při vypnutém HT_RANDOM_SEED
+ * s nulovým) a po vložení se zkoušením delším než HTGEN_FLOOD_PROBE míst
+ * si zvolí nové. Ručně lze semínko změnit jen u prázdné tabulky (před
+ * prvním vložením).
+ */
+#define HTDEF(K, V, NAME, hash_fn, eq_fn)                                      \
+  void ht_##NAME##_init(ht_##NAME##_t *table) {                                \
+    table->ctrl = NULL;                                                        \
+    table->entries = NULL;                                                     \
+    table->size = 0;                                                           \
+    table->count = 0;                                                          \
+    table->deleted = 0;                                                        \
+    table->seed = HT_RANDOM_SEED ? ht_random_seed() : 0;                       \
+  }                                                                            \
+                                                                               \
+  /* Místo klíče, nebo size, pokud klíč v tabulce není */                      \
+  static size_t ht_##NAME##_find(ht_##NAME##_t *table, K key,                  \
+                                 uint64_t hash) {                              \
+    size_t mask = table->size - 1;                                             \
+    size_t slot = HTGEN_HOME(hash, table->size);                               \
+    uint8_t tag = HTGEN_TAG(hash);                                             \
+    while (table->ctrl[slot] != HTGEN_EMPTY) {                                 \
+      if (table->ctrl[slot] == tag && eq_fn(table->entries[slot].key, key)) {  \
+        return slot;                                                           \
+      }                                                                        \
+      slot = (slot + 1) & mask;                                                \
+    }                                                                          \
+    return table->size;                                                        \
+  }                                                                            \
+                                                                               \
+  /* První volné (prázdné nebo smazané) místo pro daný hash */                 \
+  static size_t ht_##NAME##_find_free(ht_##NAME##_t *table, uint64_t hash) {   \
+    size_t mask = table->size - 1;                                             \
+    size_t slot = HTGEN_HOME(hash, table->size);                               \
+    while (table->ctrl[slot] & 0x80) {                                         \
+      slot = (slot + 1) & mask;                                                \
+    }                                                                          \
+    return slot;                                                               \
+  }                                                                            \
+                                                                               \
+  /* Přestavba pole na new_size míst se semínkem seed, bez smazaných */        \
+  static bool ht_##NAME##_rebuild(ht_##NAME##_t *table, size_t new_size,       \
+                                  uint64_t seed) {                             \
+    uint8_t *ctrl = calloc(new_size, 1);                                       \
+    ht_##NAME##_entry_t *entries =                                             \
+        malloc(new_size * sizeof(ht_##NAME##_entry_t));                        \
+    if (ctrl == NULL || entries == NULL) {                                     \
+      free(ctrl);                                                              \
+      free(entries);                                                           \
+      return false;                                                            \
+    }                                                                          \
+    ht_##NAME##_t rebuilt = *table;                                            \
+    rebuilt.ctrl = ctrl;                                                       \
+    rebuilt.entries = entries;                                                 \
+    rebuilt.size = new_size;                                                   \
+    rebuilt.deleted = 0;                                                       \
+    rebuilt.seed = seed;                                                       \
+    for (size_t i = 0; i < table->size; i++) {                                 \
+      if (table->ctrl[i] & 0x80) {                                             \
+        uint64_t hash = hash_fn(table->entries[i].key, seed);                  \
+        size_t slot = ht_##NAME##_find_free(&rebuilt, hash);                   \
+        ctrl[slot] = HTGEN_TAG(hash);                                          \
+        entries[slot] = table->entries[i];                                     \
+      }                                                                        \
+    }                                                                          \
+    free(table->ctrl);                                                         \
+    free(table->entries);                                                      \
+    *table = rebuilt;                                                          \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  V *ht_##NAME##_get(ht_##NAME##_t *table, K key) {                            \
+    if (table->size == 0) {                                                    \
+      return NULL;                                                             \
+    }                                                                          \
+    size_t slot = ht_##NAME##_find(table, key, hash_fn(key, table->seed));     \
+    return slot < table->size ? &table->entries[slot].value : NULL;            \
+  }                                                                            \
+                                                                               \
+  void ht_##NAME##_insert(ht_##NAME##_t *table, K key, V value) {              \
+    if (table->size == 0 &&                                                    \
+        !ht_##NAME##_rebuild(table, HTGEN_MIN_SIZE, table->seed)) {            \
+      return;                                                                  \
+    }                                                                          \
+    uint64_t hash = hash_fn(key, table->seed);                                 \
+    size_t slot = ht_##NAME##_find(table, key, hash);                          \
+    if (slot < table->size) {                                                  \
+      table->entries[slot].value = value;                                      \
+      return;                                                                  \
+    }                                                                          \
+    if ((table->count + table->deleted + 1) * HTGEN_MAX_LOAD_DEN >             \
+        table->size * HTGEN_MAX_LOAD_NUM) {                                    \
+      bool grow = (table->count + 1) * HTGEN_MAX_LOAD_DEN * 2 >                \
+                  table->size * HTGEN_MAX_LOAD_NUM;                            \
+      if (!ht_##NAME##_rebuild(table, grow ? table->size * 2 : table->size,    \
+                               table->seed)) {                                 \
+        return;                                                                \
+      }                                                                        \
+    }                                                                          \
+    slot = ht_##NAME##_find_free(table, hash);                                 \
+    if (table->ctrl[slot] == HTGEN_DELETED) {                                  \
+      table->deleted--;                                                        \
+    }                                                                          \
+    table->ctrl[slot] = HTGEN_TAG(hash);                                       \
+    table->entries[slot].key = key;                                            \
+    table->entries[slot].value = value;                                        \
+    table->count++;                                                            \
+                                                                               \
+    /* Příliš dlouhé zkoušení značí cíleně kolidující klíče */                 \
+    size_t home = HTGEN_HOME(hash, table->size);                               \
+    if (((slot - home) & (table->size - 1)) > HTGEN_FLOOD_PROBE) {             \
+      ht_##NAME##_rebuild(table, table->size, ht_random_seed());               \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  void ht_##NAME##_delete(ht_##NAME##_t *table, K key) {                       \
+    if (table->size == 0) {                                                    \
+      return;                                                                  \
+    }                                                                          \
+    size_t slot = ht_##NAME##_find(table, key, hash_fn(key, table->seed));     \
+    if (slot == table->size) {                                                 \
+      return;                                                                  \
+    }                                                                          \
+    /* Před prázdným místem žádná posloupnost zkoušení nepokračuje */          \
+    if (table->ctrl[(slot + 1) & (table->size - 1)] == HTGEN_EMPTY) {          \
+      table->ctrl[slot] = HTGEN_EMPTY;                                         \
+    } else {                                                                   \
+      table->ctrl[slot] = HTGEN_DELETED;                                       \
+      table->deleted++;                                                        \
+    }                                                                          \
+    table->count--;                                                            \
+  }                                                                            \
+                                                                               \
+  /* Semínko zůstane, znovu se nelosuje */                                     \
+  void ht_##NAME##_delete_all(ht_##NAME##_t *table) {                          \
+    free(table->ctrl);                                                         \
+    free(table->entries);                                                      \
+    table->ctrl = NULL;                                                        \
+    table->entries = NULL;                                                     \
+    table->size = 0;                                                           \
+    table->count = 0;                                                          \
+    table->deleted = 0;                                                        \
+  }
+
+/*
+ * Zkratky pro tabulky s celočíselnými klíči (rychlá cesta bez strlen
+ * a strcmp) a s řetězcovými klíči.
+ */
+#define HTDEC_INT(K, V, NAME) HTDEC(K, V, NAME, ht_int_hash, ht_int_eq)
+#define HTDEF_INT(K, V, NAME) HTDEF(K, V, NAME, ht_int_hash, ht_int_eq)
+#define HTDEC_STR(V, NAME) HTDEC(const char *, V, NAME, ht_str_hash, ht_str_eq)
+#define HTDEF_STR(V, NAME) HTDEF(const char *, V, NAME, ht_str_hash, ht_str_eq)
+
+/*
+ * Tabulky s klíči ze sdíleného fondu řetězců (pool.h): klíčem je 32bitové
+ * ID řetězce, porovnání klíčů je porovnání čísel a bajty řetězce drží jen
+ * fond. Kromě funkcí z HTDEC vzniknou pro NAME="price":
+ *   void ht_price_insert_id(ht_price_t *table, ht_pool_t *pool,
+ *                           uint32_t id, V value)
+ *   void ht_price_delete_id(ht_price_t *table, ht_pool_t *pool, uint32_t id)
+ *   void ht_price_delete_all_ids(ht_price_t *table, ht_pool_t *pool)
+ *
+ * Tyto funkce drží za tabulku vlastní referenci na každé ID v ní:
+ * vložení nového ID mu ve fondu přidá referenci, přepsání hodnoty už
+ * vloženého ID ji znovu nepřidává, smazání a hromadné smazání reference
+ * uvolní.
+ * Reference z ht_pool_intern zůstává volajícímu, který ji uvolní, až ID
+ * sám nepotřebuje. Obecné ht_price_insert a ht_price_delete reference
+ * nemění a u tabulek s ID se nemají míchat s funkcemi *_id.
+ */
+#define HTDEC_ID(V, NAME)                                                      \
+  HTDEC(uint32_t, V, NAME, ht_int_hash, ht_int_eq)                             \
+  void ht_##NAME##_insert_id(ht_##NAME##_t *table, ht_pool_t *pool,            \
+                             uint32_t id, V value);                            \
+  void ht_##NAME##_delete_id(ht_##NAME##_t *table, ht_pool_t *pool,            \
+                             uint32_t id);                                     \
+  void ht_##NAME##_delete_all_ids(ht_##NAME##_t *table, ht_pool_t *pool);
+
+#define HTDEF_ID(V, NAME)                                                      \
+  HTDEF(uint32_t, V, NAME, ht_int_hash, ht_int_eq)                             \
+                                                                               \
+  /* Referenci přidá jen nově vložené ID */                                    \
+  void ht_##NAME##_insert_id(ht_##NAME##_t *table, ht_pool_t *pool,            \
+                             uint32_t id, V value) {                           \
+    size_t count = table->count;                                               \
+    ht_##NAME##_insert(table, id, value);                                      \
+    if (table->count > count) {                                                \
+      ht_pool_retain(pool, id);                                                \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  void ht_##NAME##_delete_id(ht_##NAME##_t *table, ht_pool_t *pool,            \
+                             uint32_t id) {                                    \
+    size_t count = table->count;                                               \
+    ht_##NAME##_delete(table, id);                                             \
+    if (table->count < count) {                                                \
+      ht_pool_release(pool, id);                                               \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  void ht_##NAME##_delete_all_ids(ht_##NAME##_t *table, ht_pool_t *pool) {     \
+    for (size_t i = 0; i < table->size; i++) {                                 \
+      if (table->ctrl[i] & 0x80) {                                             \
+        ht_pool_release(pool, table->entries[i].key);                          \
+      }                                                                        \
+    }                                                                          \
+    ht_##NAME##_delete_all(table);                                             \
+  }
+
+#endif
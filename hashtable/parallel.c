@@ -0,0 +1,163 @@
+/*
+ * Paralelní hromadné vkládání do tabulky s rozptýlenými položkami
+ *
+ * ht_build_parallel rozdělí vstup podle úseků tabulky (souvislých částí
+ * pole vybraných horními bity hashe) a každý úsek naplní jedno vlákno.
+ * Rozdělení je řazení počítáním ve třech krocích: vlákna nad svými částmi
+ * vstupu spočítají hashe a četnosti úseků, z četností se sériově určí,
+ * kam každé vlákno zapisuje, a vlákna pak indexy klíčů rozepíší do úseků.
+ */
+
+#include "parallel.h"
+#include "hashtable.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Jedno vlákno výpočtu ht_parallel_run
+typedef struct {
+  pthread_t thread;
+  void (*work)(void *context, int index);
+  void *context;
+  int index;
+} ht_worker_t;
+
+static void *ht_worker_main(void *argument) {
+  ht_worker_t *worker = argument;
+  worker->work(worker->context, worker->index);
+  return NULL;
+}
+
+/*
+ * Zavolá work(context, i) pro i = 0 .. threads - 1, každé volání v jiném
+ * vlákně (volání s indexem 0 ve volajícím vlákně), a počká na všechna.
+ * Pokud vlákno nejde vytvořit, provede se jeho práce ve volajícím vlákně.
+ */
+void ht_parallel_run(int threads, void (*work)(void *context, int index),
+                     void *context) {
+  ht_worker_t workers[HT_MAX_WORKERS];
+  bool started[HT_MAX_WORKERS];
+  if (threads > HT_MAX_WORKERS) {
+    threads = HT_MAX_WORKERS;
+  }
+
+  for (int i = 1; i < threads; i++) {
+    workers[i].work = work;
+    workers[i].context = context;
+    workers[i].index = i;
+    started[i] = pthread_create(&workers[i].thread, NULL, ht_worker_main,
+                                &workers[i]) == 0;
+  }
+  work(context, 0);
+  for (int i = 1; i < threads; i++) {
+    if (started[i]) {
+      pthread_join(workers[i].thread, NULL);
+    } else {
+      work(context, i);
+    }
+  }
+}
+
+// Rozpracované rozdělení vstupu
+typedef struct {
+  ht_partition_t *partition;
+  char **keys;
+  size_t count;
+  uint64_t seed;
+  ht_shard_fn shard_of;
+  const void *context;
+  int threads;
+  size_t *cursors;  // [vlákno * shards + úsek]: četnost, pak místo zápisu
+} ht_partitioner_t;
+
+// Část vstupu, kterou zpracovává vlákno index
+static void ht_slice(const ht_partitioner_t *p, int index, size_t *from,
+                     size_t *to) {
+  *from = p->count * (size_t)index / (size_t)p->threads;
+  *to = p->count * ((size_t)index + 1) / (size_t)p->threads;
+}
+
+// První krok: hashe klíčů a četnosti úseků
+static void ht_partition_count(void *context, int index) {
+  ht_partitioner_t *p = context;
+  ht_partition_t *partition = p->partition;
+  size_t *counts = p->cursors + (size_t)index * partition->shards;
+  size_t from, to;
+  ht_slice(p, index, &from, &to);
+  for (size_t i = from; i < to; i++) {
+    uint64_t hash = ht_hash_bytes(p->keys[i], strlen(p->keys[i]), p->seed);
+    partition->hashes[i] = hash;
+    counts[p->shard_of(hash, p->context)]++;
+  }
+}
+
+// Třetí krok: rozepsání indexů klíčů do úseků
+static void ht_partition_scatter(void *context, int index) {
+  ht_partitioner_t *p = context;
+  ht_partition_t *partition = p->partition;
+  size_t *cursors = p->cursors + (size_t)index * partition->shards;
+  size_t from, to;
+  ht_slice(p, index, &from, &to);
+  for (size_t i = from; i < to; i++) {
+    size_t shard = p->shard_of(partition->hashes[i], p->context);
+    partition->order[cursors[shard]++] = i;
+  }
+}
+
+/*
+ * Rozdělení count klíčů do shards úseků podle funkce shard_of nad hashi
+ * se semínkem seed; výpočet běží v threads vláknech. Při chybě alokace
+ * vrací false.
+ */
+bool ht_partition(ht_partition_t *partition, char *keys[], size_t count,
+                  uint64_t seed, size_t shards, ht_shard_fn shard_of,
+                  const void *context, int threads) {
+  if (threads < 1) {
+    threads = 1;
+  } else if (threads > HT_MAX_WORKERS) {
+    threads = HT_MAX_WORKERS;
+  }
+  partition->shards = shards;
+  partition->hashes = malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+  partition->order = malloc((count > 0 ? count : 1) * sizeof(size_t));
+  partition->starts = malloc((shards + 1) * sizeof(size_t));
+  size_t *cursors = calloc((size_t)threads * shards, sizeof(size_t));
+  if (partition->hashes == NULL || partition->order == NULL ||
+      partition->starts == NULL || cursors == NULL) {
+    free(cursors);
+    ht_partition_free(partition);
+    return false;
+  }
+
+  ht_partitioner_t p = {partition, keys, count, seed, shard_of,
+                        context, threads, cursors};
+  ht_parallel_run(threads, ht_partition_count, &p);
+
+  // Četnosti převedeme na místa, od kterých vlákna zapisují
+  size_t position = 0;
+  for (size_t shard = 0; shard < shards; shard++) {
+    partition->starts[shard] = position;
+    for (int i = 0; i < threads; i++) {
+      size_t counted = cursors[(size_t)i * shards + shard];
+      cursors[(size_t)i * shards + shard] = position;
+      position += counted;
+    }
+  }
+  partition->starts[shards] = position;
+
+  ht_parallel_run(threads, ht_partition_scatter, &p);
+  free(cursors);
+  return true;
+}
+
+/*
+ * Uvolnění rozděleného vstupu.
+ */
+void ht_partition_free(ht_partition_t *partition) {
+  free(partition->hashes);
+  free(partition->order);
+  free(partition->starts);
+  partition->hashes = NULL;
+  partition->order = NULL;
+  partition->starts = NULL;
+}
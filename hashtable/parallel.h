@@ -0,0 +1,40 @@
+/*
+ * Hlavičkový soubor pro paralelní hromadné vkládání do tabulky
+ * s rozptýlenými položkami.
+ */
+
+#ifndef IAL_HASHTABLE_PARALLEL_H
+#define IAL_HASHTABLE_PARALLEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Nejvyšší počet vláken jednoho paralelního výpočtu.
+ */
+#define HT_MAX_WORKERS 256
+
+/*
+ * Vstup rozdělený podle úseků tabulky. Klíče úseku s leží v order od
+ * starts[s] do starts[s + 1] ve stejném pořadí jako na vstupu, takže při
+ * opakovaném klíči platí poslední hodnota stejně jako u ht_insert.
+ */
+typedef struct ht_partition {
+  uint64_t *hashes;  // hash každého vstupního klíče
+  size_t *order;     // indexy klíčů seřazené podle úseků
+  size_t *starts;    // začátky úseků v order (shards + 1 hodnot)
+  size_t shards;     // počet úseků
+} ht_partition_t;
+
+// Úsek, do kterého patří klíč s daným hashem (context předá volající)
+typedef size_t (*ht_shard_fn)(uint64_t hash, const void *context);
+
+void ht_parallel_run(int threads, void (*work)(void *context, int index),
+                     void *context);
+bool ht_partition(ht_partition_t *partition, char *keys[], size_t count,
+                  uint64_t seed, size_t shards, ht_shard_fn shard_of,
+                  const void *context, int threads);
+void ht_partition_free(ht_partition_t *partition);
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * Sdílený fond řetězců
+ *
+ * Fond ukládá každý řetězec jednou a vrací jeho 32bitové ID (viz pool.h).
+ * Bajty řetězců se připojují za sebe do velkých bloků; pole záznamů
+ * převádí ID na řetězec a rozptylovací index s lineárním zkoušením
+ * převádí řetězec na ID. Index drží jen ID, hash i délka řetězce jsou
+ * v záznamu, takže se při zvětšení indexu nic nepřepočítává.
+ *
+ * Řetězce mají počítadlo referencí. Uvolněný řetězec zmizí z indexu a jeho
+ * ID se přidělí dalšímu novému řetězci, bajty v bloku však zůstanou jako
+ * mrtvé. ht_pool_compact přesune živé řetězce do jednoho nového bloku
+ * a staré bloky uvolní; ID se přitom nemění.
+ */
+
+#include "pool.h"
+#include "hashtable.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Počáteční velikost indexu a pole záznamů
+#define HT_POOL_MIN_INDEX 64
+#define HT_POOL_MIN_ENTRIES 64
+
+// Maximální faktor naplnění indexu
+#define HT_POOL_MAX_LOAD_NUM 3
+#define HT_POOL_MAX_LOAD_DEN 4
+
+/*
+ * Inicializace prázdného fondu.
+ */
+void ht_pool_init(ht_pool_t *pool) {
+  pool->chunks = NULL;
+  pool->next_chunk = HT_POOL_MIN_CHUNK;
+  pool->entries = NULL;
+  pool->entry_count = 0;
+  pool->entry_capacity = 0;
+  pool->free_id = HT_POOL_NONE;
+  pool->count = 0;
+  pool->index = NULL;
+  pool->index_size = 0;
+  pool->reserved = 0;
+  pool->live = 0;
+  pool->dead = 0;
+  pool->seed = HT_RANDOM_SEED ? ht_random_seed() : 0;
+}
+
+/*
+ * Místo řetězce v indexu, nebo první volné místo, kde by měl být.
+ */
+static size_t ht_pool_slot(const ht_pool_t *pool, const char *key,
+                           size_t length, uint64_t hash) {
+  size_t mask = pool->index_size - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    uint32_t id = pool->index[i];
+    if (id == HT_POOL_NONE) {
+      return i;
+    }
+    const ht_pool_entry_t *entry = &pool->entries[id];
+    if (entry->hash == hash && entry->length == length &&
+        memcmp(entry->key, key, length) == 0) {
+      return i;
+    }
+  }
+}
+
+/*
+ * Zdvojnásobí index a vloží do něj ID všech živých řetězců.
+ */
+static bool ht_pool_grow_index(ht_pool_t *pool) {
+  size_t size = pool->index_size == 0 ? HT_POOL_MIN_INDEX
+                                      : pool->index_size * 2;
+  uint32_t *index = malloc(size * sizeof(uint32_t));
+  if (index == NULL) {
+    return false;
+  }
+  memset(index, 0xff, size * sizeof(uint32_t));
+
+  for (size_t i = 0; i < pool->index_size; i++) {
+    uint32_t id = pool->index[i];
+    if (id != HT_POOL_NONE) {
+      size_t j = pool->entries[id].hash & (size - 1);
+      while (index[j] != HT_POOL_NONE) {
+        j = (j + 1) & (size - 1);
+      }
+      index[j] = id;
+    }
+  }
+
+  free(pool->index);
+  pool->index = index;
+  pool->index_size = size;
+  return true;
+}
+
+/*
+ * Zdvojnásobí pole záznamů. ID HT_POOL_NONE se nikdy nepřidělí.
+ */
+static bool ht_pool_grow_entries(ht_pool_t *pool) {
+  size_t capacity = pool->entry_capacity == 0 ? HT_POOL_MIN_ENTRIES
+                                              : pool->entry_capacity * 2u;
+  if (capacity > HT_POOL_NONE) {
+    capacity = HT_POOL_NONE;
+  }
+  if (capacity <= pool->entry_capacity) {
+    return false;
+  }
+  ht_pool_entry_t *entries =
+      realloc(pool->entries, capacity * sizeof(ht_pool_entry_t));
+  if (entries == NULL) {
+    return false;
+  }
+  pool->entries = entries;
+  pool->entry_capacity = (uint32_t)capacity;
+  return true;
+}
+
+/*
+ * Zkopíruje bajty řetězce (a nulový znak) na konec aktuálního bloku. Když
+ * se nevejdou, přidá nový blok; řetězec delší než příští blok dostane
+ * vlastní blok, který se zařadí až za aktuální, aby zbytek aktuálního
+ * bloku zůstal k dispozici.
+ */
+static const char *ht_pool_store(ht_pool_t *pool, const char *key,
+                                 size_t length) {
+  ht_pool_chunk_t *chunk = pool->chunks;
+  if (chunk == NULL || chunk->size - chunk->used < length + 1) {
+    bool oversized = length + 1 > pool->next_chunk;
+    size_t size = oversized ? length + 1 : pool->next_chunk;
+    chunk = malloc(sizeof(ht_pool_chunk_t) + size);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->size = size;
+    chunk->used = 0;
+    if (oversized && pool->chunks != NULL) {
+      chunk->next = pool->chunks->next;
+      pool->chunks->next = chunk;
+    } else {
+      chunk->next = pool->chunks;
+      pool->chunks = chunk;
+    }
+    pool->reserved += sizeof(ht_pool_chunk_t) + size;
+    if (!oversized && pool->next_chunk < HT_POOL_MAX_CHUNK) {
+      pool->next_chunk *= 2;
+    }
+  }
+
+  char *bytes = chunk->data + chunk->used;
+  memcpy(bytes, key, length);
+  bytes[length] = '\0';
+  chunk->used += length + 1;
+  return bytes;
+}
+
+/*
+ * Vrátí ID řetězce key délky length a přidá mu referenci. Řetězec, který
+ * ve fondu ještě není, se do něj zkopíruje. Při chybě alokace vrací
+ * HT_POOL_NONE a fond se nezmění.
+ */
+uint32_t ht_pool_intern(ht_pool_t *pool, const char *key, size_t length) {
+  if (length >= UINT32_MAX) {
+    return HT_POOL_NONE;
+  }
+  if ((size_t)(pool->count + 1) * HT_POOL_MAX_LOAD_DEN >
+          pool->index_size * HT_POOL_MAX_LOAD_NUM &&
+      !ht_pool_grow_index(pool)) {
+    return HT_POOL_NONE;
+  }
+
+  uint64_t hash = ht_hash_bytes(key, length, pool->seed);
+  size_t slot = ht_pool_slot(pool, key, length, hash);
+  uint32_t id = pool->index[slot];
+  if (id != HT_POOL_NONE) {
+    pool->entries[id].refs++;
+    return id;
+  }
+
+  // Nový řetězec dostane naposledy uvolněné ID, jinak další nepoužité
+  bool reused = pool->free_id != HT_POOL_NONE;
+  if (!reused && pool->entry_count == pool->entry_capacity &&
+      !ht_pool_grow_entries(pool)) {
+    return HT_POOL_NONE;
+  }
+  const char *bytes = ht_pool_store(pool, key, length);
+  if (bytes == NULL) {
+    return HT_POOL_NONE;
+  }
+  if (reused) {
+    id = pool->free_id;
+    pool->free_id = pool->entries[id].length;
+  } else {
+    id = pool->entry_count++;
+  }
+
+  ht_pool_entry_t *entry = &pool->entries[id];
+  entry->key = bytes;
+  entry->length = (uint32_t)length;
+  entry->refs = 1;
+  entry->hash = hash;
+  pool->index[slot] = id;
+  pool->count++;
+  pool->live += length + 1;
+  return id;
+}
+
+/*
+ * ID řetězce bez přidání reference, nebo HT_POOL_NONE, pokud ve fondu
+ * není. Klíč, který fond nezná, nemůže být v žádné z jeho tabulek.
+ */
+uint32_t ht_pool_find(const ht_pool_t *pool, const char *key, size_t length) {
+  if (pool->count == 0) {
+    return HT_POOL_NONE;
+  }
+  uint64_t hash = ht_hash_bytes(key, length, pool->seed);
+  return pool->index[ht_pool_slot(pool, key, length, hash)];
+}
+
+/*
+ * Přidá referenci na řetězec s daným ID (např. když ID vloží do tabulky
+ * další tabulka sdílející fond).
+ */
+void ht_pool_retain(ht_pool_t *pool, uint32_t id) { pool->entries[id].refs++; }
+
+/*
+ * Odebere referenci na řetězec. Poslední reference řetězec odstraní
+ * z indexu (posunutím následujících míst zpět, index nemá smazaná místa),
+ * jeho bajty se započtou jako mrtvé a ID se vrátí mezi volná.
+ */
+void ht_pool_release(ht_pool_t *pool, uint32_t id) {
+  ht_pool_entry_t *entry = &pool->entries[id];
+  if (--entry->refs > 0) {
+    return;
+  }
+
+  size_t mask = pool->index_size - 1;
+  size_t hole = entry->hash & mask;
+  while (pool->index[hole] != id) {
+    hole = (hole + 1) & mask;
+  }
+  for (size_t i = (hole + 1) & mask; pool->index[i] != HT_POOL_NONE;
+       i = (i + 1) & mask) {
+    // Místo i se smí přesunout do díry, jen pokud díra leží mezi jeho
+    // počátečním místem a i
+    size_t home = pool->entries[pool->index[i]].hash & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      pool->index[hole] = pool->index[i];
+      hole = i;
+    }
+  }
+  pool->index[hole] = HT_POOL_NONE;
+
+  pool->count--;
+  pool->live -= entry->length + 1;
+  pool->dead += entry->length + 1;
+  entry->key = NULL;
+  entry->length = pool->free_id;
+  pool->free_id = id;
+}
+
+/*
+ * Přesune živé řetězce do jednoho nového bloku a uvolní staré bloky
+ * i s mrtvými bajty. ID zůstávají, dříve vrácené ukazatele na řetězce
+ * (ht_pool_key) ale přestanou platit. Při chybě alokace vrací false
+ * a fond se nezmění.
+ */
+bool ht_pool_compact(ht_pool_t *pool) {
+  if (pool->dead == 0) {
+    return true;
+  }
+
+  size_t size = pool->live < HT_POOL_MIN_CHUNK ? HT_POOL_MIN_CHUNK
+                                                : pool->live;
+  ht_pool_chunk_t *chunk = malloc(sizeof(ht_pool_chunk_t) + size);
+  if (chunk == NULL) {
+    return false;
+  }
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+
+  for (uint32_t id = 0; id < pool->entry_count; id++) {
+    ht_pool_entry_t *entry = &pool->entries[id];
+    if (entry->key != NULL) {
+      char *bytes = chunk->data + chunk->used;
+      memcpy(bytes, entry->key, entry->length + 1);
+      entry->key = bytes;
+      chunk->used += entry->length + 1;
+    }
+  }
+
+  while (pool->chunks != NULL) {
+    ht_pool_chunk_t *next = pool->chunks->next;
+    free(pool->chunks);
+    pool->chunks = next;
+  }
+  pool->chunks = chunk;
+  pool->reserved = sizeof(ht_pool_chunk_t) + size;
+  pool->dead = 0;
+  return true;
+}
+
+/*
+ * Uvolnění celého fondu najednou (bez ohledu na reference). Všechna ID
+ * přestanou platit; fond zůstane prázdný s původním semínkem.
+ */
+void ht_pool_free(ht_pool_t *pool) {
+  uint64_t seed = pool->seed;
+  while (pool->chunks != NULL) {
+    ht_pool_chunk_t *next = pool->chunks->next;
+    free(pool->chunks);
+    pool->chunks = next;
+  }
+  free(pool->entries);
+  free(pool->index);
+  ht_pool_init(pool);
+  pool->seed = seed;
+}
+
+/*
+ * Statistiky fondu: bajty bloků, bajty živých řetězců, mrtvé bajty
+ * (uvolní je ht_pool_compact) a jejich podíl.
+ */
+void ht_pool_stats(const ht_pool_t *pool, ht_arena_stats_t *stats) {
+  stats->reserved = pool->reserved;
+  stats->live = pool->live;
+  stats->free = pool->dead;
+  size_t used = pool->live + pool->dead;
+  stats->fragmentation = used == 0 ? 0 : (double)pool->dead / used;
+}
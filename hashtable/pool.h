@@ -0,0 +1,82 @@
+/*
+ * Hlavičkový soubor pro sdílený fond řetězců (klíčů tabulek).
+ */
+
+#ifndef IAL_HASHTABLE_POOL_H
+#define IAL_HASHTABLE_POOL_H
+
+#include "arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Fond ukládá každý řetězec jen jednou a přiděluje mu 32bitové ID.
+ * Tabulky, které sdílejí fond a jako klíč používají ID (viz HTDEC_ID
+ * v htgen.h), porovnávají klíče jako čísla a bajty řetězce drží jen fond.
+ *
+ * Bajty řetězců se připojují za sebe do velkých bloků (HT_POOL_MIN_CHUNK
+ * až HT_POOL_MAX_CHUNK bajtů). Uvolněné řetězce v blocích zůstanou jako
+ * mrtvé bajty až do ht_pool_compact, ID ale jde hned znovu přidělit.
+ */
+#define HT_POOL_MIN_CHUNK (64 * 1024)
+#define HT_POOL_MAX_CHUNK (16 * 1024 * 1024)
+
+// Neplatné ID (chyba alokace, řetězec ve fondu není)
+#define HT_POOL_NONE UINT32_MAX
+
+// Blok s bajty řetězců
+typedef struct ht_pool_chunk {
+  struct ht_pool_chunk *next; // další (starší) blok
+  size_t size;                // velikost dat bloku
+  size_t used;                // obsazené bajty dat
+  char data[];
+} ht_pool_chunk_t;
+
+// Řetězec fondu (key == NULL, pokud ID není přidělené)
+typedef struct ht_pool_entry {
+  const char *key; // bajty řetězce v bloku, ukončené nulovým znakem
+  uint32_t length; // délka řetězce (u volného ID další volné ID)
+  uint32_t refs;   // počet referencí
+  uint64_t hash;   // ht_hash_bytes(key, length, seed)
+} ht_pool_entry_t;
+
+// Fond řetězců
+typedef struct ht_pool {
+  ht_pool_chunk_t *chunks;  // bloky, první je aktuální
+  size_t next_chunk;        // velikost dat příštího bloku
+  ht_pool_entry_t *entries; // řetězce podle ID
+  uint32_t entry_count;     // počet přidělených ID včetně volných
+  uint32_t entry_capacity;  // velikost pole entries
+  uint32_t free_id;         // první volné ID (HT_POOL_NONE = žádné)
+  uint32_t count;           // počet živých řetězců
+  uint32_t *index;          // rozptylovací index: ID nebo HT_POOL_NONE
+  size_t index_size;        // velikost indexu (mocnina dvojky)
+  size_t reserved;          // bajty bloků
+  size_t live;              // bajty živých řetězců
+  size_t dead;              // bajty uvolněných řetězců v blocích
+  uint64_t seed;            // semínko hashe
+} ht_pool_t;
+
+void ht_pool_init(ht_pool_t *pool);
+uint32_t ht_pool_intern(ht_pool_t *pool, const char *key, size_t length);
+uint32_t ht_pool_find(const ht_pool_t *pool, const char *key, size_t length);
+void ht_pool_retain(ht_pool_t *pool, uint32_t id);
+void ht_pool_release(ht_pool_t *pool, uint32_t id);
+bool ht_pool_compact(ht_pool_t *pool);
+void ht_pool_free(ht_pool_t *pool);
+void ht_pool_stats(const ht_pool_t *pool, ht_arena_stats_t *stats);
+
+/*
+ * Řetězec a jeho délka podle ID. Ukazatel platí do uvolnění řetězce
+ * nebo do ht_pool_compact.
+ */
+static inline const char *ht_pool_key(const ht_pool_t *pool, uint32_t id) {
+  return pool->entries[id].key;
+}
+
+static inline size_t ht_pool_length(const ht_pool_t *pool, uint32_t id) {
+  return pool->entries[id].length;
+}
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Export statistik tabulky společný pro všechny varianty tabulky
+ * s rozptýlenými položkami.
+ */
+
+#include "hashtable.h"
+#include <inttypes.h>
+#include <stdio.h>
+
+/*
+ * Zapíše statistiky do buffer jako jeden řádek dvojic klíč=hodnota
+ * oddělených mezerami (bez znaku nového řádku), například:
+ *
+ *   count=15 size=16 capacity=0 load=0.938 longest=3 bytes=1024
+ *   searches=4 hits=3 misses=1 filtered=0 hit_ratio=0.750 inserts=15
+ *   updates=0 deletes=0 evictions=0 reseeds=0 probes=0,2,1,1,0,0,0,0
+ *
+ * Vrací stejně jako snprintf délku celého řádku; pokud je alespoň size,
+ * byl řádek zkrácen.
+ */
+int ht_stats_format(const ht_stats_t *stats, char *buffer, size_t size) {
+  int length = snprintf(
+      buffer, size,
+      "count=%zu size=%zu capacity=%zu load=%.3f longest=%zu bytes=%zu"
+      " searches=%" PRIu64 " hits=%" PRIu64 " misses=%" PRIu64
+      " filtered=%" PRIu64 " hit_ratio=%.3f inserts=%" PRIu64
+      " updates=%" PRIu64 " deletes=%" PRIu64 " evictions=%" PRIu64
+      " reseeds=%" PRIu64 " probes=",
+      stats->count, stats->size, stats->capacity, stats->load_factor,
+      stats->longest_chain, stats->bytes, stats->searches, stats->hits,
+      stats->misses, stats->filtered, stats->hit_ratio, stats->inserts,
+      stats->updates, stats->deletes, stats->evictions, stats->reseeds);
+  for (int i = 0; i < HT_STATS_PROBES && length >= 0; i++) {
+    size_t used = (size_t)length < size ? (size_t)length : size;
+    int written = snprintf(buffer + used, size - used, i > 0 ? ",%" PRIu64
+                                                              : "%" PRIu64,
+                           stats->probes[i]);
+    length = written < 0 ? written : length + written;
+  }
+  return length;
+}
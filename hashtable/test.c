@@ -1,7 +1,14 @@
+#include "art.h"
 #include "hashtable.h"
+#include "htgen.h"
+#include "pool.h"
 #include "test_util.h"
+#include "values.h"
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define INSERT_TEST_DATA(TABLE)                                                \
   ht_insert_many(TABLE, TEST_DATA, sizeof(TEST_DATA) / sizeof(TEST_DATA[0]));
@@ -13,11 +20,35 @@ const ht_item_t TEST_DATA[15] = {
     {"USD Coin", 0.86},    {"Uniswap", 21.68},    {"Terra", 30.67},
     {"Litecoin", 156.87},  {"Avalanche", 47.03},  {"Chainlink", 21.90}};
 
+// Typované tabulky: celočíselné klíče a řetězcové klíče s hodnotou struktury
+typedef struct {
+  float price;
+  int rank;
+} coin_t;
+
+HTDEC_INT(uint64_t, float, u64)
+HTDEF_INT(uint64_t, float, u64)
+HTDEC_STR(coin_t, coin)
+HTDEF_STR(coin_t, coin)
+
+// Tabulky s klíči ze sdíleného fondu řetězců
+HTDEC_ID(float, price)
+HTDEF_ID(float, price)
+HTDEC_ID(int, rank)
+HTDEF_ID(int, rank)
+
+// Při nulovém semínku dostanou všechny klíče stejný hash (cílené kolize)
+#define flood_hash(key, seed) ((seed) != 0 ? ht_int_hash(key, seed) : 0)
+HTDEC(uint64_t, float, flood, flood_hash, ht_int_eq)
+HTDEF(uint64_t, float, flood, flood_hash, ht_int_eq)
+
 void init_test() {
   printf("Hash Table - testing script\n");
   printf("---------------------------\n");
   HT_SIZE = 13;
   printf("\nSetting HT_SIZE to prime number (%i)\n", HT_SIZE);
+  // Nulové semínko, aby se tabulky vypisovaly při každém běhu stejně
+  HT_RANDOM_SEED = false;
   printf("\n");
 }
 
@@ -76,6 +107,686 @@ INSERT_TEST_DATA(test_table)
 ht_delete_all(test_table);
 ENDTEST
 
+TEST(test_resize, "Grow the table with many items and shrink it back")
+ht_init(test_table);
+char key[16];
+for (int i = 0; i < 200; i++) {
+  snprintf(key, sizeof(key), "key%i", i);
+  ht_insert(test_table, key, i);
+}
+printf("Table size after 200 inserts: %zu\n", test_table->size);
+int found = 0;
+for (int i = 0; i < 200; i++) {
+  snprintf(key, sizeof(key), "key%i", i);
+  float *value = ht_get(test_table, key);
+  if (value != NULL && *value == i) {
+    found++;
+  }
+}
+printf("Items found: %i\n", found);
+for (int i = 5; i < 200; i++) {
+  snprintf(key, sizeof(key), "key%i", i);
+  ht_delete(test_table, key);
+}
+ENDTEST
+
+TEST(test_hash_distribution, "Chain lengths for anagrams and numbered keys")
+ht_init(test_table);
+// Všechny permutace jednoho slova mají stejný součet bajtů
+char word[] = "hashing";
+char key[32];
+for (int i = 0; i < 5040; i++) {
+  char letters[] = "hashing";
+  int rest = i;
+  for (int j = 0; j < 7; j++) {
+    int factorial = 1;
+    for (int k = 2; k < 7 - j; k++) {
+      factorial *= k;
+    }
+    int pick = rest / factorial;
+    rest %= factorial;
+    word[j] = letters[pick];
+    memmove(letters + pick, letters + pick + 1, 7 - j - pick);
+  }
+  ht_insert(test_table, word, i);
+}
+for (int i = 0; i < 20000; i++) {
+  snprintf(key, sizeof(key), "user:%i", i);
+  ht_insert(test_table, key, i);
+}
+ht_print_chain_report(test_table);
+ht_delete_all(test_table);
+ENDTEST
+
+TEST(test_alloc_stats, "Recycle deleted items through the table allocator")
+ht_init(test_table);
+char key[16];
+for (int i = 0; i < 1000; i++) {
+  snprintf(key, sizeof(key), "item%i", i);
+  ht_insert(test_table, key, i);
+}
+ht_print_alloc_stats(test_table);
+for (int i = 0; i < 1000; i += 2) {
+  snprintf(key, sizeof(key), "item%i", i);
+  ht_delete(test_table, key);
+}
+ht_print_alloc_stats(test_table);
+for (int i = 0; i < 1000; i += 2) {
+  snprintf(key, sizeof(key), "item%i", i);
+  ht_insert(test_table, key, i);
+}
+ht_print_alloc_stats(test_table);
+ht_delete_all(test_table);
+ht_print_alloc_stats(test_table);
+ENDTEST
+
+TEST(test_get_many, "Get values of a batch of keys")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+// Dávka delší než HT_BATCH_SIZE s chybějícími klíči uprostřed
+char *keys[20];
+float *values[20];
+for (int i = 0; i < 20; i++) {
+  keys[i] = i % 4 == 3 ? "Monero" : TEST_DATA[i % 15].key;
+}
+ht_get_many(test_table, keys, 20, values);
+for (int i = 0; i < 20; i++) {
+  printf("%s: ", keys[i]);
+  ht_print_item_value(values[i]);
+}
+ENDTEST
+
+TEST(test_upsert, "Get or insert a value and accumulate counts with ht_add")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+// Existující hodnota zůstane, chybějící klíč se vloží s výchozí hodnotou
+ht_print_item_value(ht_get_or_insert(test_table, "Terra", 0));
+ht_print_item_value(ht_get_or_insert(test_table, "Monero", 250.12));
+ht_print_item_value(ht_upsert(test_table, "Monero", 251.40));
+char *words[] = {"Bitcoin", "Tezos", "Tezos", "Bitcoin", "Tezos"};
+for (int i = 0; i < 5; i++) {
+  ht_add(test_table, words[i], 1);
+}
+ht_print_item(ht_search(test_table, "Bitcoin"));
+ht_print_item(ht_search(test_table, "Tezos"));
+ENDTEST
+
+TEST(test_key_slices, "Search and insert key slices and prehashed keys")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+// Klíče jsou úseky bufferu bez ukončovacího znaku
+const char *buffer = "Terraform Tezos Litecoin";
+ht_print_item(ht_search_n(test_table, buffer, 5));
+ht_print_item_value(ht_get_n(test_table, buffer, 4));
+ht_insert_n(test_table, buffer + 10, 5, 1.20);
+ht_print_item(ht_search(test_table, "Tezos"));
+// Jeden hash klíče pro dvě tabulky, druhá má jiné semínko
+ht_table_t other;
+ht_init(&other);
+ht_set_seed(&other, 42);
+ht_key_t key;
+ht_key_init(&key, buffer + 16, 8, 0);
+ht_insert_key(&other, &key, 99.5);
+ht_print_item_value(ht_get_key(test_table, &key));
+ht_print_item(ht_search_key(&other, &key));
+ht_print_item_value(ht_get(&other, "Litecoin"));
+ht_delete_all(&other);
+ENDTEST
+
+TEST(test_stats, "Count operations and export table statistics")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_insert(test_table, "Terra", 31.02);
+ht_get(test_table, "Bitcoin");
+ht_get(test_table, "Monero");
+ht_search(test_table, "XRP");
+ht_delete(test_table, "Tether");
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("searches %llu, hits %llu, misses %llu\n",
+       (unsigned long long)stats.searches, (unsigned long long)stats.hits,
+       (unsigned long long)stats.misses);
+printf("inserts %llu, updates %llu, deletes %llu, count %zu\n",
+       (unsigned long long)stats.inserts, (unsigned long long)stats.updates,
+       (unsigned long long)stats.deletes, stats.count);
+char line[320];
+ht_stats_format(&stats, line, sizeof(line));
+printf("%s\n", line);
+ENDTEST
+
+TEST(test_hash_flooding, "Reseed the table when keys collide on purpose")
+ht_init(test_table);
+// Klíče, jejichž hashe se semínkem 0 padnou do stejného seznamu synonym
+// (u otevřeného adresování do stejné skupiny, u kukaččího hashování do
+// stejné dvojice košů, dokud jich pole nemá víc než 16)
+#ifdef HT_BACKEND_OA
+uint64_t mask = 0xfffull << 7;
+#elif defined(HT_BACKEND_CUCKOO)
+uint64_t mask = 0xfull << 32 | 0xfull;
+#else
+uint64_t mask = 0xfffull << 52;
+#endif
+char key[32];
+int inserted = 0;
+for (unsigned i = 0; inserted < 1200; i++) {
+  snprintf(key, sizeof(key), "flood%u", i);
+  if ((ht_hash_bytes(key, strlen(key), 0) & mask) == 0) {
+    ht_insert(test_table, key, inserted++);
+  }
+}
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Seed changed: %i\n", test_table->seed != 0);
+printf("Items: %zu, longest chain below limit: %i\n", stats.count,
+       stats.longest_chain < HT_FLOOD_CHAIN);
+ht_delete_all(test_table);
+ENDTEST
+
+TEST(test_filter, "Reject missing keys with a membership filter")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+printf("Filter enabled: %i\n", ht_set_filter(test_table, 0.01, 0));
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+ht_print_item_value(ht_get(test_table, "Monero"));
+// Filtr roste s tabulkou a smazané klíče z něj mizí
+char key[32];
+for (int i = 0; i < 2000; i++) {
+  snprintf(key, sizeof(key), "coin%i", i);
+  ht_insert(test_table, key, i);
+}
+for (int i = 0; i < 2000; i += 2) {
+  snprintf(key, sizeof(key), "coin%i", i);
+  ht_delete(test_table, key);
+}
+int found = 0;
+for (int i = 0; i < 2000; i++) {
+  snprintf(key, sizeof(key), "coin%i", i);
+  found += ht_get(test_table, key) != NULL;
+}
+printf("Found after deletes: %i\n", found);
+for (int i = 0; i < 10000; i++) {
+  snprintf(key, sizeof(key), "missing%i", i);
+  ht_get(test_table, key);
+}
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Misses rejected by the filter: %i\n",
+       stats.filtered * 100 >= stats.misses * 95);
+ht_delete_all(test_table);
+ENDTEST
+
+TEST(test_build_parallel, "Build the table from many keys with several threads")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+// Klíče bulk0 až bulk4999 se opakují, platí jejich poslední hodnota
+char (*buffers)[16] = malloc(20000 * sizeof(*buffers));
+char **keys = malloc(20000 * sizeof(char *));
+float *values = malloc(20000 * sizeof(float));
+for (int i = 0; i < 20000; i++) {
+  snprintf(buffers[i], sizeof(buffers[i]), "bulk%i", i % 15000);
+  keys[i] = buffers[i];
+  values[i] = i;
+}
+printf("Built: %i\n", ht_build_parallel(test_table, keys, values, 20000, 4));
+int correct = 0;
+for (int i = 0; i < 15000; i++) {
+  float *value = ht_get(test_table, keys[i]);
+  correct += value != NULL && *value == (i < 5000 ? i + 15000 : i);
+}
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Items: %zu, values correct: %i\n", stats.count, correct == 15000);
+ht_print_item_value(ht_get(test_table, "Terra"));
+ht_delete_all(test_table);
+free(buffers);
+free(keys);
+free(values);
+ENDTEST
+
+TEST(test_capacity, "Evict least recently used entries from a bounded table")
+ht_init(test_table);
+printf("Capacity set: %i\n", ht_set_capacity(test_table, 100));
+// Klíč cache0 se hledá po každém vložení, vyhazovat se mají ostatní
+char key[32];
+for (int i = 0; i < 1000; i++) {
+  snprintf(key, sizeof(key), "cache%i", i);
+  ht_insert(test_table, key, i);
+  ht_get(test_table, "cache0");
+}
+ht_print_item_value(ht_get(test_table, "cache0"));
+ht_print_item_value(ht_get(test_table, "cache999"));
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Items: %zu, evictions: %llu, hit ratio: %.3f\n", stats.count,
+       (unsigned long long)stats.evictions, stats.hit_ratio);
+ht_set_capacity(test_table, 10);
+ht_stats(test_table, &stats);
+printf("Items after shrinking: %zu\n", stats.count);
+ht_print_item_value(ht_get(test_table, "cache0"));
+ht_delete_all(test_table);
+#if !defined(HT_BACKEND_OA) && !defined(HT_BACKEND_CONC) &&                  \
+    !defined(HT_BACKEND_CUCKOO) && !defined(HT_BACKEND_COMPACT)
+// Vložení 53. klíče zahájí přehashování na 104 seznamů, další vložení už
+// vyhazuje a přehashování přitom posune jen o krok
+ht_set_capacity(test_table, 53);
+for (int i = 0; i < 54; i++) {
+  snprintf(key, sizeof(key), "cache%i", i);
+  ht_insert(test_table, key, i);
+}
+printf("Items: %zu, rehash still in progress: %i\n", test_table->count,
+       test_table->old_buckets != NULL);
+ht_delete_all(test_table);
+#endif
+ENDTEST
+
+#if !defined(HT_BACKEND_OA) && !defined(HT_BACKEND_CONC) &&                  \
+    !defined(HT_BACKEND_CUCKOO) && !defined(HT_BACKEND_COMPACT)
+
+TEST(test_snapshot, "Save the table, map it back and promote it on write")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+const char *path = "test_snapshot.tmp";
+printf("Saved: %i\n", ht_save(test_table, path));
+ht_delete_all(test_table);
+printf("Mapped: %i\n", ht_open_mmap(test_table, path));
+ht_print_item_value(ht_get(test_table, "Ethereum"));
+ht_print_item(ht_search(test_table, "Terra"));
+ht_print_item(ht_search(test_table, "Monero"));
+ht_print_table(test_table);
+// Namapovaný obraz lze uložit do souboru, ze kterého pochází
+printf("Saved over itself: %i\n", ht_save(test_table, path));
+ht_print_item_value(ht_get(test_table, "Ethereum"));
+// První zápis převede obraz na běžnou tabulku
+ht_insert(test_table, "Monero", 250.12);
+ht_delete(test_table, "Tether");
+printf("Promoted: %i\n", test_table->image == NULL);
+ht_print_item_value(ht_get(test_table, "Ethereum"));
+// Obraz s poškozeným posunem seznamu se odmítne a tabulka zůstane
+ht_save(test_table, path);
+FILE *file = fopen(path, "r+b");
+uint64_t offset = UINT64_MAX;
+fseek(file, offsetof(ht_image_t, buckets) + sizeof(uint64_t), SEEK_SET);
+fwrite(&offset, sizeof(offset), 1, file);
+fclose(file);
+printf("Corrupted mapped: %i\n", ht_open_mmap(test_table, path));
+ht_print_item_value(ht_get(test_table, "Ethereum"));
+remove(path);
+ENDTEST
+
+TEST(test_freeze, "Freeze the table into a minimal perfect hash and thaw it")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+printf("Frozen: %i\n", ht_freeze(test_table));
+ht_print_item_value(ht_get(test_table, "Ethereum"));
+ht_print_item(ht_search(test_table, "Terra"));
+ht_print_item(ht_search(test_table, "Monero"));
+ht_print_table(test_table);
+// První změna tabulku rozmrazí
+ht_insert(test_table, "Monero", 250.12);
+printf("Thawed: %i\n", test_table->frozen == NULL);
+ht_print_item_value(ht_get(test_table, "Terra"));
+ENDTEST
+
+#endif
+
+#ifdef HT_BACKEND_CONC
+
+#define CONC_THREADS 4
+#define CONC_KEYS 3000
+
+// Vlákno souběžného testu: vlastní klíče t<id>-<i> a počet chyb
+typedef struct {
+  ht_table_t *table;
+  int id;
+  int errors;
+} conc_worker_t;
+
+/*
+ * Vloží své klíče, přepíše je, smaže liché a mezitím čte klíče ostatních
+ * vláken. Čtený prvek musí mít hodnotu, kterou mu dalo jeho vlákno.
+ */
+static void *conc_worker(void *context) {
+  conc_worker_t *worker = context;
+  char key[32];
+  for (int i = 0; i < CONC_KEYS; i++) {
+    snprintf(key, sizeof(key), "t%i-%i", worker->id, i);
+    ht_insert(worker->table, key, i);
+    ht_insert(worker->table, key, i + 0.5f);
+
+    snprintf(key, sizeof(key), "t%i-%i", (worker->id + 1) % CONC_THREADS, i);
+    ht_read_lock();
+    float *value = ht_get(worker->table, key);
+    if (value != NULL && *value != i && *value != i + 0.5f) {
+      worker->errors++;
+    }
+    ht_read_unlock();
+
+    if (i % 2 == 1) {
+      snprintf(key, sizeof(key), "t%i-%i", worker->id, i);
+      ht_delete(worker->table, key);
+    }
+  }
+  return NULL;
+}
+
+TEST(test_concurrent, "Insert, delete and read from several threads at once")
+ht_init(test_table);
+// Malé počáteční pole, aby se během testu několikrát zvětšilo
+pthread_t threads[CONC_THREADS];
+conc_worker_t workers[CONC_THREADS];
+for (int t = 0; t < CONC_THREADS; t++) {
+  workers[t] = (conc_worker_t){test_table, t, 0};
+  pthread_create(&threads[t], NULL, conc_worker, &workers[t]);
+}
+int errors = 0;
+for (int t = 0; t < CONC_THREADS; t++) {
+  pthread_join(threads[t], NULL);
+  errors += workers[t].errors;
+}
+// Zůstanou přesně sudé klíče každého vlákna s přepsanou hodnotou
+int correct = 0;
+char key[32];
+for (int t = 0; t < CONC_THREADS; t++) {
+  for (int i = 0; i < CONC_KEYS; i++) {
+    snprintf(key, sizeof(key), "t%i-%i", t, i);
+    float *value = ht_get(test_table, key);
+    correct += i % 2 == 0 ? value != NULL && *value == i + 0.5f
+                          : value == NULL;
+  }
+}
+ht_stats_t stats;
+ht_stats(test_table, &stats);
+printf("Items: %zu, contents correct: %i, read errors: %i\n", stats.count,
+       correct == CONC_THREADS * CONC_KEYS, errors);
+printf("Resized: %i\n", stats.size > test_table->min_size);
+ht_delete_all(test_table);
+ENDTEST
+
+#endif
+
+#ifdef HT_BACKEND_COMPACT
+
+TEST(test_values, "Scale, aggregate and filter all values at once")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+printf("Sum: %.2f, min: %.2f, max: %.2f\n", ht_values_sum(test_table),
+       ht_values_min(test_table), ht_values_max(test_table));
+// Ceny v tisících, oříznuté na <0.001, 50>
+ht_values_map(test_table, 0.001f, 0, 0.001f, 50);
+ht_print_item_value(ht_get(test_table, "Bitcoin"));
+ht_print_item_value(ht_get(test_table, "Ethereum"));
+// Smažou se prvky s cenou pod 20
+printf("Deleted: %zu\n", ht_values_filter(test_table, 0.02f, INFINITY));
+ht_print_item_value(ht_get(test_table, "Tether"));
+ht_print_item_value(ht_get(test_table, "Terra"));
+// Všechny úrovně vektorových instrukcí dávají stejné výsledky (délka pole
+// není násobkem osmi, aby se prošel i skalární zbytek)
+float values[1003], mapped[3][1003];
+double sums[3];
+float mins[3], maxs[3];
+uint8_t keep[3][(1003 + 7) / 8];
+size_t kept[3];
+for (int i = 0; i < 1003; i++) {
+  values[i] = (float)(i * 37 % 1001) - 500;
+}
+for (int level = HT_SIMD_SCALAR; level <= HT_SIMD_AVX2; level++) {
+  HT_SIMD_LEVEL = level;
+  sums[level] = ht_floats_sum(values, 1003);
+  float saved = values[500];
+  values[500] = NAN;
+  mins[level] = ht_floats_min(values, 1003);
+  maxs[level] = ht_floats_max(values, 1003);
+  kept[level] = ht_floats_select(values, 1003, -100, 100, keep[level]);
+  memcpy(mapped[level], values, sizeof(values));
+  ht_floats_map(mapped[level], 1003, 2, 1, -50, 50);
+  values[500] = saved;
+}
+HT_SIMD_LEVEL = HT_SIMD_AVX2;
+bool same = true;
+for (int level = HT_SIMD_SSE2; level <= HT_SIMD_AVX2; level++) {
+  same = same && sums[level] == sums[0] && mins[level] == mins[0] &&
+         maxs[level] == maxs[0] && kept[level] == kept[0] &&
+         memcmp(keep[level], keep[0], sizeof(keep[0])) == 0 &&
+         memcmp(mapped[level], mapped[0], sizeof(mapped[0])) == 0;
+}
+printf("Sum: %.0f, min: %.0f, max: %.0f, selected: %zu\n", sums[0], mins[0],
+       maxs[0], kept[0]);
+printf("SIMD levels agree: %i\n", same);
+ENDTEST
+
+#endif
+
+void test_typed_tables() {
+  printf("[test_typed_tables] Tables generated by HTDEC/HTDEF\n");
+
+  ht_u64_t numbers;
+  ht_u64_init(&numbers);
+  for (uint64_t i = 0; i < 1000; i++) {
+    ht_u64_insert(&numbers, i * 7919, (float)i);
+  }
+  for (uint64_t i = 0; i < 1000; i += 2) {
+    ht_u64_delete(&numbers, i * 7919);
+  }
+  int found = 0;
+  for (uint64_t i = 0; i < 1000; i++) {
+    float *value = ht_u64_get(&numbers, i * 7919);
+    if (value != NULL && *value == i && i % 2 == 1) {
+      found++;
+    }
+  }
+  printf("Integer keys: count %zu, found %i, size %zu\n", numbers.count, found,
+         numbers.size);
+  ht_u64_delete_all(&numbers);
+
+  ht_coin_t coins;
+  ht_coin_init(&coins);
+  int count = sizeof(TEST_DATA) / sizeof(TEST_DATA[0]);
+  for (int i = 0; i < count; i++) {
+    ht_coin_insert(&coins, TEST_DATA[i].key,
+                   (coin_t){TEST_DATA[i].value, i + 1});
+  }
+  coin_t *coin = ht_coin_get(&coins, "Terra");
+  printf("Terra: %.2f, rank %i\n", coin->price, coin->rank);
+  printf("Monero: %s\n", ht_coin_get(&coins, "Monero") == NULL ? "NULL" : "?");
+  ht_coin_delete_all(&coins);
+
+  ht_flood_t flood;
+  ht_flood_init(&flood);
+  for (uint64_t i = 0; i < 2000; i++) {
+    ht_flood_insert(&flood, i, (float)i);
+  }
+  found = 0;
+  for (uint64_t i = 0; i < 2000; i++) {
+    float *value = ht_flood_get(&flood, i);
+    found += value != NULL && *value == i;
+  }
+  printf("Colliding keys: found %i, reseeded %i\n", found, flood.seed != 0);
+  ht_flood_delete_all(&flood);
+  printf("\n");
+}
+
+void test_string_pool() {
+  printf("[test_string_pool] Tables keyed by IDs from a shared string pool\n");
+
+  ht_pool_t pool;
+  ht_pool_init(&pool);
+  ht_price_t prices;
+  ht_rank_t ranks;
+  ht_price_init(&prices);
+  ht_rank_init(&ranks);
+
+  // Obě tabulky vloží stejné klíče, fond je uloží jen jednou; tabulky
+  // drží vlastní reference, referenci z ht_pool_intern hned uvolníme
+  int count = sizeof(TEST_DATA) / sizeof(TEST_DATA[0]);
+  int shared = 0;
+  for (int i = 0; i < count; i++) {
+    const char *key = TEST_DATA[i].key;
+    uint32_t id = ht_pool_intern(&pool, key, strlen(key));
+    ht_price_insert_id(&prices, &pool, id, TEST_DATA[i].value);
+    ht_rank_insert_id(&ranks, &pool, id, i + 1);
+    // Přepsání hodnoty referenci nepřidá
+    ht_rank_insert_id(&ranks, &pool, id, i + 1);
+    ht_pool_release(&pool, id);
+    shared += pool.entries[id].refs == 2;
+  }
+  printf("Shared IDs: %i, strings: %u\n", shared, pool.count);
+
+  uint32_t id = ht_pool_find(&pool, "Terra", 5);
+  printf("Terra: %.2f, rank %i\n", *ht_price_get(&prices, id),
+         *ht_rank_get(&ranks, id));
+  printf("Monero: %s\n",
+         ht_pool_find(&pool, "Monero", 6) == HT_POOL_NONE ? "NONE" : "?");
+
+  // Smazání z jedné tabulky řetězec ve fondu ponechá
+  id = ht_pool_find(&pool, "Bitcoin", 7);
+  ht_rank_delete_id(&ranks, &pool, id);
+  printf("Bitcoin after one release: %s\n", ht_pool_key(&pool, id));
+
+  // Vkládání a mazání mnoha krátkodobých klíčů zanechá mrtvé bajty
+  char name[32];
+  for (int i = 0; i < 10000; i++) {
+    int length = snprintf(name, sizeof(name), "temporary key %i", i);
+    id = ht_pool_intern(&pool, name, length);
+    ht_price_insert_id(&prices, &pool, id, i);
+    ht_pool_release(&pool, id);
+  }
+  for (int i = 0; i < 10000; i++) {
+    int length = snprintf(name, sizeof(name), "temporary key %i", i);
+    id = ht_pool_find(&pool, name, length);
+    ht_price_delete_id(&prices, &pool, id);
+  }
+  ht_arena_stats_t stats;
+  ht_pool_stats(&pool, &stats);
+  size_t reserved = stats.reserved;
+  printf("Strings: %u, dead bytes: %s\n", pool.count,
+         stats.free > stats.live ? "most" : "few");
+
+  // Zhuštění uvolní mrtvé bajty, ID i hodnoty v tabulkách zůstanou
+  ht_pool_compact(&pool);
+  ht_pool_stats(&pool, &stats);
+  int found = 0;
+  for (int i = 0; i < count; i++) {
+    const char *key = TEST_DATA[i].key;
+    id = ht_pool_find(&pool, key, strlen(key));
+    float *price = ht_price_get(&prices, id);
+    if (id != HT_POOL_NONE && strcmp(ht_pool_key(&pool, id), key) == 0 &&
+        price != NULL && *price == TEST_DATA[i].value) {
+      found++;
+    }
+  }
+  printf("After compaction: found %i, dead bytes %zu, reserved %s\n", found,
+         stats.free, stats.reserved < reserved ? "shrunk" : "same");
+
+  // Hromadné smazání tabulek uvolní všechny jejich reference
+  ht_price_delete_all_ids(&prices, &pool);
+  ht_rank_delete_all_ids(&ranks, &pool);
+  printf("After clearing the tables: strings %u\n", pool.count);
+  ht_pool_free(&pool);
+  printf("After bulk free: strings %u, reserved %zu\n", pool.count,
+         pool.reserved);
+  printf("\n");
+}
+
+// Výpis prvku stromu při procházení
+static bool print_art_item(const char *key, size_t length, float value,
+                           void *context) {
+  (void)length;
+  (void)context;
+  printf("(%s,%.2f)", key, value);
+  return true;
+}
+
+// Kontrola, že procházení stromu vrací klíče vzestupně
+typedef struct {
+  char previous[32];
+  bool ordered;
+} art_order_t;
+
+static bool check_art_order(const char *key, size_t length, float value,
+                            void *context) {
+  (void)value;
+  art_order_t *order = context;
+  if (order->previous[0] != '\0' && strcmp(order->previous, key) >= 0) {
+    order->ordered = false;
+  }
+  memcpy(order->previous, key, length + 1);
+  return true;
+}
+
+void test_art() {
+  printf("[test_art] Ordered index: prefix scans and range iteration\n");
+
+  ht_art_t tree;
+  ht_art_init(&tree);
+  int count = sizeof(TEST_DATA) / sizeof(TEST_DATA[0]);
+  for (int i = 0; i < count; i++) {
+    ht_art_insert(&tree, TEST_DATA[i].key, TEST_DATA[i].value);
+  }
+  float *value = ht_art_get(&tree, "Terra");
+  printf("Items: %zu, Terra: %.2f, Monero: %s\n", tree.count,
+         value != NULL ? *value : 0,
+         ht_art_get(&tree, "Monero") != NULL ? "?" : "NULL");
+
+  // Klíče vzestupně, klíče z intervalu a klíče s prefixem
+  ht_art_scan_range(&tree, NULL, NULL, print_art_item, NULL);
+  printf("\n");
+  size_t visited = ht_art_scan_range(&tree, "C", "P", print_art_item, NULL);
+  printf("\nRange <C, P): %zu\n", visited);
+  ht_art_insert(&tree, "Terra Classic", 0.0001);
+  ht_art_insert(&tree, "Terra/Luna", 0.52);
+  visited = ht_art_scan_prefix(&tree, "Terra", print_art_item, NULL);
+  printf("\nPrefix Terra: %zu\n", visited);
+  ht_art_delete(&tree, "Terra");
+  visited = ht_art_scan_prefix(&tree, "Terra", print_art_item, NULL);
+  printf("\nAfter deleting Terra: %zu, deleted again: %i\n", visited,
+         ht_art_delete(&tree, "Terra"));
+  ht_art_delete_all(&tree);
+
+  // Hierarchické klíče se širokým větvením (uzly všech velikostí)
+  char key[32];
+  for (int i = 0; i < 20000; i++) {
+    snprintf(key, sizeof(key), "%c/%c/%i", 33 + i % 94, 33 + i / 94 % 94, i);
+    ht_art_insert(&tree, key, i);
+  }
+  int correct = 0;
+  for (int i = 0; i < 20000; i++) {
+    snprintf(key, sizeof(key), "%c/%c/%i", 33 + i % 94, 33 + i / 94 % 94, i);
+    value = ht_art_get(&tree, key);
+    correct += value != NULL && *value == i;
+  }
+  art_order_t order = {"", true};
+  visited = ht_art_scan_range(&tree, NULL, NULL, check_art_order, &order);
+  printf("Items: %zu, values correct: %i, ordered: %zu %i\n", tree.count,
+         correct == 20000, visited, order.ordered);
+  order = (art_order_t){"", true};
+  size_t prefixed = ht_art_scan_prefix(&tree, "A/", check_art_order, &order);
+  order = (art_order_t){"", true};
+  visited = ht_art_scan_range(&tree, "A/", "B/", check_art_order, &order);
+  printf("Prefix A/: %zu, range <A/, B/): %zu\n", prefixed, visited);
+
+  // Mazání uzly zmenšuje a spojuje, prázdný strom nezabírá nic
+  for (int i = 0; i < 20000; i += 2) {
+    snprintf(key, sizeof(key), "%c/%c/%i", 33 + i % 94, 33 + i / 94 % 94, i);
+    ht_art_delete(&tree, key);
+  }
+  correct = 0;
+  for (int i = 0; i < 20000; i++) {
+    snprintf(key, sizeof(key), "%c/%c/%i", 33 + i % 94, 33 + i / 94 % 94, i);
+    correct += (ht_art_get(&tree, key) != NULL) == (i % 2 == 1);
+  }
+  order = (art_order_t){"", true};
+  ht_art_scan_range(&tree, NULL, NULL, check_art_order, &order);
+  printf("After deleting half: %zu, lookups correct: %i, ordered: %i\n",
+         tree.count, correct == 20000, order.ordered);
+  for (int i = 1; i < 20000; i += 2) {
+    snprintf(key, sizeof(key), "%c/%c/%i", 33 + i % 94, 33 + i / 94 % 94, i);
+    ht_art_delete(&tree, key);
+  }
+  printf("After deleting all: %zu items, %zu bytes\n", tree.count, tree.bytes);
+  ht_art_delete_all(&tree);
+  printf("\n");
+}
+
 int main(int argc, char *argv[]) {
   init_uninitialized_item();
   init_test();
@@ -90,6 +801,31 @@ int main(int argc, char *argv[]) {
   test_get();
   test_delete();
   test_delete_all();
+  test_resize();
+  test_hash_distribution();
+  test_alloc_stats();
+  test_get_many();
+  test_upsert();
+  test_key_slices();
+  test_stats();
+  test_hash_flooding();
+  test_filter();
+  test_build_parallel();
+  test_capacity();
+  test_typed_tables();
+  test_string_pool();
+  test_art();
+#if !defined(HT_BACKEND_OA) && !defined(HT_BACKEND_CONC) &&                  \
+    !defined(HT_BACKEND_CUCKOO) && !defined(HT_BACKEND_COMPACT)
+  test_snapshot();
+  test_freeze();
+#endif
+#ifdef HT_BACKEND_CONC
+  test_concurrent();
+#endif
+#ifdef HT_BACKEND_COMPACT
+  test_values();
+#endif
 
   free(uninitialized_item);
 }
@@ -1,7 +1,12 @@
 #include "test_util.h"
 #include "hashtable.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Délky seznamů synonym od CHAIN_HISTOGRAM_MAX výše se sčítají dohromady
+#define CHAIN_HISTOGRAM_MAX 8
 
 ht_item_t *uninitialized_item;
 
@@ -21,15 +26,308 @@ void ht_print_item(ht_item_t *item) {
   }
 }
 
+#if !defined(HT_BACKEND_OA) && !defined(HT_BACKEND_CUCKOO)
+
+typedef struct {
+  size_t chains[CHAIN_HISTOGRAM_MAX + 1]; // počet indexů s danou délkou seznamu
+  size_t buckets;                         // počet započtených indexů
+  size_t items;                           // počet započtených prvků
+  size_t longest;                         // nejdelší seznam synonym
+} chain_stats_t;
+
+/*
+ * Vypíše rozložení délek seznamů synonym bez výpisu jednotlivých prvků
+ * a porovná ho s očekávaným rozložením pro ideální rozptylovací funkci
+ * (Poissonovo rozdělení se střední hodnotou rovnou faktoru naplnění).
+ */
+static void ht_print_chain_stats(const chain_stats_t *stats) {
+  double load = stats->buckets == 0 ? 0 : (double)stats->items / stats->buckets;
+  printf("------------CHAIN REPORT------------\n");
+  printf("Buckets: %zu, items: %zu, load factor: %.2f\n", stats->buckets,
+         stats->items, load);
+  printf("Longest chain: %zu\n", stats->longest);
+  printf("Maximum hash collisions: %zu\n",
+         stats->longest == 0 ? 0 : stats->longest - 1);
+  printf("length  buckets  expected\n");
+
+  double probability = exp(-load);
+  double remaining = 1;
+  for (int length = 0; length <= CHAIN_HISTOGRAM_MAX; length++) {
+    double expected = length < CHAIN_HISTOGRAM_MAX ? probability : remaining;
+    printf("%i%-5s  %-7zu  %.1f\n", length,
+           length < CHAIN_HISTOGRAM_MAX ? "" : "+", stats->chains[length],
+           expected * stats->buckets);
+    remaining -= probability;
+    probability *= load / (length + 1);
+  }
+  printf("------------------------------------\n");
+}
+
+// Započte seznam synonym délky length do statistik
+static void ht_count_chain(chain_stats_t *stats, size_t length) {
+  stats->chains[length < CHAIN_HISTOGRAM_MAX ? length : CHAIN_HISTOGRAM_MAX]++;
+  stats->buckets++;
+  stats->items += length;
+  if (length > stats->longest) {
+    stats->longest = length;
+  }
+}
+
+#endif
+
+#ifdef HT_BACKEND_OA
+
+/*
+ * Počet skupin, které musí vyhledání klíče na daném místě projít
+ * (1 = klíč leží ve své domovské skupině).
+ */
+static size_t ht_probe_length(ht_table_t *table, size_t slot) {
+  char *key = table->items[slot].key;
+  uint64_t hash = ht_hash_bytes(key, strlen(key), table->seed);
+  size_t group_mask = table->size / HT_GROUP_SIZE - 1;
+  size_t group = (size_t)(hash >> 7) & group_mask;
+  size_t length = 1;
+  for (size_t step = 1; group != slot / HT_GROUP_SIZE; step++) {
+    group = (group + step) & group_mask;
+    length++;
+  }
+  return length;
+}
+
+void ht_print_table(ht_table_t *table) {
+  size_t max_length = 0;
+  int sum_count = 0;
+
+  printf("------------HASH TABLE--------------\n");
+  for (size_t i = 0; i < table->size; i++) {
+    printf("%zu: ", i);
+    if (table->ctrl[i] == HT_CTRL_DELETED) {
+      printf("<deleted>");
+    } else if (table->ctrl[i] != HT_CTRL_EMPTY) {
+      ht_item_t *item = &table->items[i];
+      printf("(%s,%.2f)", item->key, item->value);
+      if (item != uninitialized_item) {
+        size_t length = ht_probe_length(table, i);
+        if (length > max_length) {
+          max_length = length;
+        }
+        sum_count++;
+      }
+    }
+    printf("\n");
+  }
+
+  printf("------------------------------------\n");
+  printf("Total items in hash table: %i\n", sum_count);
+  printf("Table size: %zu\n", table->size);
+  printf("Maximum hash collisions: %zu\n", max_length == 0 ? 0 : max_length - 1);
+  printf("------------------------------------\n");
+}
+
+/*
+ * Vypíše rozložení délek zkoušení (počtu prošlých skupin) uložených klíčů
+ * bez výpisu jednotlivých prvků.
+ */
+void ht_print_chain_report(ht_table_t *table) {
+  size_t probes[CHAIN_HISTOGRAM_MAX + 1] = {0};
+  size_t longest = 0;
+
+  for (size_t i = 0; i < table->size; i++) {
+    if (!(table->ctrl[i] & 0x80)) {
+      size_t length = ht_probe_length(table, i);
+      probes[length < CHAIN_HISTOGRAM_MAX ? length : CHAIN_HISTOGRAM_MAX]++;
+      if (length > longest) {
+        longest = length;
+      }
+    }
+  }
+
+  printf("------------PROBE REPORT------------\n");
+  printf("Slots: %zu, items: %zu, deleted: %zu, load factor: %.2f\n",
+         table->size, table->count, table->deleted,
+         table->size == 0 ? 0 : (double)table->count / table->size);
+  printf("Longest probe: %zu groups\n", longest);
+  printf("Maximum hash collisions: %zu\n", longest == 0 ? 0 : longest - 1);
+  printf("groups  items\n");
+  for (int length = 1; length <= CHAIN_HISTOGRAM_MAX; length++) {
+    printf("%i%-5s  %zu\n", length, length < CHAIN_HISTOGRAM_MAX ? "" : "+",
+           probes[length]);
+  }
+  printf("------------------------------------\n");
+}
+
+#elif defined(HT_BACKEND_CUCKOO)
+
+void ht_print_table(ht_table_t *table) {
+  int sum_count = 0;
+  int second_count = 0;
+
+  printf("------------HASH TABLE--------------\n");
+  for (size_t i = 0; i < table->size; i++) {
+    printf("%zu: ", i);
+    for (int slot = 0; slot < HT_BUCKET_SLOTS; slot++) {
+      ht_item_t *item = &table->buckets[i].slots[slot];
+      if (item->key == NULL) {
+        continue;
+      }
+      printf("(%s,%.2f)", item->key, item->value);
+      if (item->key != uninitialized_item->key) {
+        uint64_t hash =
+            ht_hash_bytes(item->key, strlen(item->key), table->seed);
+        second_count += ((size_t)(hash >> 32) & (table->size - 1)) != i;
+        sum_count++;
+      }
+    }
+    printf("\n");
+  }
+
+  printf("------------------------------------\n");
+  printf("Total items in hash table: %i\n", sum_count);
+  printf("Table size: %zu\n", table->size);
+  printf("Items in their second bucket: %i\n", second_count);
+  printf("------------------------------------\n");
+}
+
+/*
+ * Vypíše rozložení obsazenosti košů a počet prvků, které vytlačování
+ * přesunulo do jejich druhého koše, bez výpisu jednotlivých prvků.
+ */
+void ht_print_chain_report(ht_table_t *table) {
+  size_t occupancy[HT_BUCKET_SLOTS + 1] = {0};
+  size_t second = 0;
+
+  for (size_t i = 0; i < table->size; i++) {
+    int used = 0;
+    for (int slot = 0; slot < HT_BUCKET_SLOTS; slot++) {
+      char *key = table->buckets[i].slots[slot].key;
+      if (key != NULL) {
+        uint64_t hash = ht_hash_bytes(key, strlen(key), table->seed);
+        second += ((size_t)(hash >> 32) & (table->size - 1)) != i;
+        used++;
+      }
+    }
+    occupancy[used]++;
+  }
+
+  printf("------------BUCKET REPORT-----------\n");
+  printf("Buckets: %zu, items: %zu, load factor: %.2f\n", table->size,
+         table->count,
+         table->size == 0
+             ? 0
+             : (double)table->count / (table->size * HT_BUCKET_SLOTS));
+  printf("Items in their second bucket: %zu\n", second);
+  printf("items   buckets\n");
+  for (int used = 0; used <= HT_BUCKET_SLOTS; used++) {
+    printf("%-6i  %zu\n", used, occupancy[used]);
+  }
+  printf("------------------------------------\n");
+}
+
+#elif defined(HT_BACKEND_COMPACT)
+
+// Uzel a hodnota s kopií uninitialized_item, kterými začíná testovací
+// tabulka
+static ht_node_t uninitialized_node;
+static float uninitialized_value;
+
+void ht_print_table(ht_table_t *table) {
+  int max_count = 0;
+  int sum_count = 0;
+
+  printf("------------HASH TABLE--------------\n");
+  for (size_t i = 0; table->buckets != NULL && i < table->size; i++) {
+    printf("%zu: ", i);
+    int count = 0;
+    for (uint32_t index = table->buckets[i]; index != HT_NIL;
+         index = table->nodes[index].next) {
+      ht_node_t *node = &table->nodes[index];
+      printf("(%s,%.2f)", table->keys + node->key + sizeof(uint32_t),
+             table->values[index]);
+      if (node != &uninitialized_node) {
+        count++;
+      }
+    }
+    printf("\n");
+    if (count > max_count) {
+      max_count = count;
+    }
+    sum_count += count;
+  }
+
+  printf("------------------------------------\n");
+  printf("Total items in hash table: %i\n", sum_count);
+  printf("Table size: %zu\n", table->size);
+  printf("Maximum hash collisions: %i\n", max_count == 0 ? 0 : max_count - 1);
+  printf("------------------------------------\n");
+}
+
+void ht_print_chain_report(ht_table_t *table) {
+  chain_stats_t stats = {{0}, 0, 0, 0};
+  for (size_t i = 0; table->buckets != NULL && i < table->size; i++) {
+    size_t length = 0;
+    for (uint32_t index = table->buckets[i]; index != HT_NIL;
+         index = table->nodes[index].next) {
+      length++;
+    }
+    ht_count_chain(&stats, length);
+  }
+  ht_print_chain_stats(&stats);
+}
+
+#elif defined(HT_BACKEND_CONC)
+
 void ht_print_table(ht_table_t *table) {
   int max_count = 0;
   int sum_count = 0;
+  ht_buckets_t *buckets = atomic_load(&table->buckets);
+  size_t size = buckets != NULL ? buckets->size : 0;
 
   printf("------------HASH TABLE--------------\n");
-  for (int i = 0; i < HT_SIZE; i++) {
-    printf("%i: ", i);
+  for (size_t i = 0; i < size; i++) {
+    printf("%zu: ", i);
+    int count = 0;
+    for (ht_item_t *item = atomic_load(&buckets->heads[i]); item != NULL;
+         item = atomic_load(&item->next)) {
+      printf("(%s,%.2f)", item->key, item->value);
+      count++;
+    }
+    printf("\n");
+    if (count > max_count) {
+      max_count = count;
+    }
+    sum_count += count;
+  }
+
+  printf("------------------------------------\n");
+  printf("Total items in hash table: %i\n", sum_count);
+  printf("Table size: %zu\n", size);
+  printf("Maximum hash collisions: %i\n", max_count == 0 ? 0 : max_count - 1);
+  printf("------------------------------------\n");
+}
+
+void ht_print_chain_report(ht_table_t *table) {
+  chain_stats_t stats = {{0}, 0, 0, 0};
+  ht_buckets_t *buckets = atomic_load(&table->buckets);
+  for (size_t i = 0; buckets != NULL && i < buckets->size; i++) {
+    size_t length = 0;
+    for (ht_item_t *item = atomic_load(&buckets->heads[i]); item != NULL;
+         item = atomic_load(&item->next)) {
+      length++;
+    }
+    ht_count_chain(&stats, length);
+  }
+  ht_print_chain_stats(&stats);
+}
+
+#else
+
+static void ht_print_items(ht_bucket_t *buckets, size_t size, size_t from,
+                           const char *prefix, int *max_count,
+                           int *sum_count) {
+  for (size_t i = from; i < size; i++) {
+    printf("%s%zu: ", prefix, i);
     int count = 0;
-    ht_item_t *item = (*table)[i];
+    ht_item_t *item = buckets[i].head;
     while (item != NULL) {
       printf("(%s,%.2f)", item->key, item->value);
       if (item != uninitialized_item) {
@@ -38,34 +336,226 @@ void ht_print_table(ht_table_t *table) {
       item = item->next;
     }
     printf("\n");
-    if (count > max_count) {
-      max_count = count;
+    if (count > *max_count) {
+      *max_count = count;
     }
-    sum_count += count;
+    *sum_count += count;
+  }
+}
+
+/*
+ * Výpis seznamů synonym namapovaného obrazu tabulky.
+ */
+static void ht_print_image(ht_image_t *image, int *max_count,
+                           int *sum_count) {
+  for (size_t i = 0; i < image->size; i++) {
+    printf("%zu: ", i);
+    int count = 0;
+    char *record = (char *)image + image->buckets[i];
+    while (record < (char *)image + image->buckets[i + 1]) {
+      ht_item_t *item = (ht_item_t *)record;
+      printf("(%s,%.2f)", (char *)(item + 1), item->value);
+      count++;
+      size_t length = sizeof(ht_item_t) + item->length + 1;
+      record += (length + HT_IMAGE_ALIGN - 1) & ~(size_t)(HT_IMAGE_ALIGN - 1);
+    }
+    printf("\n");
+    if (count > *max_count) {
+      *max_count = count;
+    }
+    *sum_count += count;
+  }
+}
+
+void ht_print_table(ht_table_t *table) {
+  int max_count = 0;
+  int sum_count = 0;
+
+  printf("------------HASH TABLE--------------\n");
+  if (table->image != NULL) {
+    printf("---------mapped snapshot------------\n");
+    ht_print_image(table->image, &max_count, &sum_count);
+  }
+  if (table->frozen != NULL) {
+    printf("---------frozen (one key per slot)--\n");
+    ht_frozen_t *frozen = table->frozen;
+    for (size_t slot = 0; slot < frozen->count; slot++) {
+      printf("%zu: (%s,%.2f)\n", slot,
+             frozen->keys + frozen->key_offsets[slot], frozen->values[slot]);
+    }
+    max_count = frozen->count > 0 ? 1 : 0;
+    sum_count += (int)frozen->count;
+  }
+  ht_print_items(table->buckets, table->buckets != NULL ? table->size : 0, 0,
+                 "", &max_count, &sum_count);
+  if (table->old_buckets != NULL) {
+    printf("---------rehashing (old array)------\n");
+    ht_print_items(table->old_buckets, table->old_size, table->rehash_index,
+                   "old ", &max_count, &sum_count);
   }
 
   printf("------------------------------------\n");
   printf("Total items in hash table: %i\n", sum_count);
+  printf("Table size: %zu\n", table->size);
   printf("Maximum hash collisions: %i\n", max_count == 0 ? 0 : max_count - 1);
   printf("------------------------------------\n");
 }
 
+static void ht_count_chains(ht_bucket_t *buckets, size_t size, size_t from,
+                            chain_stats_t *stats) {
+  for (size_t i = from; i < size; i++) {
+    size_t length = 0;
+    for (ht_item_t *item = buckets[i].head; item != NULL; item = item->next) {
+      length++;
+    }
+    ht_count_chain(stats, length);
+  }
+}
+
+void ht_print_chain_report(ht_table_t *table) {
+  chain_stats_t stats = {{0}, 0, 0, 0};
+  ht_count_chains(table->buckets, table->size, 0, &stats);
+  if (table->old_buckets != NULL) {
+    ht_count_chains(table->old_buckets, table->old_size, table->rehash_index,
+                    &stats);
+  }
+  ht_print_chain_stats(&stats);
+}
+
+#endif
+
+void ht_print_alloc_stats(ht_table_t *table) {
+  ht_arena_stats_t stats;
+  ht_alloc_stats(table, &stats);
+  printf("Allocator: reserved %zu B, live %zu B, free %zu B, "
+         "fragmentation %.1f %%\n",
+         stats.reserved, stats.live, stats.free, stats.fragmentation * 100);
+}
+
 void init_uninitialized_item() {
   uninitialized_item = (ht_item_t *)malloc(sizeof(ht_item_t));
   uninitialized_item->key = "*UNINITIALIZED*";
   uninitialized_item->value = -1;
+#if !defined(HT_BACKEND_OA) && !defined(HT_BACKEND_CONC) &&                  \
+    !defined(HT_BACKEND_CUCKOO) && !defined(HT_BACKEND_COMPACT)
   uninitialized_item->next = NULL;
+#endif
 }
 
+#ifdef HT_BACKEND_OA
+
 void init_test_table(ht_table_t **table) {
+  static uint8_t uninitialized_ctrl[1] = {0};
+
   (*table) = (ht_table_t *)malloc(sizeof(ht_table_t));
-  for (int i = 0; i < MAX_HT_SIZE; i++) {
-    (**table)[i] = uninitialized_item;
-  };
+  (*table)->ctrl = uninitialized_ctrl;
+  (*table)->items = uninitialized_item;
+  (*table)->size = 1;
+  (*table)->count = 0;
+  (*table)->deleted = 0;
+  (*table)->min_size = 0;
+  (*table)->capacity = 0;
+  (*table)->clock_hand = 0;
+  (*table)->seed = 0;
+  ht_filter_init(&(*table)->filter);
+#if HT_STATS
+  memset(&(*table)->stats, 0, sizeof((*table)->stats));
+#endif
 }
 
-void ht_insert_many(ht_table_t *table, const ht_item_t items[], int count) {
-  for (int i = 0; i < count; i++) {
-    ht_insert(table, items[i].key, items[i].value);
-  }
+#elif defined(HT_BACKEND_CUCKOO)
+
+void init_test_table(ht_table_t **table) {
+  static ht_bucket_t uninitialized_bucket;
+
+  uninitialized_bucket.slots[0] = *uninitialized_item;
+  (*table) = (ht_table_t *)malloc(sizeof(ht_table_t));
+  (*table)->buckets = &uninitialized_bucket;
+  (*table)->size = 1;
+  (*table)->count = 0;
+  (*table)->min_size = 0;
+  (*table)->capacity = 0;
+  (*table)->clock_hand = 0;
+  (*table)->seed = 0;
+#if HT_STATS
+  memset(&(*table)->stats, 0, sizeof((*table)->stats));
+#endif
 }
+
+#elif defined(HT_BACKEND_COMPACT)
+
+void init_test_table(ht_table_t **table) {
+  static uint32_t uninitialized_bucket = 0;
+  static char uninitialized_keys[32];
+
+  // Záznam klíče: délka, bajty klíče a ukončovací znak
+  uint32_t length = (uint32_t)strlen(uninitialized_item->key);
+  memcpy(uninitialized_keys, &length, sizeof(length));
+  memcpy(uninitialized_keys + sizeof(length), uninitialized_item->key,
+         length + 1);
+  uninitialized_node.key = 0;
+  uninitialized_node.next = HT_NIL;
+  uninitialized_node.hash = 0;
+  uninitialized_node.referenced = 0;
+  uninitialized_value = uninitialized_item->value;
+
+  (*table) = (ht_table_t *)malloc(sizeof(ht_table_t));
+  (*table)->buckets = &uninitialized_bucket;
+  (*table)->size = 1;
+  (*table)->count = 0;
+  (*table)->min_size = 0;
+  (*table)->capacity = 0;
+  (*table)->clock_hand = 0;
+  (*table)->nodes = &uninitialized_node;
+  (*table)->values = &uninitialized_value;
+  (*table)->node_capacity = 1;
+  (*table)->keys = uninitialized_keys;
+  (*table)->keys_used = sizeof(uninitialized_keys);
+  (*table)->keys_capacity = sizeof(uninitialized_keys);
+  (*table)->keys_dead = 0;
+  (*table)->seed = 0;
+#if HT_STATS
+  memset(&(*table)->stats, 0, sizeof((*table)->stats));
+#endif
+}
+
+#elif defined(HT_BACKEND_CONC)
+
+void init_test_table(ht_table_t **table) {
+  (*table) = (ht_table_t *)malloc(sizeof(ht_table_t));
+  atomic_init(&(*table)->buckets, NULL);
+  atomic_init(&(*table)->size, 0);
+  atomic_init(&(*table)->count, 0);
+  (*table)->min_size = 0;
+#if HT_STATS
+  memset((*table)->stats, 0, sizeof((*table)->stats));
+#endif
+}
+
+#else
+
+void init_test_table(ht_table_t **table) {
+  static ht_bucket_t uninitialized_bucket;
+
+  uninitialized_bucket.head = uninitialized_item;
+  (*table) = (ht_table_t *)malloc(sizeof(ht_table_t));
+  (*table)->buckets = &uninitialized_bucket;
+  (*table)->size = 1;
+  (*table)->count = 0;
+  (*table)->min_size = 0;
+  (*table)->capacity = 0;
+  (*table)->clock_hand = 0;
+  (*table)->old_buckets = NULL;
+  (*table)->old_size = 0;
+  (*table)->rehash_index = 0;
+  (*table)->image = NULL;
+  (*table)->image_size = 0;
+  (*table)->frozen = NULL;
+  ht_filter_init(&(*table)->filter);
+  (*table)->threads = 1;
+#if HT_STATS
+  memset(&(*table)->stats, 0, sizeof((*table)->stats));
+#endif
+}
+
+#endif
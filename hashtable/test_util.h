@@ -22,7 +22,8 @@ extern ht_item_t *uninitialized_item;
 void ht_print_item_value(float *value);
 void ht_print_item(ht_item_t *item);
 void ht_print_table(ht_table_t *table);
-void ht_insert_many(ht_table_t *table, const ht_item_t items[], int count);
+void ht_print_chain_report(ht_table_t *table);
+void ht_print_alloc_stats(ht_table_t *table);
 
 void init_uninitialized_item();
 void init_test_table(ht_table_t **table);
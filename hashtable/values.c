@@ -0,0 +1,330 @@
+/*
+ * Hromadné operace nad hustým polem hodnot
+ *
+ * Každá operace má skalární variantu a na x86 také variantu pro SSE2
+ * (4 hodnoty najednou) a AVX2 (8 hodnot najednou). Varianta se volí za
+ * běhu podle procesoru, takže program přeložený bez -mavx2 použije AVX2
+ * tam, kde je k dispozici. Vektorové varianty zpracují zbytek pole, který
+ * nevyplní celý registr, skalárně.
+ *
+ * Všechny varianty dávají stejné výsledky: minimum a maximum ignorují NaN
+ * a ořezání v ht_floats_map i výběr v ht_floats_select se chovají k NaN
+ * stejně jako instrukce minps/maxps a cmpps. Součet se sčítá v double,
+ * varianty se tedy liší jen pořadím sčítání.
+ */
+
+#include "values.h"
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HT_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define HT_SIMD_X86 0
+#endif
+
+// Nejvyšší povolená úroveň vektorových instrukcí
+int HT_SIMD_LEVEL = HT_SIMD_AVX2;
+
+/*
+ * Úroveň, kterou operace použijí: nejvyšší podporovaná procesorem, nejvýše
+ * však HT_SIMD_LEVEL.
+ */
+int ht_simd_level(void) {
+  int level = HT_SIMD_SCALAR;
+#if HT_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    level = HT_SIMD_AVX2;
+  } else if (__builtin_cpu_supports("sse2")) {
+    level = HT_SIMD_SSE2;
+  }
+#endif
+  return level < HT_SIMD_LEVEL ? level : HT_SIMD_LEVEL;
+}
+
+/*
+ * Skalární varianty. Podmínky jsou zapsané ve stejném pořadí operandů jako
+ * vektorové instrukce, aby se shodovalo chování pro NaN.
+ */
+static void ht_map_scalar(float *values, size_t count, float scale,
+                          float offset, float min, float max) {
+  for (size_t i = 0; i < count; i++) {
+    float x = values[i] * scale + offset;
+    x = x > min ? x : min;
+    values[i] = x < max ? x : max;
+  }
+}
+
+static double ht_sum_scalar(const float *values, size_t count) {
+  double sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+static float ht_min_scalar(const float *values, size_t count, float min) {
+  for (size_t i = 0; i < count; i++) {
+    min = values[i] < min ? values[i] : min;
+  }
+  return min;
+}
+
+static float ht_max_scalar(const float *values, size_t count, float max) {
+  for (size_t i = 0; i < count; i++) {
+    max = values[i] > max ? values[i] : max;
+  }
+  return max;
+}
+
+static size_t ht_select_scalar(const float *values, size_t count, float min,
+                               float max, uint8_t *keep) {
+  size_t kept = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i % 8 == 0) {
+      keep[i / 8] = 0;
+    }
+    if (values[i] >= min && values[i] <= max) {
+      keep[i / 8] |= (uint8_t)(1u << (i % 8));
+      kept++;
+    }
+  }
+  return kept;
+}
+
+#if HT_SIMD_X86
+
+/*
+ * Varianty pro SSE2.
+ */
+__attribute__((target("sse2"))) static void
+ht_map_sse2(float *values, size_t count, float scale, float offset, float min,
+            float max) {
+  __m128 s = _mm_set1_ps(scale), o = _mm_set1_ps(offset);
+  __m128 lo = _mm_set1_ps(min), hi = _mm_set1_ps(max);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(values + i), s), o);
+    _mm_storeu_ps(values + i, _mm_min_ps(_mm_max_ps(x, lo), hi));
+  }
+  ht_map_scalar(values + i, count - i, scale, offset, min, max);
+}
+
+__attribute__((target("sse2"))) static double
+ht_sum_sse2(const float *values, size_t count) {
+  __m128d low = _mm_setzero_pd(), high = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(values + i);
+    low = _mm_add_pd(low, _mm_cvtps_pd(x));
+    high = _mm_add_pd(high, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+  return lanes[0] + lanes[1] + ht_sum_scalar(values + i, count - i);
+}
+
+__attribute__((target("sse2"))) static float
+ht_min_sse2(const float *values, size_t count) {
+  __m128 acc = _mm_set1_ps(INFINITY);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    acc = _mm_min_ps(_mm_loadu_ps(values + i), acc);
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, acc);
+  return ht_min_scalar(lanes, 4, ht_min_scalar(values + i, count - i,
+                                               INFINITY));
+}
+
+__attribute__((target("sse2"))) static float
+ht_max_sse2(const float *values, size_t count) {
+  __m128 acc = _mm_set1_ps(-INFINITY);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    acc = _mm_max_ps(_mm_loadu_ps(values + i), acc);
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, acc);
+  return ht_max_scalar(lanes, 4, ht_max_scalar(values + i, count - i,
+                                               -INFINITY));
+}
+
+__attribute__((target("sse2"))) static size_t
+ht_select_sse2(const float *values, size_t count, float min, float max,
+               uint8_t *keep) {
+  __m128 lo = _mm_set1_ps(min), hi = _mm_set1_ps(max);
+  size_t kept = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128 a = _mm_loadu_ps(values + i);
+    __m128 b = _mm_loadu_ps(values + i + 4);
+    int low = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(a, lo),
+                                         _mm_cmple_ps(a, hi)));
+    int high = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(b, lo),
+                                          _mm_cmple_ps(b, hi)));
+    keep[i / 8] = (uint8_t)(low | high << 4);
+    kept += (size_t)__builtin_popcount((unsigned)keep[i / 8]);
+  }
+  return kept + ht_select_scalar(values + i, count - i, min, max,
+                                 keep + i / 8);
+}
+
+/*
+ * Varianty pro AVX2.
+ */
+__attribute__((target("avx2"))) static void
+ht_map_avx2(float *values, size_t count, float scale, float offset, float min,
+            float max) {
+  __m256 s = _mm256_set1_ps(scale), o = _mm256_set1_ps(offset);
+  __m256 lo = _mm256_set1_ps(min), hi = _mm256_set1_ps(max);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 x = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(values + i), s), o);
+    _mm256_storeu_ps(values + i, _mm256_min_ps(_mm256_max_ps(x, lo), hi));
+  }
+  ht_map_scalar(values + i, count - i, scale, offset, min, max);
+}
+
+__attribute__((target("avx2"))) static double
+ht_sum_avx2(const float *values, size_t count) {
+  __m256d low = _mm256_setzero_pd(), high = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 x = _mm256_loadu_ps(values + i);
+    low = _mm256_add_pd(low, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+    high = _mm256_add_pd(high, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         ht_sum_scalar(values + i, count - i);
+}
+
+__attribute__((target("avx2"))) static float
+ht_min_avx2(const float *values, size_t count) {
+  __m256 acc = _mm256_set1_ps(INFINITY);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    acc = _mm256_min_ps(_mm256_loadu_ps(values + i), acc);
+  }
+  float lanes[8];
+  _mm256_storeu_ps(lanes, acc);
+  return ht_min_scalar(lanes, 8, ht_min_scalar(values + i, count - i,
+                                               INFINITY));
+}
+
+__attribute__((target("avx2"))) static float
+ht_max_avx2(const float *values, size_t count) {
+  __m256 acc = _mm256_set1_ps(-INFINITY);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    acc = _mm256_max_ps(_mm256_loadu_ps(values + i), acc);
+  }
+  float lanes[8];
+  _mm256_storeu_ps(lanes, acc);
+  return ht_max_scalar(lanes, 8, ht_max_scalar(values + i, count - i,
+                                               -INFINITY));
+}
+
+__attribute__((target("avx2"))) static size_t
+ht_select_avx2(const float *values, size_t count, float min, float max,
+               uint8_t *keep) {
+  __m256 lo = _mm256_set1_ps(min), hi = _mm256_set1_ps(max);
+  size_t kept = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 x = _mm256_loadu_ps(values + i);
+    __m256 in = _mm256_and_ps(_mm256_cmp_ps(x, lo, _CMP_GE_OQ),
+                              _mm256_cmp_ps(x, hi, _CMP_LE_OQ));
+    keep[i / 8] = (uint8_t)_mm256_movemask_ps(in);
+    kept += (size_t)__builtin_popcount((unsigned)keep[i / 8]);
+  }
+  return kept + ht_select_scalar(values + i, count - i, min, max,
+                                 keep + i / 8);
+}
+
+#endif
+
+/*
+ * Na každou hodnotu použije x * scale + offset a výsledek ořízne na
+ * interval <min, max>.
+ */
+void ht_floats_map(float *values, size_t count, float scale, float offset,
+                   float min, float max) {
+#if HT_SIMD_X86
+  switch (ht_simd_level()) {
+  case HT_SIMD_AVX2:
+    ht_map_avx2(values, count, scale, offset, min, max);
+    return;
+  case HT_SIMD_SSE2:
+    ht_map_sse2(values, count, scale, offset, min, max);
+    return;
+  }
+#endif
+  ht_map_scalar(values, count, scale, offset, min, max);
+}
+
+/*
+ * Součet hodnot (v double, aby se u velkých tabulek neztrácela přesnost).
+ */
+double ht_floats_sum(const float *values, size_t count) {
+#if HT_SIMD_X86
+  switch (ht_simd_level()) {
+  case HT_SIMD_AVX2:
+    return ht_sum_avx2(values, count);
+  case HT_SIMD_SSE2:
+    return ht_sum_sse2(values, count);
+  }
+#endif
+  return ht_sum_scalar(values, count);
+}
+
+/*
+ * Nejmenší hodnota (INFINITY pro prázdné pole nebo samé NaN).
+ */
+float ht_floats_min(const float *values, size_t count) {
+#if HT_SIMD_X86
+  switch (ht_simd_level()) {
+  case HT_SIMD_AVX2:
+    return ht_min_avx2(values, count);
+  case HT_SIMD_SSE2:
+    return ht_min_sse2(values, count);
+  }
+#endif
+  return ht_min_scalar(values, count, INFINITY);
+}
+
+/*
+ * Největší hodnota (-INFINITY pro prázdné pole nebo samé NaN).
+ */
+float ht_floats_max(const float *values, size_t count) {
+#if HT_SIMD_X86
+  switch (ht_simd_level()) {
+  case HT_SIMD_AVX2:
+    return ht_max_avx2(values, count);
+  case HT_SIMD_SSE2:
+    return ht_max_sse2(values, count);
+  }
+#endif
+  return ht_max_scalar(values, count, -INFINITY);
+}
+
+/*
+ * Označí hodnoty z intervalu <min, max> (NaN do něj nepatří) v bitové mapě
+ * keep o (count + 7) / 8 bajtech: bit i % 8 bajtu i / 8 patří hodnotě i.
+ * Vrací počet označených hodnot.
+ */
+size_t ht_floats_select(const float *values, size_t count, float min,
+                        float max, uint8_t *keep) {
+#if HT_SIMD_X86
+  switch (ht_simd_level()) {
+  case HT_SIMD_AVX2:
+    return ht_select_avx2(values, count, min, max, keep);
+  case HT_SIMD_SSE2:
+    return ht_select_sse2(values, count, min, max, keep);
+  }
+#endif
+  return ht_select_scalar(values, count, min, max, keep);
+}
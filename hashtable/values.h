@@ -0,0 +1,29 @@
+/*
+ * Hlavičkový soubor pro hromadné operace nad hustým polem hodnot.
+ */
+
+#ifndef IAL_HASHTABLE_VALUES_H
+#define IAL_HASHTABLE_VALUES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Úrovně vektorových instrukcí. Operace zvolí za běhu nejvyšší úroveň,
+ * kterou procesor podporuje, nejvýše však HT_SIMD_LEVEL (testy ji snižují,
+ * aby ověřily všechny varianty). Mimo x86 se používá jen HT_SIMD_SCALAR.
+ */
+enum { HT_SIMD_SCALAR, HT_SIMD_SSE2, HT_SIMD_AVX2 };
+
+extern int HT_SIMD_LEVEL;
+
+int ht_simd_level(void);
+void ht_floats_map(float *values, size_t count, float scale, float offset,
+                   float min, float max);
+double ht_floats_sum(const float *values, size_t count);
+float ht_floats_min(const float *values, size_t count);
+float ht_floats_max(const float *values, size_t count);
+size_t ht_floats_select(const float *values, size_t count, float min,
+                        float max, uint8_t *keep);
+
+#endif